@@ -0,0 +1,96 @@
+#include "benchmark/benchmark.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/InstCombine/InstCombine.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// The IR files named on the command line, after the benchmark flags. When
+// there are none, a synthetic corpus is used instead.
+static std::vector<std::unique_ptr<MemoryBuffer>> Corpus;
+
+// Produce a module with many functions in which a few instructions fold over
+// several iterations, surrounded by code that instcombine leaves alone, as is
+// typical once the earlier passes of the pipeline have run.
+static std::unique_ptr<MemoryBuffer> makeSyntheticModule() {
+  const unsigned NumFunctions = 500;
+  const unsigned NumCalls = 64;
+  std::string IR;
+  raw_string_ostream OS(IR);
+  OS << "declare i32 @g(i32)\n";
+  for (unsigned F = 0; F != NumFunctions; ++F) {
+    OS << "define i32 @f" << F << "(i32 %x, i32 %y) {\n"
+       << "  %a = add i32 %x, " << F << "\n"
+       << "  %b = sub i32 %a, " << F << "\n"
+       << "  %c = shl i32 %b, 1\n"
+       << "  %d = lshr i32 %c, 1\n";
+    for (unsigned C = 0; C != NumCalls; ++C)
+      OS << "  %c" << C << " = call i32 @g(i32 %y)\n";
+    OS << "  %r = call i32 @g(i32 %d)\n"
+       << "  ret i32 %r\n"
+       << "}\n";
+  }
+  return MemoryBuffer::getMemBufferCopy(OS.str(), "synthetic.ll");
+}
+
+static void setIncrementalWorklist(bool Enable) {
+  auto *Opt = static_cast<cl::opt<bool> *>(
+      cl::getRegisteredOptions()["instcombine-incremental-worklist"]);
+  Opt->setValue(Enable);
+}
+
+static void BM_InstCombine(benchmark::State &State) {
+  setIncrementalWorklist(State.range(0));
+  for (auto _ : State) {
+    State.PauseTiming();
+    LLVMContext Ctx;
+    std::vector<std::unique_ptr<Module>> Modules;
+    for (const auto &Buffer : Corpus) {
+      SMDiagnostic Err;
+      Modules.push_back(parseIR(Buffer->getMemBufferRef(), Err, Ctx));
+      if (!Modules.back()) {
+        Err.print("InstCombine", errs());
+        State.SkipWithError("cannot parse the corpus");
+        return;
+      }
+    }
+    State.ResumeTiming();
+
+    for (auto &M : Modules) {
+      legacy::FunctionPassManager FPM(M.get());
+      FPM.add(createInstructionCombiningPass());
+      FPM.doInitialization();
+      for (Function &F : *M)
+        FPM.run(F);
+      FPM.doFinalization();
+    }
+  }
+  setIncrementalWorklist(false);
+}
+// Arg(0) seeds every iteration with the whole function, Arg(1) seeds the
+// iterations after the first with the instructions that changed.
+BENCHMARK(BM_InstCombine)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  for (int I = 1; I < argc; ++I) {
+    auto BufferOrErr = MemoryBuffer::getFile(argv[I]);
+    if (!BufferOrErr) {
+      errs() << argv[I] << ": " << BufferOrErr.getError().message() << "\n";
+      return 1;
+    }
+    Corpus.push_back(std::move(*BufferOrErr));
+  }
+  if (Corpus.empty())
+    Corpus.push_back(makeSyntheticModule());
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,90 @@
+#include "benchmark/benchmark.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ShardedStringPool.h"
+#include "llvm/Support/ThreadPool.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Produce a debug-name-like workload: a few thousand distinct C++ names that
+// each show up in many compile units, mixed with mangled linkage names and
+// file paths. Most lookups hit a string that is already in the pool, which is
+// what dominates when linking debug info.
+static const std::vector<std::string> &getWorkload() {
+  static std::vector<std::string> Workload = [] {
+    const unsigned NumDistinct = 50000;
+    const unsigned NumNames = 2000000;
+    std::vector<std::string> Distinct;
+    Distinct.reserve(NumDistinct);
+    for (unsigned I = 0; I != NumDistinct; ++I) {
+      std::string Id = std::to_string(I);
+      switch (I % 4) {
+      case 0:
+        Distinct.push_back("_ZN4llvm9namespace" + Id + "8functionEv");
+        break;
+      case 1:
+        Distinct.push_back("function" + Id);
+        break;
+      case 2:
+        Distinct.push_back("/src/project/lib/dir" + std::to_string(I % 97) +
+                           "/file" + Id + ".cpp");
+        break;
+      default:
+        Distinct.push_back("Var" + Id);
+        break;
+      }
+    }
+    std::vector<std::string> Names;
+    Names.reserve(NumNames);
+    // A cheap LCG keeps the sequence reproducible across runs.
+    uint64_t State = 42;
+    for (unsigned I = 0; I != NumNames; ++I) {
+      State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+      Names.push_back(Distinct[(State >> 33) % NumDistinct]);
+    }
+    return Names;
+  }();
+  return Workload;
+}
+
+static void BM_StringMapSerial(benchmark::State &State) {
+  const auto &Names = getWorkload();
+  for (auto _ : State) {
+    StringMap<uint64_t, BumpPtrAllocator> Map;
+    for (const std::string &Name : Names)
+      Map.insert({Name, 0});
+    benchmark::DoNotOptimize(Map.size());
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_StringMapSerial)->Unit(benchmark::kMillisecond);
+
+static void BM_ShardedStringPool(benchmark::State &State) {
+  const auto &Names = getWorkload();
+  unsigned NumThreads = State.range(0);
+  for (auto _ : State) {
+    ShardedStringPool Pool;
+    ThreadPool Threads(NumThreads);
+    size_t Chunk = (Names.size() + NumThreads - 1) / NumThreads;
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Threads.async([&, T] {
+        size_t End = std::min(Names.size(), (T + 1) * Chunk);
+        for (size_t I = T * Chunk; I < End; ++I)
+          Pool.intern(Names[I]);
+      });
+    Threads.wait();
+    Pool.finalize();
+    benchmark::DoNotOptimize(Pool.getSize());
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_ShardedStringPool)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+#include "benchmark/benchmark.h"
+#include "llvm/DebugInfo/CodeView/AppendingTypeTableBuilder.h"
+#include "llvm/DebugInfo/CodeView/GlobalTypeTableBuilder.h"
+#include "llvm/DebugInfo/CodeView/TypeHashing.h"
+#include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
+#include "llvm/Support/BinaryStreamReader.h"
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace llvm::codeview;
+
+namespace {
+struct Object {
+  std::vector<uint8_t> Bytes;
+  CVTypeArray Types;
+};
+} // end anonymous namespace
+
+// Produce the type streams of many objects, as emitted for a large project:
+// every object repeats the types of the headers it includes, which are mostly
+// shared with other objects, and adds a few types of its own.
+static const std::vector<Object> &getObjects() {
+  static std::vector<Object> Objects = [] {
+    const unsigned NumObjects = 400;
+    const unsigned NumHeaders = 64;
+    const unsigned HeadersPerObject = 16;
+    const unsigned TypesPerHeader = 100;
+    const unsigned OwnTypes = 200;
+    std::vector<Object> Result(NumObjects);
+    // A cheap LCG keeps the sequence reproducible across runs.
+    uint64_t State = 42;
+    for (unsigned O = 0; O != NumObjects; ++O) {
+      BumpPtrAllocator Alloc;
+      AppendingTypeTableBuilder Builder(Alloc);
+      auto AddStruct = [&](const std::string &Name, TypeIndex Member) {
+        ArgListRecord AL(TypeRecordKind::ArgList);
+        AL.ArgIndices.push_back(Member);
+        AL.ArgIndices.push_back(TypeIndex(SimpleTypeKind::Int32));
+        TypeIndex Args = Builder.writeLeafType(AL);
+        ProcedureRecord PR(TypeRecordKind::Procedure);
+        PR.ArgumentList = Args;
+        PR.CallConv = CallingConvention::NearC;
+        PR.Options = FunctionOptions::None;
+        PR.ParameterCount = 2;
+        PR.ReturnType = TypeIndex(SimpleTypeKind::Void);
+        Builder.writeLeafType(PR);
+        std::string UniqueName = "." + Name;
+        ClassRecord CR(TypeRecordKind::Struct, 0, ClassOptions::None,
+                       TypeIndex(), TypeIndex(), TypeIndex(), 8, Name,
+                       UniqueName);
+        TypeIndex Class = Builder.writeLeafType(CR);
+        PointerRecord Ptr(TypeRecordKind::Pointer);
+        Ptr.setAttrs(PointerKind::Near64, PointerMode::Pointer,
+                     PointerOptions::None, 8);
+        Ptr.ReferentType = Class;
+        return Builder.writeLeafType(Ptr);
+      };
+      for (unsigned H = 0; H != HeadersPerObject; ++H) {
+        State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned Header = (State >> 33) % NumHeaders;
+        TypeIndex Prev(SimpleTypeKind::Int64Quad);
+        for (unsigned T = 0; T != TypesPerHeader; ++T)
+          Prev = AddStruct("h" + std::to_string(Header) + "_" +
+                               std::to_string(T),
+                           Prev);
+      }
+      TypeIndex Prev(SimpleTypeKind::Int64Quad);
+      for (unsigned T = 0; T != OwnTypes; ++T)
+        Prev = AddStruct("o" + std::to_string(O) + "_" + std::to_string(T),
+                         Prev);
+
+      Object &Obj = Result[O];
+      for (ArrayRef<uint8_t> Record : Builder.records())
+        Obj.Bytes.insert(Obj.Bytes.end(), Record.begin(), Record.end());
+      BinaryStreamReader Reader(Obj.Bytes, support::little);
+      cantFail(Reader.readArray(Obj.Types, Obj.Bytes.size()));
+    }
+    return Result;
+  }();
+  return Objects;
+}
+
+static void BM_MergeSerial(benchmark::State &State) {
+  const auto &Objects = getObjects();
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    GlobalTypeTableBuilder Dest(Alloc);
+    for (const Object &Obj : Objects) {
+      std::vector<GloballyHashedType> Hashes =
+          GloballyHashedType::hashTypes(Obj.Types);
+      SmallVector<TypeIndex, 0> Map;
+      Optional<uint32_t> PCHSignature;
+      cantFail(mergeTypeRecords(Dest, Map, Obj.Types, Hashes, PCHSignature));
+    }
+    benchmark::DoNotOptimize(Dest.size());
+  }
+}
+BENCHMARK(BM_MergeSerial)->Unit(benchmark::kMillisecond);
+
+static void BM_MergeParallel(benchmark::State &State) {
+  const auto &Objects = getObjects();
+  std::vector<CVTypeArray> Sources;
+  for (const Object &Obj : Objects)
+    Sources.push_back(Obj.Types);
+  for (auto _ : State) {
+    BumpPtrAllocator Alloc;
+    GlobalTypeTableBuilder Dest(Alloc);
+    std::vector<SmallVector<TypeIndex, 0>> Maps;
+    cantFail(mergeTypeRecordsInParallel(Dest, Maps, Sources, State.range(0)));
+    benchmark::DoNotOptimize(Dest.size());
+  }
+}
+BENCHMARK(BM_MergeParallel)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -1323,6 +1323,11 @@ private:
     /// subexpression.
     bool hasOperand(const SCEV *S, ScalarEvolution *SE) const;
 
+    /// Append the computable expressions held by this info, i.e. the max
+    /// count and every exact exit count, to \p Exprs.
+    void getExprs(SmallVectorImpl<const SCEV *> &Exprs,
+                  ScalarEvolution *SE) const;
+
     /// Invalidate this result and free associated memory.
     void clear();
   };
@@ -1335,6 +1340,13 @@ private:
   /// function as they are computed.
   DenseMap<const Loop *, BackedgeTakenInfo> PredicatedBackedgeTakenCounts;
 
+  /// Maps every subexpression of a cached backedge-taken count to the loops
+  /// whose count refers to it; the flag is set for predicated counts.  This
+  /// lets forgetMemoizedResults drop the affected counts without scanning all
+  /// loops.  Entries may be stale and are re-checked before use.
+  DenseMap<const SCEV *, SmallVector<PointerIntPair<const Loop *, 1, bool>, 2>>
+      BECountUsers;
+
   /// This map contains entries for all of the PHI instructions that we
   /// attempt to compute constant evolutions for.  This allows us to avoid
   /// potentially expensive recomputation of these properties.  An instruction
@@ -1849,6 +1861,11 @@ private:
   /// accordingly.
   void addToLoopUseLists(const SCEV *S);
 
+  /// Record \p BTI, the (predicated if \p Predicated) backedge-taken count
+  /// cached for \p L, in BECountUsers.
+  void addToBECountUsers(const Loop *L, const BackedgeTakenInfo &BTI,
+                         bool Predicated);
+
   /// Try to match the pattern generated by getURemExpr(A, B). If successful,
   /// Assign A and B to LHS and RHS, respectively.
   bool matchURem(const SCEV *Expr, const SCEV *&LHS, const SCEV *&RHS);
@@ -14,6 +14,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/CodeView/TypeRecord.h"
 #include "llvm/Support/Error.h"
+#include <vector>
 
 namespace llvm {
 namespace codeview {
@@ -104,6 +105,30 @@ Error mergeIdRecords(GlobalTypeTableBuilder &Dest, ArrayRef<TypeIndex> Types,
                      const CVTypeArray &Ids,
                      ArrayRef<GloballyHashedType> Hashes);
 
+/// Merge the type records of several independent sources, such as the type
+/// streams of different object files, into \p Dest. The result is the same as
+/// hashing each source with GloballyHashedType::hashTypes() and merging the
+/// sources in order with mergeTypeRecords() above.
+///
+/// The work is split in two phases. First, the sources are hashed on up to
+/// \p NumThreads threads. Then the records are inserted into a concurrent
+/// table that keeps the earliest occurrence of every hash in source order.
+/// Only copying the unique records into \p Dest is done serially, in that
+/// order, so the assigned type indices do not depend on the thread count.
+///
+/// Every source must contain type records only; id records belong in the IPI
+/// stream and are merged with mergeIdRecords(). Its records may only refer
+/// to records before them, and it must not refer to a precompiled header or
+/// type server. Sources that break these rules are rejected before \p Dest
+/// is modified.
+///
+/// \param SourceToDest Receives one map per source, indexed like the
+/// SourceToDest argument of mergeTypeRecords().
+Error mergeTypeRecordsInParallel(
+    GlobalTypeTableBuilder &Dest,
+    std::vector<SmallVector<TypeIndex, 0>> &SourceToDest,
+    ArrayRef<CVTypeArray> Sources, unsigned NumThreads);
+
 } // end namespace codeview
 } // end namespace llvm
 
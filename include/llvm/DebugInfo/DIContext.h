@@ -168,6 +168,8 @@ struct DIDumpOptions {
   bool SummarizeTypes = false;
   bool Verbose = false;
   bool DisplayRawContents = false;
+  /// Number of threads that may be used to extract units up front.
+  unsigned NumThreads = 1;
 
   /// Return default option set for printing a single DIE without children.
   static DIDumpOptions getForSingleDIE() {
@@ -189,7 +191,8 @@ class DIContext {
 public:
   enum DIContextKind {
     CK_DWARF,
-    CK_PDB
+    CK_PDB,
+    CK_SymbolizerCache
   };
 
   DIContext(DIContextKind K) : Kind(K) {}
@@ -187,6 +187,13 @@ public:
     return unit_iterator_range(DWOUnits.begin(), DWOUnits.end());
   }
 
+  /// Parse all normal units and extract their DIEs using up to \p NumThreads
+  /// threads. Afterwards, read-only queries on the DIEs of these units may be
+  /// issued from several threads; context-level tables such as line tables,
+  /// .debug_loc and .debug_aranges are still parsed lazily and are not
+  /// thread-safe.
+  void extractNormalUnitDIEs(unsigned NumThreads);
+
   /// Get the number of compile units in this context.
   unsigned getNumCompileUnits() {
     parseNormalUnits();
@@ -320,6 +327,12 @@ public:
   /// given address where applicable.
   DIEsForAddress getDIEsForAddress(uint64_t Address);
 
+  /// Add the DIEs named \p Name to \p Dies, which is left sorted by offset
+  /// and without duplicates. The accelerator tables are consulted if the
+  /// object has any; otherwise the units are scanned for the DIEs a name index
+  /// would list.
+  void getDIEsForName(StringRef Name, SmallVectorImpl<DWARFDie> &Dies);
+
   DILineInfo getLineInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
   DILineInfoTable getLineInfoForAddressRange(uint64_t Address, uint64_t Size,
@@ -0,0 +1,44 @@
+//===- DWARFDebugNamesBuilder.h ---------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_DWARFDEBUGNAMESBUILDER_H
+#define LLVM_DEBUGINFO_DWARFDEBUGNAMESBUILDER_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+
+namespace llvm {
+
+class DWARFContext;
+class DWARFDie;
+class raw_ostream;
+
+/// Returns the names under which a DWARF v5 name index is expected to list
+/// \p Die, or an empty vector if the DIE should not be indexed at all.
+///
+/// This follows the wording of the DWARF v5 specification (section 6.1.1.1),
+/// except that all tags are considered unless known not to be globally
+/// visible.
+SmallVector<StringRef, 2> getDebugNamesIndexNames(const DWARFDie &Die);
+
+/// Builds a DWARF v5 .debug_names section covering the compile units in the
+/// .debug_info section of \p DICtx and writes its contents to \p OS.
+///
+/// The DIEs of different compile units are collected on up to \p NumThreads
+/// threads; the output does not depend on the number of threads. The index
+/// can only refer to names stored in .debug_str, so names using the inline
+/// DW_FORM_string form are left out, and their number is returned in
+/// \p NumSkipped.
+Error writeDebugNames(DWARFContext &DICtx, raw_ostream &OS,
+                      unsigned NumThreads, unsigned &NumSkipped);
+
+} // end namespace llvm
+
+#endif // LLVM_DEBUGINFO_DWARFDEBUGNAMESBUILDER_H
@@ -26,11 +26,13 @@
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
 #include "llvm/Support/DataExtractor.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -140,6 +142,11 @@ public:
   /// verifier to process unit separately.
   DWARFUnit *addUnit(std::unique_ptr<DWARFUnit> Unit);
 
+  /// Fully extract the DIEs of every unit, using up to \p NumThreads threads.
+  /// Each unit resolves its abbreviation set once and is then extracted
+  /// independently of the others.
+  void extractDIEs(unsigned NumThreads);
+
   /// Returns number of all units held by this instance.
   unsigned getNumUnits() const { return size(); }
   /// Returns number of units from all .debug_info[.dwo] sections.
@@ -217,10 +224,21 @@ class DWARFUnit {
   /// A table of range lists (DWARF v5 and later).
   Optional<DWARFDebugRnglistTable> RngListTable;
 
-  mutable const DWARFAbbreviationDeclarationSet *Abbrevs;
+  mutable std::atomic<const DWARFAbbreviationDeclarationSet *> Abbrevs;
   llvm::Optional<SectionedAddress> BaseAddr;
   /// The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntry> DieArray;
+  /// Set once DieArray holds the unit DIE, respectively all DIEs, so that
+  /// readers on other threads can skip taking ExtractionMutex.
+  std::atomic<bool> UnitDIEExtracted;
+  std::atomic<bool> AllDIEsExtracted;
+  /// DIE vectors that held only the unit DIE and were replaced by a full
+  /// extraction. They are kept until clearDIEs() so that unit DIEs handed
+  /// out before the full extraction stay valid.
+  std::vector<std::vector<DWARFDebugInfoEntry>> RetiredDieArrays;
+  /// Serializes DIE extraction and the lazy computation of BaseAddr. It is
+  /// recursive because extraction reads the unit DIE through getUnitDIE().
+  std::recursive_mutex ExtractionMutex;
 
   /// Map from range's start address to end address and corresponding DIE.
   /// IntervalMap does not support range removal, as a result, we use the
@@ -378,12 +396,7 @@ public:
 
   llvm::Optional<SectionedAddress> getBaseAddress();
 
-  DWARFDie getUnitDIE(bool ExtractUnitDIEOnly = true) {
-    extractDIEsIfNeeded(ExtractUnitDIEOnly);
-    if (DieArray.empty())
-      return DWARFDie();
-    return DWARFDie(this, &DieArray[0]);
-  }
+  DWARFDie getUnitDIE(bool ExtractUnitDIEOnly = true);
 
   const char *getCompilationDir();
   Optional<uint64_t> getDWOId() {
@@ -493,13 +506,17 @@ private:
 
   /// extractDIEsIfNeeded - Parses a compile unit and indexes its DIEs if it
   /// hasn't already been done. Returns the number of DIEs parsed at this call.
+  /// Safe to call from several threads. A full extraction after the unit DIE
+  /// alone was extracted builds a new DIE vector and retires the old one
+  /// rather than growing it in place.
   size_t extractDIEsIfNeeded(bool CUDieOnly);
 
   /// extractDIEsToVector - Appends all parsed DIEs to a vector.
   void extractDIEsToVector(bool AppendCUDie, bool AppendNonCUDIEs,
                            std::vector<DWARFDebugInfoEntry> &DIEs) const;
 
-  /// clearDIEs - Clear parsed DIEs to keep memory usage low.
+  /// clearDIEs - Clear parsed DIEs to keep memory usage low. Must not race
+  /// with any other access to the unit.
   void clearDIEs(bool KeepCUDie);
 
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
@@ -19,6 +19,7 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <vector>
 
@@ -102,7 +103,15 @@ private:
   // entire file is mapped anyway.  Because of that, the user must supply the
   // allocator to allocate broken records from.
   BumpPtrAllocator &Allocator;
-  DenseMap<uint32_t, std::vector<CacheEntry>> CacheMap;
+
+  // Buffers for reads that crossed a discontiguous block boundary, keyed by
+  // stream offset. The map is ordered so that a read which falls inside an
+  // earlier buffer can be served from it without visiting every entry.
+  std::map<uint32_t, std::vector<CacheEntry>> CacheMap;
+
+  // The size of the largest buffer in CacheMap, which bounds how far before a
+  // read a buffer containing it can start.
+  uint32_t MaxCacheEntrySize = 0;
 };
 
 class WritableMappedBlockStream : public WritableBinaryStream {
@@ -88,7 +88,13 @@ private:
   FixedStreamArray<codeview::TypeIndexOffset> TypeIndexOffsets;
   HashTable<support::ulittle32_t> HashAdjusters;
 
-  std::vector<std::vector<codeview::TypeIndex>> HashMap;
+  /// Type indices grouped by hash bucket, built on first lookup from the hash
+  /// value buffer alone. The indices of bucket B are
+  /// HashBucketEntries[HashBucketStarts[B] .. HashBucketStarts[B + 1]).
+  std::vector<uint32_t> HashBucketStarts;
+  std::vector<codeview::TypeIndex> HashBucketEntries;
+
+  ArrayRef<codeview::TypeIndex> getHashBucket(uint32_t Bucket) const;
 
   const TpiStreamHeader *Header;
 };
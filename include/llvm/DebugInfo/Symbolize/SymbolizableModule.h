@@ -13,8 +13,10 @@
 #ifndef LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZABLEMODULE_H
 #define LLVM_DEBUGINFO_SYMBOLIZE_SYMBOLIZABLEMODULE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include <cstdint>
+#include <vector>
 
 namespace llvm {
 namespace symbolize {
@@ -33,6 +35,28 @@ public:
                                               bool UseSymbolTable) const = 0;
   virtual DIGlobal symbolizeData(uint64_t ModuleOffset) const = 0;
 
+  /// Symbolizes every address in \p ModuleOffsets and returns the results in
+  /// the same order. Implementations are free to resolve the addresses in
+  /// a different order or on up to \p NumThreads threads.
+  virtual std::vector<DILineInfo>
+  symbolizeCodeBatch(ArrayRef<uint64_t> ModuleOffsets, FunctionNameKind FNKind,
+                     bool UseSymbolTable, unsigned NumThreads) const {
+    std::vector<DILineInfo> Result;
+    for (uint64_t ModuleOffset : ModuleOffsets)
+      Result.push_back(symbolizeCode(ModuleOffset, FNKind, UseSymbolTable));
+    return Result;
+  }
+  virtual std::vector<DIInliningInfo>
+  symbolizeInlinedCodeBatch(ArrayRef<uint64_t> ModuleOffsets,
+                            FunctionNameKind FNKind, bool UseSymbolTable,
+                            unsigned NumThreads) const {
+    std::vector<DIInliningInfo> Result;
+    for (uint64_t ModuleOffset : ModuleOffsets)
+      Result.push_back(
+          symbolizeInlinedCode(ModuleOffset, FNKind, UseSymbolTable));
+    return Result;
+  }
+
   // Return true if this is a 32-bit x86 PE COFF module.
   virtual bool isWin32Module() const = 0;
 
@@ -33,6 +33,8 @@ using namespace object;
 
 using FunctionNameKind = DILineInfoSpecifier::FunctionNameKind;
 
+class SymbolizerCacheContext;
+
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -42,6 +44,9 @@ public:
     bool RelativeAddresses : 1;
     std::string DefaultArch;
     std::vector<std::string> DsymHints;
+    /// If not empty, address-to-line tables of binaries with a build ID are
+    /// stored in and loaded from this directory instead of parsing DWARF.
+    std::string CacheDirectory;
 
     Options(FunctionNameKind PrintFunctions = FunctionNameKind::LinkageName,
             bool UseSymbolTable = true, bool Demangle = true,
@@ -51,6 +56,20 @@ public:
           DefaultArch(std::move(DefaultArch)) {}
   };
 
+  /// Counts how modules were loaded when Options::CacheDirectory is set. The
+  /// caches are written, and the counts of the modules complete, on flush().
+  struct CacheStats {
+    /// Modules whose cache file was read.
+    uint64_t Hits = 0;
+    /// Compile units whose debug info had to be parsed from DWARF and was
+    /// added to a cache.
+    uint64_t Misses = 0;
+    /// Cache files that were written after a miss.
+    uint64_t Writes = 0;
+    /// Cache files that were rejected or could not be written.
+    uint64_t Errors = 0;
+  };
+
   LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
 
   ~LLVMSymbolizer() {
@@ -65,8 +84,23 @@ public:
                                                 StringRef DWPName = "");
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
                                    uint64_t ModuleOffset);
+
+  /// Symbolizes all of \p ModuleOffsets in \p ModuleName and returns the
+  /// results in input order. Duplicate addresses are resolved once, and the
+  /// distinct addresses are resolved in increasing address order on up to
+  /// \p NumThreads threads.
+  Expected<std::vector<DILineInfo>>
+  symbolizeCodeBatch(const std::string &ModuleName,
+                     ArrayRef<uint64_t> ModuleOffsets, StringRef DWPName = "",
+                     unsigned NumThreads = 1);
+  Expected<std::vector<DIInliningInfo>>
+  symbolizeInlinedCodeBatch(const std::string &ModuleName,
+                            ArrayRef<uint64_t> ModuleOffsets,
+                            StringRef DWPName = "", unsigned NumThreads = 1);
   void flush();
 
+  const CacheStats &getCacheStats() const { return Stats; }
+
   static std::string
   DemangleName(const std::string &Name,
                const SymbolizableModule *DbiModuleDescriptor);
@@ -114,7 +148,18 @@ private:
   std::map<std::pair<std::string, std::string>, std::unique_ptr<ObjectFile>>
       ObjectForUBPathAndArch;
 
+  /// Creates a DIContext for \p DbgObj, going through the cache in
+  /// Opts.CacheDirectory when possible.
+  std::unique_ptr<DIContext> createDWARFContext(const ObjectFile &Obj,
+                                                const ObjectFile &DbgObj,
+                                                StringRef DWPName);
+
+  /// The caches owned by Modules, which are written on flush() if compile
+  /// units were added to them.
+  std::vector<SymbolizerCacheContext *> CacheContexts;
+
   Options Opts;
+  CacheStats Stats;
 };
 
 } // end namespace symbolize
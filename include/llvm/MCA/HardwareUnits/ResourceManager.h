@@ -397,6 +397,13 @@ public:
 
   void cycleEvent(SmallVectorImpl<ResourceRef> &ResourcesFreed);
 
+  // Returns the number of cycles before the next busy resource is released.
+  unsigned getNumIdleCycles() const;
+
+  // Advance the busy resources by a number of cycles in which none of them is
+  // released.
+  void skipIdleCycles(unsigned Cycles);
+
 #ifndef NDEBUG
   void dump() const {
     for (const std::unique_ptr<ResourceState> &Resource : Resources)
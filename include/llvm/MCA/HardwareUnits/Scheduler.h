@@ -185,6 +185,17 @@ public:
                   SmallVectorImpl<InstRef> &Ready,
                   SmallVectorImpl<InstRef> &Executed);
 
+  /// Returns the number of cycles that can elapse before an instruction
+  /// finishes executing, an instruction's operands become available, or a
+  /// processor resource is released.
+  unsigned getNumIdleCycles() const;
+
+  /// Advance the state of the scheduler by \p Cycles cycles. This is
+  /// equivalent to calling cycleEvent() \p Cycles times, when it is known
+  /// that none of those calls would change the state of an instruction or
+  /// release a resource; the cost is the same as a single call.
+  void skipIdleCycles(unsigned Cycles);
+
   /// Convert a resource mask into a valid llvm processor resource identifier.
   unsigned getResourceID(uint64_t Mask) const {
     return Resources->resolveResourceMask(Mask);
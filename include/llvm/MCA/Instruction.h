@@ -191,6 +191,7 @@ public:
 
   // On every cycle, update CyclesLeft and notify dependent users.
   void cycleEvent();
+  void skipIdleCycles(unsigned Cycles);
   void onInstructionIssued();
 
 #ifndef NDEBUG
@@ -248,6 +249,11 @@ public:
 
   void cycleEvent();
   void writeStartEvent(unsigned Cycles);
+
+  // Returns the number of cycles before this read becomes ready, if that is
+  // known, or the maximum unsigned value otherwise.
+  unsigned getCyclesToReady() const;
+  void skipIdleCycles(unsigned Cycles);
   void setDependentWrites(unsigned Writes) {
     DependentWrites = Writes;
     IsReady = !Writes;
@@ -470,6 +476,14 @@ public:
   }
 
   void cycleEvent();
+
+  // Returns the number of calls to cycleEvent() that are known not to change
+  // the stage of this instruction.
+  unsigned getNumIdleCycles() const;
+
+  // Equivalent to calling cycleEvent() a number of times that is no more than
+  // getNumIdleCycles().
+  void skipIdleCycles(unsigned Cycles);
 };
 
 /// An InstRef contains both a SourceMgr index and Instruction pair.  The index
@@ -50,17 +50,49 @@ class HWEventListener;
 /// Internally, the Pipeline collects statistical information in the form of
 /// histograms. For example, it tracks how the dispatch group size changes
 /// over time.
+///
+/// Long latency instructions often leave the pipeline with nothing to do for
+/// many cycles. After a cycle in which no instruction changed state and no
+/// resource was released, the following cycles only differ from it in the
+/// timers of the stages, until one of those timers expires. The Pipeline asks
+/// the stages how many cycles that is, and skips them: the stages advance
+/// their timers in one step, and listeners are notified of each skipped cycle
+/// (and of the stall that is repeated in it) as if it had been simulated.
 class Pipeline {
   Pipeline(const Pipeline &P) = delete;
   Pipeline &operator=(const Pipeline &P) = delete;
 
+  /// Records whether any instruction or resource changed state in a cycle.
+  class ActivityMonitor final : public HWEventListener {
+    bool Active = false;
+
+  public:
+    bool isActive() const { return Active; }
+    void reset() { Active = false; }
+
+    void onEvent(const HWInstructionEvent &Event) override { Active = true; }
+    void onResourceAvailable(const ResourceRef &RRef) override {
+      Active = true;
+    }
+    void onReservedBuffers(const InstRef &Inst,
+                           ArrayRef<unsigned> Buffers) override {
+      Active = true;
+    }
+    void onReleasedBuffers(const InstRef &Inst,
+                           ArrayRef<unsigned> Buffers) override {
+      Active = true;
+    }
+  };
+
   /// An ordered list of stages that define this instruction pipeline.
   SmallVector<std::unique_ptr<Stage>, 8> Stages;
   std::set<HWEventListener *> Listeners;
+  ActivityMonitor Activity;
   unsigned Cycles;
 
   Error runCycle();
   bool hasWorkToProcess();
+  void skipIdleCycles();
   void notifyCycleBegin();
   void notifyCycleEnd();
 
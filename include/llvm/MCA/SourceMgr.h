@@ -17,6 +17,7 @@
 #define LLVM_MCA_SOURCEMGR_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include <algorithm>
 
 namespace llvm {
 namespace mca {
@@ -29,7 +30,7 @@ class SourceMgr {
   using UniqueInst = std::unique_ptr<Instruction>;
   ArrayRef<UniqueInst> Sequence;
   unsigned Current;
-  const unsigned Iterations;
+  unsigned Iterations;
   static const unsigned DefaultIterations = 100;
 
 public:
@@ -41,6 +42,13 @@ public:
   bool hasNext() const { return Current < (Iterations * Sequence.size()); }
   void updateNext() { ++Current; }
 
+  // Stop at the end of the iteration that is being fetched, instead of after
+  // the number of iterations requested.
+  void stopAfterCurrentIteration() {
+    unsigned Fetched = (Current + Sequence.size() - 1) / Sequence.size();
+    Iterations = std::min(Iterations, Fetched);
+  }
+
   SourceRef peekNext() const {
     assert(hasNext() && "Already at end of sequence!");
     return SourceRef(Current, *Sequence[Current % Sequence.size()]);
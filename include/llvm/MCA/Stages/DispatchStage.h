@@ -83,6 +83,11 @@ public:
   Error cycleStart() override;
   Error execute(InstRef &IR) override;
 
+  // An instruction that is carried over is dispatched on the next cycle.
+  unsigned getNumIdleCycles() const override {
+    return CarryOver ? 0 : std::numeric_limits<unsigned>::max();
+  }
+
 #ifndef NDEBUG
   void dump() const;
 #endif
@@ -44,6 +44,9 @@ public:
   Error execute(InstRef &IR) override;
   Error cycleStart() override;
   Error cycleEnd() override;
+  unsigned getNumIdleCycles() const override {
+    return std::numeric_limits<unsigned>::max();
+  }
 };
 
 } // namespace mca
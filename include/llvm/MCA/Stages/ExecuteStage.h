@@ -63,6 +63,13 @@ public:
   Error cycleStart() override;
   Error execute(InstRef &IR) override;
 
+  unsigned getNumIdleCycles() const override {
+    return HWS.getNumIdleCycles();
+  }
+  void skipIdleCycles(unsigned Cycles) override {
+    HWS.skipIdleCycles(Cycles);
+  }
+
   void notifyInstructionIssued(
       const InstRef &IR,
       MutableArrayRef<std::pair<ResourceRef, ResourceCycles>> Used) const;
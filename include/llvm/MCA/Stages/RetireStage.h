@@ -39,6 +39,7 @@ public:
   bool hasWorkToComplete() const override { return !RCU.isEmpty(); }
   Error cycleStart() override;
   Error execute(InstRef &IR) override;
+  unsigned getNumIdleCycles() const override;
   void notifyInstructionRetired(const InstRef &IR) const;
 };
 
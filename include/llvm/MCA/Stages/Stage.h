@@ -18,6 +18,7 @@
 
 #include "llvm/MCA/HWEventListener.h"
 #include "llvm/Support/Error.h"
+#include <limits>
 #include <set>
 
 namespace llvm {
@@ -52,6 +53,17 @@ public:
   /// Called once at the end of each cycle.
   virtual Error cycleEnd() { return ErrorSuccess(); }
 
+  /// Returns the number of cycles that can elapse before this stage changes
+  /// state on its own, assuming that no other stage makes progress in the
+  /// meantime. Stages that don't depend on the passing of time return the
+  /// maximum unsigned value; stages that can't tell return zero.
+  virtual unsigned getNumIdleCycles() const { return 0; }
+
+  /// Advance the internal timers of this stage by \p Cycles cycles, where
+  /// \p Cycles is no more than getNumIdleCycles(). This replaces the calls to
+  /// cycleStart() and cycleEnd() for cycles in which nothing happens.
+  virtual void skipIdleCycles(unsigned Cycles) {}
+
   /// The primary action that this stage performs on instruction IR.
   virtual Error execute(InstRef &IR) = 0;
 
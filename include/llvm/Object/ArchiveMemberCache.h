@@ -0,0 +1,90 @@
+//===- ArchiveMemberCache.h - Parsed archive members ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares ArchiveMemberCache, which parses the members of an
+// archive ahead of time on a thread pool and hands out the parsed binaries.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_ARCHIVEMEMBERCACHE_H
+#define LLVM_OBJECT_ARCHIVEMEMBERCACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+#include <memory>
+
+namespace llvm {
+
+class LLVMContext;
+
+namespace object {
+
+/// Owns the parsed members of an archive.
+///
+/// Tools that visit every member of a large archive spend most of their time
+/// in createBinary, reading the headers and symbol tables of one member after
+/// the other. preload() does this for all members at once on a thread pool;
+/// the tool then walks the children in archive order as before and asks the
+/// cache for each binary, so its output does not change.
+///
+/// With a preload window, only the next few members are parsed ahead of the
+/// tool, so a tool that releases each member once it is done with it holds
+/// a bounded number of them however large the archive is.
+///
+/// The binaries are reference counted: one that is still in use stays valid
+/// after it has been released from the cache or the cache is destroyed. They
+/// refer to the archive's buffer, which must outlive them.
+class ArchiveMemberCache {
+public:
+  /// \p Context is used for bitcode members. Those are parsed on demand on
+  /// the calling thread, since an LLVMContext can't be shared between threads.
+  explicit ArchiveMemberCache(const Archive &A,
+                              LLVMContext *Context = nullptr);
+
+  /// A preload window that keeps the threads busy without holding much of a
+  /// large archive in memory.
+  static const size_t DefaultPreloadWindow = 256;
+
+  /// Parse the members of the archive on \p NumThreads threads, or on one
+  /// per hardware thread if it is 0. If \p Window is 0 all the members are
+  /// parsed now. Otherwise only the next \p Window members are, and
+  /// getMember() parses the following window when it is asked for a member
+  /// past them. Members that can't be read or parsed are left out;
+  /// getMember() reports the error when they are visited.
+  void preload(unsigned NumThreads = 0, size_t Window = 0);
+
+  /// Return the binary for \p C, parsing it now if it is not in the cache.
+  Expected<std::shared_ptr<Binary>> getMember(const Archive::Child &C);
+
+  /// Drop the cache's reference to the binary for \p C.
+  void release(const Archive::Child &C);
+
+  /// The number of parsed members currently held.
+  size_t size() const { return Members.size(); }
+
+private:
+  void preloadWindow();
+
+  const Archive &A;
+  LLVMContext *Context;
+  unsigned NumThreads = 0;
+  size_t Window = 0;
+  /// The first member that preload() has not parsed yet, if any.
+  Optional<Archive::Child> NextChild;
+  /// Parsed members, keyed by their offset in the archive.
+  DenseMap<uint64_t, std::shared_ptr<Binary>> Members;
+};
+
+} // end namespace object
+} // end namespace llvm
+
+#endif // LLVM_OBJECT_ARCHIVEMEMBERCACHE_H
@@ -38,10 +38,14 @@ struct NewArchiveMember {
                                             bool Deterministic);
 };
 
+/// Writes an archive of \p NewMembers to \p ArcName. Up to \p Threads
+/// threads read the symbols of the members and copy them into the output; the
+/// archive is the same for any number of threads.
 Error writeArchive(StringRef ArcName, ArrayRef<NewArchiveMember> NewMembers,
                    bool WriteSymtab, object::Archive::Kind Kind,
                    bool Deterministic, bool Thin,
-                   std::unique_ptr<MemoryBuffer> OldArchiveBuf = nullptr);
+                   std::unique_ptr<MemoryBuffer> OldArchiveBuf = nullptr,
+                   unsigned Threads = 1);
 }
 
 #endif
@@ -20,6 +20,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/None.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/iterator.h"
@@ -509,6 +510,10 @@ public:
 class CoverageMapping {
   DenseMap<size_t, DenseSet<size_t>> RecordProvenance;
   std::vector<FunctionRecord> Functions;
+  /// Maps the hash of a filename to the indices of the records in
+  /// \c Functions which refer to that file. Hash collisions are possible, so
+  /// users must still compare the filenames of the records they get.
+  DenseMap<size_t, SmallVector<unsigned, 0>> FilenameHash2RecordIndices;
   std::vector<std::pair<std::string, uint64_t>> FuncHashMismatches;
 
   CoverageMapping() = default;
@@ -517,6 +522,12 @@ class CoverageMapping {
   Error loadFunctionRecord(const CoverageMappingRecord &Record,
                            IndexedInstrProfReader &ProfileReader);
 
+  /// Look up the indices of the function records which may refer to
+  /// \p Filename. The result is sorted and may contain records which do not
+  /// refer to the file at all.
+  ArrayRef<unsigned> getImpreciseRecordIndicesForFilename(
+      StringRef Filename) const;
+
 public:
   CoverageMapping(const CoverageMapping &) = delete;
   CoverageMapping &operator=(const CoverageMapping &) = delete;
@@ -528,9 +539,16 @@ public:
 
   /// Load the coverage mapping from the given object files and profile. If
   /// \p Arches is non-empty, it must specify an architecture for each object.
+  ///
+  /// The mapping records of every object are decoded using up to
+  /// \p NumThreads threads, where 0 means one per hardware thread. If
+  /// \p MappingCacheDir is non-empty, decoded mappings are cached in that
+  /// directory keyed by the hash of the coverage data of the object, so that
+  /// loading the same object against a new profile skips decoding.
   static Expected<std::unique_ptr<CoverageMapping>>
   load(ArrayRef<StringRef> ObjectFilenames, StringRef ProfileFilename,
-       ArrayRef<StringRef> Arches = None);
+       ArrayRef<StringRef> Arches = None, unsigned NumThreads = 1,
+       StringRef MappingCacheDir = "");
 
   /// The number of functions that couldn't have their profiles mapped.
   ///
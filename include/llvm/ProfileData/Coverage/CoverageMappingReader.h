@@ -200,6 +200,14 @@ private:
 
   BinaryCoverageReader() = default;
 
+  friend class DecodedCoverageReader;
+
+  /// Decode the mapping regions of \p R into the given vectors.
+  Error decodeRecord(const ProfileMappingRecord &R,
+                     std::vector<StringRef> &FunctionsFilenames,
+                     std::vector<CounterExpression> &Expressions,
+                     std::vector<CounterMappingRegion> &MappingRegions) const;
+
 public:
   BinaryCoverageReader(const BinaryCoverageReader &) = delete;
   BinaryCoverageReader &operator=(const BinaryCoverageReader &) = delete;
@@ -211,6 +219,54 @@ public:
   Error readNextRecord(CoverageMappingRecord &Record) override;
 };
 
+/// Reader for coverage mapping records which have all been decoded up front,
+/// either from an object file or from a mapping cache file.
+///
+/// A mapping cache file holds the decoded records of one object file. Its
+/// layout is the magic "LLVMCOVC", then the layout version as a 32-bit little
+/// endian integer, then a string table with every function name and filename,
+/// then the records. All other integers are ULEB128 encoded and records refer
+/// to strings by their index in the table. A cache with another version is
+/// rejected, so that it is decoded from the object file again.
+class DecodedCoverageReader : public CoverageMappingReader {
+  struct DecodedRecord {
+    StringRef FunctionName;
+    uint64_t FunctionHash = 0;
+    std::vector<StringRef> Filenames;
+    std::vector<CounterExpression> Expressions;
+    std::vector<CounterMappingRegion> MappingRegions;
+  };
+
+  /// The reader which owns the object data the decoded records refer to.
+  std::unique_ptr<BinaryCoverageReader> Source;
+  /// The cache file the decoded records refer to.
+  std::unique_ptr<MemoryBuffer> CacheBuffer;
+  std::vector<DecodedRecord> Records;
+  size_t CurrentRecord = 0;
+
+  DecodedCoverageReader() = default;
+
+public:
+  DecodedCoverageReader(const DecodedCoverageReader &) = delete;
+  DecodedCoverageReader &operator=(const DecodedCoverageReader &) = delete;
+
+  /// Decode every mapping record of \p Reader, using up to \p NumThreads
+  /// threads. 0 means one thread per hardware thread.
+  static Expected<std::unique_ptr<DecodedCoverageReader>>
+  create(std::unique_ptr<BinaryCoverageReader> Reader, unsigned NumThreads);
+
+  /// Read the records of a mapping cache file written by \c writeCache.
+  static Expected<std::unique_ptr<DecodedCoverageReader>>
+  createFromCache(std::unique_ptr<MemoryBuffer> Buffer);
+
+  /// Write the decoded records to \p Path as a mapping cache file. The file
+  /// is written to a temporary and renamed into place, so that concurrent
+  /// readers never observe a partial cache.
+  Error writeCache(StringRef Path) const;
+
+  Error readNextRecord(CoverageMappingRecord &Record) override;
+};
+
 } // end namespace coverage
 } // end namespace llvm
 
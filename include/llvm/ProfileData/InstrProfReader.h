@@ -16,6 +16,7 @@
 #define LLVM_PROFILEDATA_INSTRPROFREADER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/IR/ProfileSummary.h"
 #include "llvm/ProfileData/InstrProf.h"
@@ -78,6 +79,11 @@ public:
 
   virtual bool isIRLevelProfile() const = 0;
 
+  /// Set whether readNextRecord should fill in the value profile data of the
+  /// records it returns. Readers of formats in which the value profile data
+  /// cannot be skipped cheaply ignore this and always read it.
+  virtual void setReadValueProfile(bool ReadValueProfile) {}
+
   /// Return the PGO symtab. There are three different readers:
   /// Raw, Text, and Indexed profile readers. The first two types
   /// of readers are used only by llvm-profdata tool, while the indexed
@@ -276,6 +282,21 @@ enum class HashT : uint32_t;
 
 } // end namespace IndexedInstrProf
 
+/// A single record of the on-disk hash table for the binary instrprof format,
+/// before it is decoded. It points directly into the profile buffer.
+struct OnDiskInstrProfRecord {
+  uint64_t Hash = 0;
+  /// The counters, which are stored little-endian and possibly unaligned.
+  ArrayRef<support::ulittle64_t> Counts;
+  /// The serialized value profile data, empty if there is none.
+  ArrayRef<unsigned char> ValueData;
+  support::endianness ValueDataEndianness = support::little;
+
+  /// Decode the counters into \p Record, and its value profile data too if
+  /// \p ReadValueProfile is set.
+  Error decode(InstrProfRecord &Record, bool ReadValueProfile = true) const;
+};
+
 /// Trait for lookups into the on-disk hash table for the binary instrprof
 /// format.
 class InstrProfLookupTrait {
@@ -286,6 +307,8 @@ class InstrProfLookupTrait {
   // It should be LE by default, but can be changed
   // for testing purpose.
   support::endianness ValueProfDataEndianness = support::little;
+  // Whether ReadData decodes the value profile data of the records.
+  bool ReadValueProfile = true;
 
 public:
   InstrProfLookupTrait(IndexedInstrProf::HashT HashType, unsigned FormatVersion)
@@ -317,14 +340,18 @@ public:
     return StringRef((const char *)D, N);
   }
 
-  bool readValueProfilingData(const unsigned char *&D,
-                              const unsigned char *const End);
+  /// Split the data of a key into its records without decoding them. Return
+  /// false if the data is malformed.
+  bool readRawRecords(const unsigned char *D, offset_type N,
+                      SmallVectorImpl<OnDiskInstrProfRecord> &Records) const;
   data_type ReadData(StringRef K, const unsigned char *D, offset_type N);
 
   // Used for testing purpose only.
   void setValueProfDataEndianness(support::endianness Endianness) {
     ValueProfDataEndianness = Endianness;
   }
+
+  void setReadValueProfile(bool Read) { ReadValueProfile = Read; }
 };
 
 struct InstrProfReaderIndexBase {
@@ -334,12 +361,18 @@ struct InstrProfReaderIndexBase {
   // iterator.
   virtual Error getRecords(ArrayRef<NamedInstrProfRecord> &Data) = 0;
 
-  // Read all the profile records with the key equal to FuncName
-  virtual Error getRecords(StringRef FuncName,
-                                     ArrayRef<NamedInstrProfRecord> &Data) = 0;
+  // Find all the profile records with the key equal to FuncName, without
+  // decoding them. This does not change the state of the index, so it may be
+  // called from several threads at once.
+  virtual Error
+  getRawRecords(StringRef FuncName,
+                SmallVectorImpl<OnDiskInstrProfRecord> &Records) = 0;
   virtual void advanceToNextKey() = 0;
   virtual bool atEnd() const = 0;
   virtual void setValueProfDataEndianness(support::endianness Endianness) = 0;
+  virtual void setReadValueProfile(bool Read) = 0;
+  // Append the keys of all the profile records to Names, in on-disk order.
+  virtual void getKeys(std::vector<StringRef> &Names) = 0;
   virtual uint64_t getVersion() const = 0;
   virtual bool isIRLevelProfile() const = 0;
   virtual Error populateSymtab(InstrProfSymtab &) = 0;
@@ -368,8 +401,8 @@ public:
   ~InstrProfReaderIndex() override = default;
 
   Error getRecords(ArrayRef<NamedInstrProfRecord> &Data) override;
-  Error getRecords(StringRef FuncName,
-                   ArrayRef<NamedInstrProfRecord> &Data) override;
+  Error getRawRecords(StringRef FuncName,
+                      SmallVectorImpl<OnDiskInstrProfRecord> &Records) override;
   void advanceToNextKey() override { RecordIterator++; }
 
   bool atEnd() const override {
@@ -380,6 +413,15 @@ public:
     HashTable->getInfoObj().setValueProfDataEndianness(Endianness);
   }
 
+  void setReadValueProfile(bool Read) override {
+    HashTable->getInfoObj().setReadValueProfile(Read);
+  }
+
+  void getKeys(std::vector<StringRef> &Names) override {
+    for (StringRef Name : HashTable->keys())
+      Names.push_back(Name);
+  }
+
   uint64_t getVersion() const override { return GET_VERSION(FormatVersion); }
 
   bool isIRLevelProfile() const override {
@@ -396,8 +438,9 @@ class InstrProfReaderRemapper {
 public:
   virtual ~InstrProfReaderRemapper() {}
   virtual Error populateRemappings() { return Error::success(); }
-  virtual Error getRecords(StringRef FuncName,
-                           ArrayRef<NamedInstrProfRecord> &Data) = 0;
+  virtual Error
+  getRawRecords(StringRef FuncName,
+                SmallVectorImpl<OnDiskInstrProfRecord> &Records) = 0;
 };
 
 /// Reader for the indexed binary instrprof format.
@@ -442,7 +485,13 @@ public:
   /// Read a single record.
   Error readNextRecord(NamedInstrProfRecord &Record) override;
 
-  /// Return the NamedInstrProfRecord associated with FuncName and FuncHash
+  void setReadValueProfile(bool ReadValueProfile) override {
+    Index->setReadValueProfile(ReadValueProfile);
+  }
+
+  /// Return the NamedInstrProfRecord associated with FuncName and FuncHash.
+  /// Only the value profile data of that record is decoded, not that of other
+  /// records with the same name.
   Expected<InstrProfRecord> getInstrProfRecord(StringRef FuncName,
                                                uint64_t FuncHash);
 
@@ -450,6 +499,24 @@ public:
   Error getFunctionCounts(StringRef FuncName, uint64_t FuncHash,
                           std::vector<uint64_t> &Counts);
 
+  /// Return the counters of the given function. The counters are not copied
+  /// out of the profile buffer, so they are only valid as long as the reader.
+  Expected<ArrayRef<support::ulittle64_t>>
+  getFunctionCountsView(StringRef FuncName, uint64_t FuncHash);
+
+  /// Decode all the records named FuncName into Records, which is cleared
+  /// first. No remapping is applied to FuncName. Unlike the other lookups this
+  /// leaves the state of the reader alone, so it may be called from several
+  /// threads at once.
+  Error getFunctionRecords(StringRef FuncName,
+                           std::vector<NamedInstrProfRecord> &Records);
+
+  /// Append the names of all the functions in the profile to Names, in
+  /// on-disk order.
+  void getFunctionNames(std::vector<StringRef> &Names) {
+    Index->getKeys(Names);
+  }
+
   /// Return the maximum of all known function counts.
   uint64_t getMaximumFunctionCount() { return Summary->getMaxFunctionCount(); }
 
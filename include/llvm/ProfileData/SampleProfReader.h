@@ -280,6 +280,8 @@ public:
   /// Print the profile for \p FName on stream \p OS.
   void dumpFunctionProfile(StringRef FName, raw_ostream &OS = dbgs());
 
+  /// Limit the profiles read by read() to the functions defined in \p M.
+  /// Formats without an index of their functions read all of them anyway.
   virtual void collectFuncsToUse(const Module &M) {}
 
   /// Print all the profiles on stream \p OS.
@@ -455,13 +457,19 @@ public:
 
 class SampleProfileReaderCompactBinary : public SampleProfileReaderBinary {
 private:
-  /// Function name table.
-  std::vector<std::string> NameTable;
-  /// The table mapping from function name to the offset of its FunctionSample
-  /// towards file start.
-  DenseMap<StringRef, uint64_t> FuncOffsetTable;
+  /// Function name table, holding the MD5 hash of every name.
+  std::vector<uint64_t> NameTable;
+  /// The decimal strings of the names in NameTable, which are what profiles
+  /// are keyed by. They are only created for the names that are actually
+  /// read, since a profile may have millions of them.
+  std::vector<std::string> NameStrings;
+  /// The table mapping from the MD5 hash of a function name to the offset of
+  /// its FunctionSample towards file start.
+  DenseMap<uint64_t, uint64_t> FuncOffsetTable;
   /// The set containing the functions to use when compiling a module.
   DenseSet<StringRef> FuncsToUse;
+  /// Read every function, as collectFuncsToUse has not been called.
+  bool UseAllFuncs = true;
   virtual std::error_code verifySPMagic(uint64_t Magic) override;
   virtual std::error_code readNameTable() override;
   /// Read a string indirectly via the name table.
@@ -477,7 +485,8 @@ public:
   /// \brief Return true if \p Buffer is in the format supported by this class.
   static bool hasFormat(const MemoryBuffer &Buffer);
 
-  /// Read samples only for functions to use.
+  /// Read samples only for functions to use, or for all of them if no
+  /// functions to use have been collected.
   std::error_code read() override;
 
   /// Collect functions to be used when compiling Module \p M.
@@ -0,0 +1,107 @@
+//===- ShardedStringPool.h - Concurrent string table builder ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a string pool that may be filled from several threads at
+// once, for building string sections such as .debug_str.
+//
+// Strings are distributed over a fixed number of shards by hash. Each shard
+// owns its own map, allocator and lock, so that threads interning different
+// strings rarely contend. Offsets are not handed out while interning, because
+// they would depend on the order in which threads reach the pool. Instead,
+// finalize() sorts all strings and lays them out back to back, which gives the
+// same table for the same set of strings regardless of how it was built:
+//
+//   ShardedStringPool Pool;
+//   // From any number of threads:
+//   StringRef Name = Pool.intern(DIEName);
+//   // Once all threads are done:
+//   Pool.finalize();
+//   uint64_t Offset = Pool.getOffset(Name);
+//   Pool.write(OS);
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SHARDEDSTRINGPOOL_H
+#define LLVM_SUPPORT_SHARDEDSTRINGPOOL_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Allocator.h"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace llvm {
+
+class raw_ostream;
+
+class ShardedStringPool {
+public:
+  /// Create a pool with \p NumShards shards, rounded up to a power of two.
+  explicit ShardedStringPool(unsigned NumShards = 64);
+  ShardedStringPool(const ShardedStringPool &) = delete;
+  ShardedStringPool &operator=(const ShardedStringPool &) = delete;
+
+  /// Add \p S to the pool unless it is already present and return the pooled
+  /// copy, which stays valid for the lifetime of the pool. Thread-safe; must
+  /// not be called after finalize().
+  StringRef intern(StringRef S);
+
+  /// Returns the number of distinct strings in the pool. Thread-safe.
+  size_t size() const;
+
+  /// Assign offsets to all strings. Each string is followed by a NUL byte and
+  /// strings are ordered lexicographically, so the layout only depends on the
+  /// set of strings that were interned.
+  void finalize();
+
+  bool isFinalized() const { return Finalized; }
+
+  /// Returns the offset of \p S, which must have been interned, in the
+  /// finalized table.
+  uint64_t getOffset(StringRef S) const;
+
+  /// Returns the size of the finalized table in bytes.
+  uint64_t getSize() const {
+    assert(Finalized && "pool is not finalized");
+    return Size;
+  }
+
+  /// Returns the strings of the finalized table in offset order.
+  ArrayRef<StringRef> getStrings() const {
+    assert(Finalized && "pool is not finalized");
+    return Sorted;
+  }
+
+  /// Write the finalized table to \p OS.
+  void write(raw_ostream &OS) const;
+
+private:
+  struct Shard {
+    mutable std::mutex Mutex;
+    /// Maps every string to its offset, which is only valid once the pool has
+    /// been finalized.
+    StringMap<uint64_t, BumpPtrAllocator> Strings;
+  };
+
+  Shard &getShard(StringRef S) const;
+
+  std::unique_ptr<Shard[]> Shards;
+  unsigned NumShards;
+  std::vector<StringRef> Sorted;
+  uint64_t Size = 0;
+  bool Finalized = false;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_SUPPORT_SHARDEDSTRINGPOOL_H
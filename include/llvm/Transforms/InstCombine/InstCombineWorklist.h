@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/Support/Compiler.h"
@@ -28,6 +29,11 @@ class InstCombineWorklist {
   SmallVector<Instruction*, 256> Worklist;
   DenseMap<Instruction*, unsigned> WorklistMap;
 
+  /// Every instruction passed to Add while recording is enabled.  The entries
+  /// are never dereferenced, so erased instructions may safely linger here.
+  SmallPtrSet<Instruction *, 32> Recorded;
+  bool RecordAdded = false;
+
 public:
   InstCombineWorklist() = default;
 
@@ -39,6 +45,8 @@ public:
   /// Add - Add the specified instruction to the worklist if it isn't already
   /// in it.
   void Add(Instruction *I) {
+    if (RecordAdded)
+      Recorded.insert(I);
     if (WorklistMap.insert(std::make_pair(I, Worklist.size())).second) {
       LLVM_DEBUG(dbgs() << "IC: ADD: " << *I << '\n');
       Worklist.push_back(I);
@@ -93,6 +101,25 @@ public:
   }
 
 
+  /// Clear - drop every pending instruction without visiting it.
+  void Clear() {
+    Worklist.clear();
+    WorklistMap.clear();
+  }
+
+  /// setRecordAdded - Start or stop remembering the instructions passed to
+  /// Add.  Either way the set of recorded instructions is reset.
+  void setRecordAdded(bool Record) {
+    RecordAdded = Record;
+    Recorded.clear();
+  }
+
+  /// wasAdded - Return true if I was added since recording was last reset.
+  bool wasAdded(Instruction *I) const { return Recorded.count(I); }
+
+  /// clearRecorded - Forget the recorded instructions, but keep recording.
+  void clearRecorded() { Recorded.clear(); }
+
   /// Zap - check that the worklist is empty and nuke the backing store for
   /// the map if it is large.
   void Zap() {
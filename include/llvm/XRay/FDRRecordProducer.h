@@ -40,6 +40,17 @@ public:
                           uint32_t &OP)
       : Header(FH), E(DE), OffsetPtr(OP) {}
 
+  /// Resumes reading a log at \p OP, which another producer for the same log
+  /// reached with \p BufferBytes left in the current buffer (see
+  /// currentBufferBytes()).
+  FileBasedRecordProducer(const XRayFileHeader &FH, DataExtractor &DE,
+                          uint32_t &OP, uint32_t BufferBytes)
+      : Header(FH), E(DE), OffsetPtr(OP), CurrentBufferBytes(BufferBytes) {}
+
+  /// The number of bytes left in the current buffer, which is only tracked
+  /// for logs of version 3 or later.
+  uint32_t currentBufferBytes() const { return CurrentBufferBytes; }
+
   /// This producer encapsulates the logic for loading a File-backed
   /// RecordProducer hidden behind a DataExtractor.
   Expected<std::unique_ptr<Record>> produce() override;
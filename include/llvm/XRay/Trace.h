@@ -16,6 +16,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
@@ -75,6 +76,39 @@ Expected<Trace> loadTraceFile(StringRef Filename, bool Sort = false);
 /// DataExtractor.
 Expected<Trace> loadTrace(const DataExtractor &Extractor, bool Sort = false);
 
+/// This function will read the XRay trace records from the provided |Filename|
+/// and pass them to |Callback| one at a time. Without |Sort|, they come in
+/// the order in which loadTraceFile(Filename) would return them. It stops at
+/// the first error, including one returned by |Callback|, and returns the
+/// file header once all the records have been passed.
+///
+/// Flight data recorder mode logs are not expanded into memory up front: the
+/// blocks of each thread are indexed first and decoded again when they are
+/// needed, so only the records that |Callback| has yet to see are held. The
+/// threads are decoded ahead of |Callback| on up to |NumThreads| threads (one
+/// per hardware thread if 0); |Callback| is always called on the calling
+/// thread. A malformed block is reported when its thread is reached, after
+/// the records of the threads before it have been passed.
+///
+/// With |Sort|, the records of the threads in a flight data recorder mode log
+/// are merged by TSC: the records of one thread keep their order, and on equal
+/// TSCs the records of earlier threads come first. Unlike the stable sort done
+/// by loadTraceFile(Filename, true), the merge does not reorder the records of
+/// a thread whose TSCs go backwards, so the two orders only agree when every
+/// thread's records are in TSC order. Logs in the other formats are loaded
+/// with loadTraceFile.
+Expected<XRayFileHeader>
+streamTraceFile(StringRef Filename,
+                function_ref<Error(const XRayRecord &)> Callback,
+                bool Sort = false, unsigned NumThreads = 0);
+
+/// This function will read the XRay trace records from the provided
+/// DataExtractor, like streamTraceFile.
+Expected<XRayFileHeader>
+streamTrace(const DataExtractor &Extractor,
+            function_ref<Error(const XRayRecord &)> Callback, bool Sort = false,
+            unsigned NumThreads = 0);
+
 } // namespace xray
 } // namespace llvm
 
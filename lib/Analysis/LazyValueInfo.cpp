@@ -16,6 +16,7 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AssumptionCache.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/InstructionSimplify.h"
@@ -34,6 +35,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/PatternMatch.h"
 #include "llvm/IR/ValueHandle.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/raw_ostream.h"
@@ -47,6 +49,17 @@ using namespace PatternMatch;
 // answer for a given value.
 static const unsigned MaxProcessedPerValue = 500;
 
+static cl::opt<unsigned> LVICacheMaxEntries(
+    "lvi-cache-max-entries", cl::init(1000000), cl::Hidden,
+    cl::desc("Maximum number of block values LazyValueInfo caches before "
+             "evicting the least recently used blocks (0 = unlimited)"));
+
+STATISTIC(NumLVICacheHits, "Number of block values read from the cache");
+STATISTIC(NumLVICacheMisses, "Number of block values that were solved");
+STATISTIC(NumLVICacheBlocksEvicted, "Number of blocks evicted from the cache");
+STATISTIC(NumLVICacheEntriesEvicted,
+          "Number of block values evicted from the cache");
+
 char LazyValueInfoWrapperPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfoWrapperPass, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -151,90 +164,102 @@ namespace {
 namespace {
   /// This is the cache kept by LazyValueInfo which
   /// maintains information about queries across the clients' queries.
+  ///
+  /// The cache is organized by block so that a block's results can be
+  /// dropped in one step, either because the block was deleted or because
+  /// the cache grew beyond its budget and the block was the least recently
+  /// used one.
   class LazyValueInfoCache {
-    /// This is all of the cached block information for exactly one Value*.
-    /// The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
-    /// Over-defined lattice values are recorded in OverDefinedCache to reduce
+    /// This is all of the cached information for exactly one block.
+    /// Over-defined lattice values are recorded in OverDefined to reduce
     /// memory overhead.
-    struct ValueCacheEntryTy {
-      ValueCacheEntryTy(Value *V, LazyValueInfoCache *P) : Handle(V, P) {}
-      LVIValueHandle Handle;
-      SmallDenseMap<PoisoningVH<BasicBlock>, ValueLatticeElement, 4> BlockVals;
+    struct BlockCacheEntryTy {
+      SmallDenseMap<Value *, ValueLatticeElement, 4> LatticeElements;
+      SmallPtrSet<Value *, 4> OverDefined;
+
+      /// The value of UseClock when this block was last queried or updated.
+      uint64_t LastUse = 0;
+
+      unsigned size() const {
+        return LatticeElements.size() + OverDefined.size();
+      }
     };
 
-    /// This tracks, on a per-block basis, the set of values that are
-    /// over-defined at the end of that block.
-    typedef DenseMap<PoisoningVH<BasicBlock>, SmallPtrSet<Value *, 4>>
-        OverDefinedCacheTy;
-    /// Keep track of all blocks that we have ever seen, so we
-    /// don't spend time removing unused blocks from our caches.
-    DenseSet<PoisoningVH<BasicBlock> > SeenBlocks;
+    /// This is all of the cached information for all blocks.
+    DenseMap<PoisoningVH<BasicBlock>, std::unique_ptr<BlockCacheEntryTy>>
+        BlockCache;
+
+    /// One handle per cached value, so that the value's entries are erased
+    /// from every block when it is deleted.
+    DenseMap<Value *, std::unique_ptr<LVIValueHandle>> ValueHandles;
+
+    /// Ticks on every block access and orders blocks for eviction.
+    mutable uint64_t UseClock = 0;
 
-    /// This is all of the cached information for all values,
-    /// mapped from Value* to key information.
-    DenseMap<Value *, std::unique_ptr<ValueCacheEntryTy>> ValueCache;
-    OverDefinedCacheTy OverDefinedCache;
+    /// The number of lattice and over-defined entries over all blocks.
+    unsigned NumEntries = 0;
 
+    BlockCacheEntryTy *getBlockEntry(BasicBlock *BB) const {
+      auto I = BlockCache.find(BB);
+      if (I == BlockCache.end())
+        return nullptr;
+      I->second->LastUse = ++UseClock;
+      return I->second.get();
+    }
 
   public:
     void insertResult(Value *Val, BasicBlock *BB,
                       const ValueLatticeElement &Result) {
-      SeenBlocks.insert(BB);
+      std::unique_ptr<BlockCacheEntryTy> &Entry = BlockCache[BB];
+      if (!Entry)
+        Entry = make_unique<BlockCacheEntryTy>();
+      Entry->LastUse = ++UseClock;
+
+      if (!ValueHandles.count(Val))
+        ValueHandles[Val] = make_unique<LVIValueHandle>(Val, this);
 
-      // Insert over-defined values into their own cache to reduce memory
+      // Insert over-defined values into their own set to reduce memory
       // overhead.
-      if (Result.isOverdefined())
-        OverDefinedCache[BB].insert(Val);
-      else {
-        auto It = ValueCache.find_as(Val);
-        if (It == ValueCache.end()) {
-          ValueCache[Val] = make_unique<ValueCacheEntryTy>(Val, this);
-          It = ValueCache.find_as(Val);
-          assert(It != ValueCache.end() && "Val was just added to the map!");
-        }
-        It->second->BlockVals[BB] = Result;
+      if (Result.isOverdefined()) {
+        if (Entry->OverDefined.insert(Val).second)
+          ++NumEntries;
+        return;
       }
-    }
-
-    bool isOverdefined(Value *V, BasicBlock *BB) const {
-      auto ODI = OverDefinedCache.find(BB);
-
-      if (ODI == OverDefinedCache.end())
-        return false;
 
-      return ODI->second.count(V);
+      auto Inserted = Entry->LatticeElements.insert({Val, Result});
+      if (Inserted.second)
+        ++NumEntries;
+      else
+        Inserted.first->second = Result;
     }
 
     bool hasCachedValueInfo(Value *V, BasicBlock *BB) const {
-      if (isOverdefined(V, BB))
-        return true;
-
-      auto I = ValueCache.find_as(V);
-      if (I == ValueCache.end())
+      BlockCacheEntryTy *Entry = getBlockEntry(BB);
+      if (!Entry)
         return false;
 
-      return I->second->BlockVals.count(BB);
+      return Entry->OverDefined.count(V) || Entry->LatticeElements.count(V);
     }
 
     ValueLatticeElement getCachedValueInfo(Value *V, BasicBlock *BB) const {
-      if (isOverdefined(V, BB))
+      BlockCacheEntryTy *Entry = getBlockEntry(BB);
+      if (!Entry)
+        return ValueLatticeElement();
+
+      if (Entry->OverDefined.count(V))
         return ValueLatticeElement::getOverdefined();
 
-      auto I = ValueCache.find_as(V);
-      if (I == ValueCache.end())
-        return ValueLatticeElement();
-      auto BBI = I->second->BlockVals.find(BB);
-      if (BBI == I->second->BlockVals.end())
+      auto I = Entry->LatticeElements.find(V);
+      if (I == Entry->LatticeElements.end())
         return ValueLatticeElement();
-      return BBI->second;
+      return I->second;
     }
 
     /// clear - Empty the cache.
     void clear() {
-      SeenBlocks.clear();
-      ValueCache.clear();
-      OverDefinedCache.clear();
+      BlockCache.clear();
+      ValueHandles.clear();
+      NumEntries = 0;
     }
 
     /// Inform the cache that a given value has been deleted.
@@ -249,22 +274,25 @@ namespace {
     /// flushes elements from the cache and does not add any.
     void threadEdgeImpl(BasicBlock *OldSucc,BasicBlock *NewSucc);
 
+    /// Evict the least recently used blocks until the cache is back under
+    /// the LVICacheMaxEntries budget.  This must not be called while a query
+    /// is being solved, as the solver relies on the results it has cached.
+    void enforceBudget();
+
     friend struct LVIValueHandle;
   };
 }
 
 void LazyValueInfoCache::eraseValue(Value *V) {
-  for (auto I = OverDefinedCache.begin(), E = OverDefinedCache.end(); I != E;) {
-    // Copy and increment the iterator immediately so we can erase behind
-    // ourselves.
-    auto Iter = I++;
-    SmallPtrSetImpl<Value *> &ValueSet = Iter->second;
-    ValueSet.erase(V);
-    if (ValueSet.empty())
-      OverDefinedCache.erase(Iter);
+  for (auto &I : BlockCache) {
+    BlockCacheEntryTy &Entry = *I.second;
+    NumEntries -= Entry.OverDefined.erase(V);
+    NumEntries -= Entry.LatticeElements.erase(V);
   }
 
-  ValueCache.erase(V);
+  // This erasure deallocates the handle that may be calling us, so it must
+  // come last.
+  ValueHandles.erase(V);
 }
 
 void LVIValueHandle::deleted() {
@@ -274,18 +302,12 @@ void LVIValueHandle::deleted() {
 }
 
 void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
-  // Shortcut if we have never seen this block.
-  DenseSet<PoisoningVH<BasicBlock> >::iterator I = SeenBlocks.find(BB);
-  if (I == SeenBlocks.end())
+  auto I = BlockCache.find(BB);
+  if (I == BlockCache.end())
     return;
-  SeenBlocks.erase(I);
 
-  auto ODI = OverDefinedCache.find(BB);
-  if (ODI != OverDefinedCache.end())
-    OverDefinedCache.erase(ODI);
-
-  for (auto &I : ValueCache)
-    I.second->BlockVals.erase(BB);
+  NumEntries -= I->second->size();
+  BlockCache.erase(I);
 }
 
 void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
@@ -303,10 +325,11 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
   std::vector<BasicBlock*> worklist;
   worklist.push_back(OldSucc);
 
-  auto I = OverDefinedCache.find(OldSucc);
-  if (I == OverDefinedCache.end())
+  auto I = BlockCache.find(OldSucc);
+  if (I == BlockCache.end() || I->second->OverDefined.empty())
     return; // Nothing to process here.
-  SmallVector<Value *, 4> ValsToClear(I->second.begin(), I->second.end());
+  SmallVector<Value *, 4> ValsToClear(I->second->OverDefined.begin(),
+                                      I->second->OverDefined.end());
 
   // Use a worklist to perform a depth-first search of OldSucc's successors.
   // NOTE: We do not need a visited list since any blocks we have already
@@ -320,10 +343,10 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
     if (ToUpdate == NewSucc) continue;
 
     // If a value was marked overdefined in OldSucc, and is here too...
-    auto OI = OverDefinedCache.find(ToUpdate);
-    if (OI == OverDefinedCache.end())
+    auto OI = BlockCache.find(ToUpdate);
+    if (OI == BlockCache.end() || OI->second->OverDefined.empty())
       continue;
-    SmallPtrSetImpl<Value *> &ValueSet = OI->second;
+    SmallPtrSetImpl<Value *> &ValueSet = OI->second->OverDefined;
 
     bool changed = false;
     for (Value *V : ValsToClear) {
@@ -333,11 +356,10 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
       // If we removed anything, then we potentially need to update
       // blocks successors too.
       changed = true;
+      --NumEntries;
 
-      if (ValueSet.empty()) {
-        OverDefinedCache.erase(OI);
+      if (ValueSet.empty())
         break;
-      }
     }
 
     if (!changed) continue;
@@ -346,6 +368,31 @@ void LazyValueInfoCache::threadEdgeImpl(BasicBlock *OldSucc,
   }
 }
 
+void LazyValueInfoCache::enforceBudget() {
+  if (!LVICacheMaxEntries || NumEntries <= LVICacheMaxEntries)
+    return;
+
+  // Evict down to three quarters of the budget so that a cache hovering
+  // around its limit does not pay for a sort on every query.
+  unsigned Target = LVICacheMaxEntries - LVICacheMaxEntries / 4;
+  SmallVector<std::pair<uint64_t, BasicBlock *>, 32> ByAge;
+  ByAge.reserve(BlockCache.size());
+  for (auto &I : BlockCache)
+    ByAge.push_back({I.second->LastUse, I.first});
+  llvm::sort(ByAge.begin(), ByAge.end(), less_first());
+
+  for (auto &AgeAndBlock : ByAge) {
+    if (NumEntries <= Target)
+      break;
+    auto I = BlockCache.find(AgeAndBlock.second);
+    NumEntries -= I->second->size();
+    NumLVICacheEntriesEvicted += I->second->size();
+    ++NumLVICacheBlocksEvicted;
+    BlockCache.erase(I);
+  }
+  LLVM_DEBUG(dbgs() << "LVI cache evicted blocks down to " << NumEntries
+                    << " entries\n");
+}
 
 namespace {
 /// An assembly annotator class to print LazyValueCache information in
@@ -560,6 +607,7 @@ ValueLatticeElement LazyValueInfoImpl::getBlockValue(Value *Val,
   if (Constant *VC = dyn_cast<Constant>(Val))
     return ValueLatticeElement::get(VC);
 
+  ++NumLVICacheHits;
   return TheCache.getCachedValueInfo(Val, BB);
 }
 
@@ -590,8 +638,8 @@ bool LazyValueInfoImpl::solveBlockValue(Value *Val, BasicBlock *BB) {
                       << TheCache.getCachedValueInfo(Val, BB) << '\n');
 
     // Since we're reusing a cached value, we don't need to update the
-    // OverDefinedCache. The cache will have been properly updated whenever the
-    // cached value was inserted.
+    // block's over-defined set. It will have been properly updated whenever
+    // the cached value was inserted.
     return true;
   }
 
@@ -602,6 +650,7 @@ bool LazyValueInfoImpl::solveBlockValue(Value *Val, BasicBlock *BB) {
     // Work pushed, will revisit
     return false;
 
+  ++NumLVICacheMisses;
   TheCache.insertResult(Val, BB, Res);
   return true;
 }
@@ -1416,6 +1465,7 @@ ValueLatticeElement LazyValueInfoImpl::getValueInBlock(Value *V, BasicBlock *BB,
   }
   ValueLatticeElement Result = getBlockValue(V, BB);
   intersectAssumeOrGuardBlockValueConstantRange(V, Result, CxtI);
+  TheCache.enforceBudget();
 
   LLVM_DEBUG(dbgs() << "  Result = " << Result << "\n");
   return Result;
@@ -1451,6 +1501,7 @@ getValueOnEdge(Value *V, BasicBlock *FromBB, BasicBlock *ToBB,
     (void)WasFastQuery;
     assert(WasFastQuery && "More work to do after problem solved?");
   }
+  TheCache.enforceBudget();
 
   LLVM_DEBUG(dbgs() << "  Result = " << Result << "\n");
   return Result;
@@ -146,6 +146,16 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumSCEVCacheHits, "Number of getSCEV queries answered from cache");
+STATISTIC(NumSCEVCacheMisses, "Number of getSCEV queries that built a SCEV");
+STATISTIC(NumRangeCacheHits, "Number of range queries answered from cache");
+STATISTIC(NumRangeCacheMisses, "Number of range queries that were computed");
+STATISTIC(NumBECountCacheHits,
+          "Number of backedge-taken count queries answered from cache");
+STATISTIC(NumBECountCacheMisses,
+          "Number of backedge-taken count queries that were computed");
+STATISTIC(NumBECountsForgotten,
+          "Number of cached backedge-taken counts invalidated");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -3916,6 +3926,7 @@ const SCEV *ScalarEvolution::getSCEV(Value *V) {
 
   const SCEV *S = getExistingSCEV(V);
   if (S == nullptr) {
+    ++NumSCEVCacheMisses;
     S = createSCEV(V);
     // During PHI resolution, it is possible to create two SCEVs for the same
     // V, so it is needed to double check whether V->S is inserted into
@@ -3939,6 +3950,8 @@ const SCEV *ScalarEvolution::getSCEV(Value *V) {
           !isa<GetElementPtrInst>(V))
         ExprValueMap[Stripped].insert({V, Offset});
     }
+  } else {
+    ++NumSCEVCacheHits;
   }
   return S;
 }
@@ -5554,8 +5567,11 @@ ScalarEvolution::getRangeRef(const SCEV *S,
 
   // See if we've computed this range already.
   DenseMap<const SCEV *, ConstantRange>::iterator I = Cache.find(S);
-  if (I != Cache.end())
+  if (I != Cache.end()) {
+    ++NumRangeCacheHits;
     return I->second;
+  }
+  ++NumRangeCacheMisses;
 
   if (const SCEVConstant *C = dyn_cast<SCEVConstant>(S))
     return setRange(C, SignHint, ConstantRange(C->getAPInt()));
@@ -6638,6 +6654,7 @@ ScalarEvolution::getPredicatedBackedgeTakenInfo(const Loop *L) {
   BackedgeTakenInfo Result =
       computeBackedgeTakenCount(L, /*AllowPredicates=*/true);
 
+  addToBECountUsers(L, Result, /*Predicated=*/true);
   return PredicatedBackedgeTakenCounts.find(L)->second = std::move(Result);
 }
 
@@ -6650,8 +6667,11 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // backedge-taken count, which could result in infinite recursion.
   std::pair<DenseMap<const Loop *, BackedgeTakenInfo>::iterator, bool> Pair =
       BackedgeTakenCounts.insert({L, BackedgeTakenInfo()});
-  if (!Pair.second)
+  if (!Pair.second) {
+    ++NumBECountCacheHits;
     return Pair.first->second;
+  }
+  ++NumBECountCacheMisses;
 
   // computeBackedgeTakenCount may allocate memory for its result. Inserting it
   // into the BackedgeTakenCounts map transfers ownership. Otherwise, the result
@@ -6741,6 +6761,7 @@ ScalarEvolution::getBackedgeTakenInfo(const Loop *L) {
   // recusive call to getBackedgeTakenInfo (on a different
   // loop), which would invalidate the iterator computed
   // earlier.
+  addToBECountUsers(L, Result, /*Predicated=*/false);
   return BackedgeTakenCounts.find(L)->second = std::move(Result);
 }
 
@@ -6930,6 +6951,16 @@ bool ScalarEvolution::BackedgeTakenInfo::hasOperand(const SCEV *S,
   return false;
 }
 
+void ScalarEvolution::BackedgeTakenInfo::getExprs(
+    SmallVectorImpl<const SCEV *> &Exprs, ScalarEvolution *SE) const {
+  if (getMax() && getMax() != SE->getCouldNotCompute())
+    Exprs.push_back(getMax());
+
+  for (auto &ENT : ExitNotTaken)
+    if (ENT.ExactNotTaken != SE->getCouldNotCompute())
+      Exprs.push_back(ENT.ExactNotTaken);
+}
+
 ScalarEvolution::ExitLimit::ExitLimit(const SCEV *E)
     : ExactNotTaken(E), MaxNotTaken(E) {
   assert((isa<SCEVCouldNotCompute>(MaxNotTaken) ||
@@ -11343,6 +11374,7 @@ ScalarEvolution::ScalarEvolution(ScalarEvolution &&Arg)
       BackedgeTakenCounts(std::move(Arg.BackedgeTakenCounts)),
       PredicatedBackedgeTakenCounts(
           std::move(Arg.PredicatedBackedgeTakenCounts)),
+      BECountUsers(std::move(Arg.BECountUsers)),
       ConstantEvolutionLoopExitValue(
           std::move(Arg.ConstantEvolutionLoopExitValue)),
       ValuesAtScopes(std::move(Arg.ValuesAtScopes)),
@@ -11778,20 +11810,27 @@ ScalarEvolution::forgetMemoizedResults(const SCEV *S) {
       ++I;
   }
 
-  auto RemoveSCEVFromBackedgeMap =
-      [S, this](DenseMap<const Loop *, BackedgeTakenInfo> &Map) {
-        for (auto I = Map.begin(), E = Map.end(); I != E;) {
-          BackedgeTakenInfo &BEInfo = I->second;
-          if (BEInfo.hasOperand(S, this)) {
-            BEInfo.clear();
-            Map.erase(I++);
-          } else
-            ++I;
-        }
-      };
+  // Only the loops recorded as using S can have a count that refers to it.
+  // The record may be stale if the count was since forgotten or recomputed,
+  // so check the cached count before dropping it.
+  auto BEUsers = BECountUsers.find(S);
+  if (BEUsers == BECountUsers.end())
+    return;
 
-  RemoveSCEVFromBackedgeMap(BackedgeTakenCounts);
-  RemoveSCEVFromBackedgeMap(PredicatedBackedgeTakenCounts);
+  SmallVector<PointerIntPair<const Loop *, 1, bool>, 2> Users =
+      std::move(BEUsers->second);
+  BECountUsers.erase(BEUsers);
+  for (auto LoopAndPredicated : Users) {
+    DenseMap<const Loop *, BackedgeTakenInfo> &Map =
+        LoopAndPredicated.getInt() ? PredicatedBackedgeTakenCounts
+                                   : BackedgeTakenCounts;
+    auto I = Map.find(LoopAndPredicated.getPointer());
+    if (I != Map.end() && I->second.hasOperand(S, this)) {
+      ++NumBECountsForgotten;
+      I->second.clear();
+      Map.erase(I);
+    }
+  }
 }
 
 void
@@ -11821,6 +11860,35 @@ void ScalarEvolution::addToLoopUseLists(const SCEV *S) {
     LoopUsers[L].push_back(S);
 }
 
+void ScalarEvolution::addToBECountUsers(const Loop *L,
+                                        const BackedgeTakenInfo &BTI,
+                                        bool Predicated) {
+  struct FindSubExprs {
+    FindSubExprs(SmallPtrSetImpl<const SCEV *> &SubExprs)
+        : SubExprs(SubExprs) {}
+    SmallPtrSetImpl<const SCEV *> &SubExprs;
+    bool follow(const SCEV *S) { return SubExprs.insert(S).second; }
+    bool isDone() const { return false; }
+  };
+
+  SmallVector<const SCEV *, 4> Exprs;
+  BTI.getExprs(Exprs, this);
+
+  SmallPtrSet<const SCEV *, 16> SubExprs;
+  FindSubExprs Finder(SubExprs);
+  SCEVTraversal<FindSubExprs> ST(Finder);
+  for (const SCEV *S : Exprs)
+    ST.visitAll(S);
+
+  // A loop whose count was forgotten and recomputed may already be listed.
+  PointerIntPair<const Loop *, 1, bool> User(L, Predicated);
+  for (const SCEV *S : SubExprs) {
+    auto &Users = BECountUsers[S];
+    if (!is_contained(Users, User))
+      Users.push_back(User);
+  }
+}
+
 void ScalarEvolution::verify() const {
   ScalarEvolution &SE = *const_cast<ScalarEvolution *>(this);
   ScalarEvolution SE2(F, TLI, AC, DT, LI);
@@ -10,13 +10,19 @@
 #include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/DebugInfo/CodeView/CodeViewError.h"
 #include "llvm/DebugInfo/CodeView/GlobalTypeTableBuilder.h"
 #include "llvm/DebugInfo/CodeView/MergingTypeTableBuilder.h"
 #include "llvm/DebugInfo/CodeView/TypeDeserializer.h"
+#include "llvm/DebugInfo/CodeView/TypeHashing.h"
 #include "llvm/DebugInfo/CodeView/TypeIndex.h"
 #include "llvm/DebugInfo/CodeView/TypeIndexDiscovery.h"
 #include "llvm/DebugInfo/CodeView/TypeRecord.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include <atomic>
+#include <memory>
 
 using namespace llvm;
 using namespace llvm::codeview;
@@ -492,3 +498,200 @@ Expected<bool> TypeStreamMerger::shouldRemapType(const CVType &Type) {
   }
   return true;
 }
+
+namespace {
+/// The records and global hashes of one source of a parallel merge.
+struct HashedSource {
+  std::vector<CVType> Records;
+  std::vector<GloballyHashedType> Hashes;
+  /// The slot of each record in the GHashTable.
+  std::vector<uint32_t> Slots;
+};
+
+/// A fixed-size, open addressing hash table that may be filled from several
+/// threads at once. Each slot holds the position of the first record with a
+/// given hash, encoded as (Source << 32 | Record) + 1, or 0 if it is empty.
+/// Inserting a record which is already present keeps the smaller position, so
+/// the final contents do not depend on the order of insertion.
+class GHashTable {
+public:
+  GHashTable(ArrayRef<HashedSource> Sources, size_t NumRecords)
+      : Sources(Sources) {
+    size_t Capacity = PowerOf2Ceil(std::max<size_t>(NumRecords * 2, 16));
+    Slots.reset(new std::atomic<uint64_t>[Capacity]);
+    for (size_t I = 0; I != Capacity; ++I)
+      Slots[I].store(0, std::memory_order_relaxed);
+    Mask = Capacity - 1;
+  }
+
+  /// Insert the record at \p Position and return its slot.
+  uint32_t insert(GloballyHashedType Hash, uint64_t Position) {
+    uint64_t Key;
+    ::memcpy(&Key, Hash.Hash.data(), sizeof(Key));
+    size_t Idx = Key & Mask;
+    while (true) {
+      uint64_t Cur = Slots[Idx].load(std::memory_order_acquire);
+      if (Cur == 0) {
+        if (Slots[Idx].compare_exchange_strong(Cur, Position + 1))
+          return Idx;
+        // Someone else took the slot; look at what they stored.
+      }
+      if (Cur != 0 && getHash(Cur - 1).Hash == Hash.Hash) {
+        while (Position + 1 < Cur &&
+               !Slots[Idx].compare_exchange_weak(Cur, Position + 1))
+          ;
+        return Idx;
+      }
+      if (Cur != 0)
+        Idx = (Idx + 1) & Mask;
+    }
+  }
+
+  /// Returns the position of the first record stored in \p Slot.
+  uint64_t getFirst(uint32_t Slot) const {
+    return Slots[Slot].load(std::memory_order_relaxed) - 1;
+  }
+
+  size_t capacity() const { return Mask + 1; }
+
+private:
+  GloballyHashedType getHash(uint64_t Position) const {
+    return Sources[Position >> 32].Hashes[Position & 0xffffffff];
+  }
+
+  ArrayRef<HashedSource> Sources;
+  std::unique_ptr<std::atomic<uint64_t>[]> Slots;
+  size_t Mask;
+};
+} // end anonymous namespace
+
+/// Collect and hash the records of \p Types, checking that they can be merged
+/// without the fallbacks of TypeStreamMerger.
+static Error hashSource(const CVTypeArray &Types, HashedSource &Result) {
+  BinaryStreamRef Stream = Types.getUnderlyingStream();
+  ArrayRef<uint8_t> Buffer;
+  if (auto EC = Stream.readBytes(0, Stream.getLength(), Buffer))
+    return EC;
+
+  SmallVector<TiReference, 4> Refs;
+  if (auto EC = forEachCodeViewRecord<CVType>(Buffer, [&](const CVType &T)
+                                                  -> Error {
+        if (T.kind() == LF_TYPESERVER2 || T.kind() == LF_PRECOMP ||
+            T.kind() == LF_ENDPRECOMP)
+          return make_error<CodeViewError>(
+              cv_error_code::operation_unsupported,
+              "type servers and precompiled headers can't be merged in "
+              "parallel");
+        // Id records go to the IPI stream, and the caller has to merge them
+        // with mergeIdRecords() once the types are merged.
+        if (isIdRecord(T.kind()))
+          return make_error<CodeViewError>(
+              cv_error_code::operation_unsupported,
+              "id records can't be merged into a type stream");
+
+        // Every reference has to point to an earlier record, so that its
+        // destination index is known by the time the record is copied.
+        Refs.clear();
+        discoverTypeIndices(T.RecordData, Refs);
+        const uint8_t *Content = T.RecordData.data() + sizeof(RecordPrefix);
+        for (const TiReference &Ref : Refs) {
+          const TypeIndex *TIs =
+              reinterpret_cast<const TypeIndex *>(Content + Ref.Offset);
+          for (uint32_t I = 0; I < Ref.Count; ++I)
+            if (!TIs[I].isSimple() &&
+                slotForIndex(TIs[I]) >= Result.Records.size())
+              return make_error<CodeViewError>(
+                  cv_error_code::corrupt_record,
+                  "type record refers to a later or missing record");
+        }
+        Result.Records.push_back(T);
+        return Error::success();
+      }))
+    return EC;
+
+  Result.Hashes = GloballyHashedType::hashTypes(Result.Records);
+  return Error::success();
+}
+
+Error llvm::codeview::mergeTypeRecordsInParallel(
+    GlobalTypeTableBuilder &Dest,
+    std::vector<SmallVector<TypeIndex, 0>> &SourceToDest,
+    ArrayRef<CVTypeArray> Sources, unsigned NumThreads) {
+  std::vector<HashedSource> Hashed(Sources.size());
+  std::vector<Optional<Error>> Errors(Sources.size());
+  ThreadPool Pool(std::max(1U, NumThreads));
+
+  // Phase 1: hash every source independently.
+  for (size_t S = 0; S != Sources.size(); ++S)
+    Pool.async([&, S] {
+      if (Error E = hashSource(Sources[S], Hashed[S]))
+        Errors[S] = std::move(E);
+    });
+  Pool.wait();
+  Error Err = Error::success();
+  for (Optional<Error> &E : Errors)
+    if (E)
+      Err = joinErrors(std::move(Err), std::move(*E));
+  if (Err)
+    return Err;
+
+  size_t NumRecords = 0;
+  for (const HashedSource &H : Hashed)
+    NumRecords += H.Records.size();
+  if (NumRecords > UINT32_MAX / 2)
+    return make_error<CodeViewError>(cv_error_code::insufficient_buffer,
+                                     "too many type records");
+
+  // Phase 2: find the first occurrence of every hash, concurrently.
+  GHashTable Table(Hashed, NumRecords);
+  for (size_t S = 0; S != Hashed.size(); ++S)
+    Pool.async([&, S] {
+      HashedSource &H = Hashed[S];
+      H.Slots.resize(H.Records.size());
+      for (size_t R = 0; R != H.Records.size(); ++R)
+        H.Slots[R] = Table.insert(H.Hashes[R], uint64_t(S) << 32 | R);
+    });
+  Pool.wait();
+
+  // Copy the first occurrences into Dest in source order, which assigns the
+  // same indices as merging the sources one after another would. Any other
+  // occurrence follows its first one, whose index is known by then.
+  std::vector<TypeIndex> SlotIndices(Table.capacity());
+  SourceToDest.clear();
+  SourceToDest.resize(Sources.size());
+  for (size_t S = 0; S != Hashed.size(); ++S) {
+    HashedSource &H = Hashed[S];
+    SmallVectorImpl<TypeIndex> &Map = SourceToDest[S];
+    Map.reserve(H.Records.size());
+    for (size_t R = 0; R != H.Records.size(); ++R) {
+      uint32_t Slot = H.Slots[R];
+      if (Table.getFirst(Slot) != (uint64_t(S) << 32 | R)) {
+        Map.push_back(SlotIndices[Slot]);
+        continue;
+      }
+
+      const CVType &Type = H.Records[R];
+      auto DoSerialize = [&](MutableArrayRef<uint8_t> Storage) {
+        ::memcpy(Storage.data(), Type.RecordData.data(),
+                 Type.RecordData.size());
+        SmallVector<TiReference, 4> Refs;
+        discoverTypeIndices(Type.RecordData, Refs);
+        uint8_t *Content = Storage.data() + sizeof(RecordPrefix);
+        for (const TiReference &Ref : Refs) {
+          TypeIndex *TIs = reinterpret_cast<TypeIndex *>(Content + Ref.Offset);
+          for (uint32_t I = 0; I < Ref.Count; ++I)
+            if (!TIs[I].isSimple())
+              TIs[I] = Map[slotForIndex(TIs[I])];
+        }
+        return ArrayRef<uint8_t>(Storage);
+      };
+      TypeIndex Idx =
+          Dest.insertRecordAs(H.Hashes[R], Type.RecordData.size(), DoSerialize);
+      SlotIndices[Slot] = Idx;
+      Map.push_back(Idx);
+    }
+    // The records and hashes of this source are no longer needed.
+    H = HashedSource();
+  }
+  return Error::success();
+}
@@ -24,6 +24,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugLine.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugLoc.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugMacro.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugNamesBuilder.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugPubTable.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugRnglists.h"
@@ -885,6 +886,11 @@ void DWARFContext::parseNormalUnits() {
   });
 }
 
+void DWARFContext::extractNormalUnitDIEs(unsigned NumThreads) {
+  parseNormalUnits();
+  NormalUnits.extractDIEs(NumThreads);
+}
+
 void DWARFContext::parseDWOUnits(bool Lazy) {
   if (!DWOUnits.empty())
     return;
@@ -939,6 +945,67 @@ DWARFContext::DIEsForAddress DWARFContext::getDIEsForAddress(uint64_t Address) {
   return Result;
 }
 
+static void getDies(DWARFContext &DICtx, const AppleAcceleratorTable &Accel,
+                    StringRef Name, SmallVectorImpl<DWARFDie> &Dies) {
+  for (const auto &Entry : Accel.equal_range(Name)) {
+    if (Optional<uint64_t> Off = Entry.getDIESectionOffset()) {
+      if (DWARFDie Die = DICtx.getDIEForOffset(*Off))
+        Dies.push_back(Die);
+    }
+  }
+}
+
+static DWARFDie toDie(const DWARFDebugNames::Entry &Entry,
+                      DWARFContext &DICtx) {
+  Optional<uint64_t> CUOff = Entry.getCUOffset();
+  Optional<uint64_t> Off = Entry.getDIEUnitOffset();
+  if (!CUOff || !Off)
+    return DWARFDie();
+
+  DWARFCompileUnit *CU = DICtx.getCompileUnitForOffset(*CUOff);
+  if (!CU)
+    return DWARFDie();
+
+  if (Optional<uint64_t> DWOId = CU->getDWOId()) {
+    // This is a skeleton unit. Look up the DIE in the DWO unit.
+    CU = DICtx.getDWOCompileUnitForHash(*DWOId);
+    if (!CU)
+      return DWARFDie();
+  }
+
+  return CU->getDIEForOffset(CU->getOffset() + *Off);
+}
+
+static void getDies(DWARFContext &DICtx, const DWARFDebugNames &Accel,
+                    StringRef Name, SmallVectorImpl<DWARFDie> &Dies) {
+  for (const auto &Entry : Accel.equal_range(Name)) {
+    if (DWARFDie Die = toDie(Entry, DICtx))
+      Dies.push_back(Die);
+  }
+}
+
+void DWARFContext::getDIEsForName(StringRef Name,
+                                  SmallVectorImpl<DWARFDie> &Dies) {
+  if (!DObj->getAppleNamesSection().Data.empty() ||
+      !DObj->getAppleTypesSection().Data.empty() ||
+      !DObj->getAppleNamespacesSection().Data.empty() ||
+      !DObj->getDebugNamesSection().Data.empty()) {
+    getDies(*this, getAppleNames(), Name, Dies);
+    getDies(*this, getAppleTypes(), Name, Dies);
+    getDies(*this, getAppleNamespaces(), Name, Dies);
+    getDies(*this, getDebugNames(), Name, Dies);
+  } else {
+    for (const auto &CU : compile_units())
+      for (const DWARFDebugInfoEntry &Entry : CU->dies()) {
+        DWARFDie Die(CU.get(), &Entry);
+        if (is_contained(getDebugNamesIndexNames(Die), Name))
+          Dies.push_back(Die);
+      }
+  }
+  llvm::sort(Dies);
+  Dies.erase(std::unique(Dies.begin(), Dies.end()), Dies.end());
+}
+
 static bool getFunctionNameAndStartLineForAddress(DWARFCompileUnit *CU,
                                                   uint64_t Address,
                                                   FunctionNameKind Kind,
@@ -0,0 +1,359 @@
+//===- DWARFDebugNamesBuilder.cpp -----------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/DWARF/DWARFDebugNamesBuilder.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDie.h"
+#include "llvm/DebugInfo/DWARF/DWARFExpression.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+using namespace dwarf;
+
+static bool isVariableIndexable(const DWARFDie &Die, DWARFContext &DCtx) {
+  Optional<DWARFFormValue> Location = Die.findRecursively(DW_AT_location);
+  if (!Location)
+    return false;
+
+  auto ContainsInterestingOperators = [&](StringRef D) {
+    DWARFUnit *U = Die.getDwarfUnit();
+    DataExtractor Data(D, DCtx.isLittleEndian(), U->getAddressByteSize());
+    DWARFExpression Expression(Data, U->getVersion(), U->getAddressByteSize());
+    return any_of(Expression, [](DWARFExpression::Operation &Op) {
+      return !Op.isError() && (Op.getCode() == DW_OP_addr ||
+                               Op.getCode() == DW_OP_form_tls_address ||
+                               Op.getCode() == DW_OP_GNU_push_tls_address);
+    });
+  };
+
+  if (Optional<ArrayRef<uint8_t>> Expr = Location->getAsBlock()) {
+    // Inlined location.
+    if (ContainsInterestingOperators(toStringRef(*Expr)))
+      return true;
+  } else if (Optional<uint64_t> Offset = Location->getAsSectionOffset()) {
+    // Location list.
+    if (const DWARFDebugLoc *DebugLoc = DCtx.getDebugLoc()) {
+      if (const DWARFDebugLoc::LocationList *LocList =
+              DebugLoc->getLocationListAtOffset(*Offset)) {
+        if (any_of(LocList->Entries, [&](const DWARFDebugLoc::Entry &E) {
+              return ContainsInterestingOperators({E.Loc.data(), E.Loc.size()});
+            }))
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+SmallVector<StringRef, 2> llvm::getDebugNamesIndexNames(const DWARFDie &Die) {
+  SmallVector<StringRef, 2> Result;
+
+  // "All non-defining declarations (that is, debugging information entries
+  // with a DW_AT_declaration attribute) are excluded."
+  if (Die.find(DW_AT_declaration))
+    return Result;
+
+  // We deviate from the specification here, which says:
+  // "The name index must contain an entry for each debugging information entry
+  // that defines a named subprogram, label, variable, type, or namespace,
+  // subject to ..."
+  // Instead whitelisting all TAGs representing a "type" or a "subprogram", to
+  // make sure we catch any missing items, we instead blacklist all TAGs that we
+  // know shouldn't be indexed.
+  switch (Die.getTag()) {
+  // Compile units and modules have names but shouldn't be indexed.
+  case DW_TAG_compile_unit:
+  case DW_TAG_module:
+    return Result;
+
+  // Function and template parameters are not globally visible, so we shouldn't
+  // index them.
+  case DW_TAG_formal_parameter:
+  case DW_TAG_template_value_parameter:
+  case DW_TAG_template_type_parameter:
+  case DW_TAG_GNU_template_parameter_pack:
+  case DW_TAG_GNU_template_template_param:
+    return Result;
+
+  // Object members aren't globally visible.
+  case DW_TAG_member:
+    return Result;
+
+  // According to a strict reading of the specification, enumerators should not
+  // be indexed (and LLVM currently does not do that). However, this causes
+  // problems for the debuggers, so we may need to reconsider this.
+  case DW_TAG_enumerator:
+    return Result;
+
+  // Imported declarations should not be indexed according to the specification
+  // and LLVM currently does not do that.
+  case DW_TAG_imported_declaration:
+    return Result;
+
+  // "DW_TAG_subprogram, DW_TAG_inlined_subroutine, and DW_TAG_label debugging
+  // information entries without an address attribute (DW_AT_low_pc,
+  // DW_AT_high_pc, DW_AT_ranges, or DW_AT_entry_pc) are excluded."
+  case DW_TAG_subprogram:
+  case DW_TAG_inlined_subroutine:
+  case DW_TAG_label:
+    if (Die.findRecursively(
+            {DW_AT_low_pc, DW_AT_high_pc, DW_AT_ranges, DW_AT_entry_pc}))
+      break;
+    return Result;
+
+  // "DW_TAG_variable debugging information entries with a DW_AT_location
+  // attribute that includes a DW_OP_addr or DW_OP_form_tls_address operator are
+  // included; otherwise, they are excluded."
+  //
+  // LLVM extension: We also add DW_OP_GNU_push_tls_address to this list.
+  case DW_TAG_variable:
+    if (isVariableIndexable(Die, Die.getDwarfUnit()->getContext()))
+      break;
+    return Result;
+
+  default:
+    break;
+  }
+
+  // "DW_TAG_namespace debugging information entries without a DW_AT_name
+  // attribute are included with the name “(anonymous namespace)”.
+  // All other debugging information entries without a DW_AT_name attribute
+  // are excluded."
+  if (const char *Str = Die.getName(DINameKind::ShortName))
+    Result.emplace_back(Str);
+  else if (Die.getTag() == DW_TAG_namespace)
+    Result.emplace_back("(anonymous namespace)");
+
+  // "If a subprogram or inlined subroutine is included, and has a
+  // DW_AT_linkage_name attribute, there will be an additional index entry for
+  // the linkage name."
+  // As the verifier always has, this also indexes subprograms that only have
+  // a linkage name.
+  if (Die.getTag() == DW_TAG_subprogram ||
+      Die.getTag() == DW_TAG_inlined_subroutine) {
+    if (const char *Str = Die.getName(DINameKind::LinkageName)) {
+      if (Result.empty() || Result[0] != Str)
+        Result.emplace_back(Str);
+    }
+  }
+  return Result;
+}
+
+namespace {
+struct IndexEntry {
+  uint32_t CUIndex;
+  uint32_t DieUnitOffset;
+  Tag DieTag;
+};
+
+/// The names collected from a single compile unit, in DIE order.
+struct UnitNames {
+  std::vector<std::pair<StringRef, IndexEntry>> Names;
+  unsigned NumSkipped = 0;
+};
+
+struct NameData {
+  uint32_t StrOffset;
+  uint32_t Hash;
+  std::vector<IndexEntry> Entries;
+};
+} // end anonymous namespace
+
+static void collectUnitNames(DWARFUnit &U, uint32_t CUIndex,
+                             StringRef StrSection, StringRef AnonNamespace,
+                             UnitNames &Result) {
+  for (const DWARFDebugInfoEntry &Entry : U.dies()) {
+    DWARFDie Die(&U, &Entry);
+    for (StringRef Name : getDebugNamesIndexNames(Die)) {
+      // Strings read from .debug_str point into the section contents; all
+      // others have no string offset the index could refer to.
+      if (Name.data() < StrSection.begin() || Name.data() >= StrSection.end()) {
+        if (Die.getTag() != DW_TAG_namespace || AnonNamespace.empty() ||
+            Name != AnonNamespace) {
+          ++Result.NumSkipped;
+          continue;
+        }
+        Name = AnonNamespace;
+      }
+      Result.Names.push_back(
+          {Name, {CUIndex, Die.getOffset() - U.getOffset(), Die.getTag()}});
+    }
+  }
+}
+
+/// Same heuristic as the AsmPrinter uses when emitting accelerator tables.
+static uint32_t computeBucketCount(const std::vector<NameData> &Names) {
+  std::vector<uint32_t> Uniques;
+  Uniques.reserve(Names.size());
+  for (const NameData &N : Names)
+    Uniques.push_back(N.Hash);
+  array_pod_sort(Uniques.begin(), Uniques.end());
+  size_t UniqueHashCount =
+      std::unique(Uniques.begin(), Uniques.end()) - Uniques.begin();
+
+  if (UniqueHashCount > 1024)
+    return UniqueHashCount / 4;
+  if (UniqueHashCount > 16)
+    return UniqueHashCount / 2;
+  return std::max<uint32_t>(UniqueHashCount, 1);
+}
+
+Error llvm::writeDebugNames(DWARFContext &DICtx, raw_ostream &OS,
+                            unsigned NumThreads, unsigned &NumSkipped) {
+  NumSkipped = 0;
+  StringRef StrSection = DICtx.getDWARFObj().getStringSection();
+  if (StrSection.size() > UINT32_MAX)
+    return createStringError(errc::invalid_argument,
+                             ".debug_str is too large for a 32-bit index");
+
+  unsigned NumCUs = DICtx.getNumCompileUnits();
+  if (NumCUs == 0)
+    return createStringError(errc::invalid_argument,
+                             "no compile units to index");
+
+  // Anonymous namespaces are indexed under a fixed name that is usually not
+  // referenced by any DIE, but may still be present in the string table.
+  StringRef AnonNamespace;
+  size_t AnonPos = StrSection.find(StringRef("(anonymous namespace)\0", 22));
+  if (AnonPos != StringRef::npos &&
+      (AnonPos == 0 || StrSection[AnonPos - 1] == '\0'))
+    AnonNamespace = StrSection.substr(AnonPos, 21);
+
+  // The location lists consulted for variables are parsed lazily by the
+  // context, so do that before the units are handed out to other threads.
+  DICtx.getDebugLoc();
+  DICtx.extractNormalUnitDIEs(NumThreads);
+
+  std::vector<UnitNames> PerUnit(NumCUs);
+  {
+    ThreadPool Pool(std::max(1U, std::min(NumThreads, NumCUs)));
+    uint32_t CUIndex = 0;
+    for (const auto &CU : DICtx.compile_units()) {
+      DWARFUnit *Unit = CU.get();
+      UnitNames *Result = &PerUnit[CUIndex];
+      Pool.async([=] {
+        collectUnitNames(*Unit, CUIndex, StrSection, AnonNamespace, *Result);
+      });
+      ++CUIndex;
+    }
+    Pool.wait();
+  }
+
+  // Merge the names in unit order, so that the entries of every name are
+  // listed in the order of the DIEs they refer to.
+  std::vector<NameData> Names;
+  StringMap<uint32_t> NameIndices;
+  for (UnitNames &U : PerUnit) {
+    NumSkipped += U.NumSkipped;
+    for (const auto &N : U.Names) {
+      auto P = NameIndices.insert({N.first, Names.size()});
+      if (P.second)
+        Names.push_back({uint32_t(N.first.data() - StrSection.data()),
+                         caseFoldingDjbHash(N.first), {}});
+      Names[P.first->second].Entries.push_back(N.second);
+    }
+    U.Names.clear();
+  }
+
+  uint32_t BucketCount = computeBucketCount(Names);
+  std::stable_sort(Names.begin(), Names.end(),
+                   [&](const NameData &LHS, const NameData &RHS) {
+                     return std::make_pair(LHS.Hash % BucketCount, LHS.Hash) <
+                            std::make_pair(RHS.Hash % BucketCount, RHS.Hash);
+                   });
+
+  // A single unit is implied when there is no DW_IDX_compile_unit.
+  bool NeedsCUIndex = NumCUs > 1;
+
+  // Build the abbreviation table (one abbreviation per tag) and the entry
+  // pool.
+  support::endianness Endian =
+      DICtx.isLittleEndian() ? support::little : support::big;
+  SmallString<0> Abbrevs;
+  SmallString<0> Pool;
+  raw_svector_ostream AbbrevOS(Abbrevs);
+  raw_svector_ostream PoolOS(Pool);
+  support::endian::Writer PoolWriter(PoolOS, Endian);
+  DenseMap<unsigned, uint32_t> AbbrevCodes;
+  std::vector<uint32_t> EntryOffsets;
+  EntryOffsets.reserve(Names.size());
+  for (const NameData &N : Names) {
+    EntryOffsets.push_back(Pool.size());
+    for (const IndexEntry &E : N.Entries) {
+      auto P = AbbrevCodes.insert({E.DieTag, AbbrevCodes.size() + 1});
+      if (P.second) {
+        encodeULEB128(P.first->second, AbbrevOS);
+        encodeULEB128(E.DieTag, AbbrevOS);
+        if (NeedsCUIndex) {
+          encodeULEB128(DW_IDX_compile_unit, AbbrevOS);
+          encodeULEB128(DW_FORM_data4, AbbrevOS);
+        }
+        encodeULEB128(DW_IDX_die_offset, AbbrevOS);
+        encodeULEB128(DW_FORM_ref4, AbbrevOS);
+        encodeULEB128(0, AbbrevOS);
+        encodeULEB128(0, AbbrevOS);
+      }
+      encodeULEB128(P.first->second, PoolOS);
+      if (NeedsCUIndex)
+        PoolWriter.write<uint32_t>(E.CUIndex);
+      PoolWriter.write<uint32_t>(E.DieUnitOffset);
+    }
+    // End of the list of entries for this name.
+    encodeULEB128(0, PoolOS);
+  }
+  // End of the abbreviation table.
+  encodeULEB128(0, AbbrevOS);
+
+  std::vector<uint32_t> Buckets(BucketCount);
+  for (size_t I = Names.size(); I != 0; --I)
+    Buckets[Names[I - 1].Hash % BucketCount] = I;
+
+  uint32_t NameCount = Names.size();
+  uint64_t Size = 2 + 2 + 4 * 7 + 4 * NumCUs + 4 * BucketCount +
+                  3 * 4 * NameCount + Abbrevs.size() + Pool.size();
+  if (Size > UINT32_MAX)
+    return createStringError(errc::invalid_argument,
+                             "name index exceeds the DWARF32 size limit");
+
+  support::endian::Writer W(OS, Endian);
+  W.write<uint32_t>(Size);
+  W.write<uint16_t>(5); // Version
+  W.write<uint16_t>(0); // Padding
+  W.write<uint32_t>(NumCUs);
+  W.write<uint32_t>(0); // Local type units
+  W.write<uint32_t>(0); // Foreign type units
+  W.write<uint32_t>(BucketCount);
+  W.write<uint32_t>(NameCount);
+  W.write<uint32_t>(Abbrevs.size());
+  W.write<uint32_t>(0); // Augmentation string size
+  for (const auto &CU : DICtx.compile_units())
+    W.write<uint32_t>(CU->getOffset());
+  for (uint32_t Bucket : Buckets)
+    W.write<uint32_t>(Bucket);
+  for (const NameData &N : Names)
+    W.write<uint32_t>(N.Hash);
+  for (const NameData &N : Names)
+    W.write<uint32_t>(N.StrOffset);
+  for (uint32_t Offset : EntryOffsets)
+    W.write<uint32_t>(Offset);
+  OS << Abbrevs << Pool;
+  return Error::success();
+}
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/DebugInfo/DWARF/DWARFUnit.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/DWARF/DWARFAbbreviationDeclaration.h"
@@ -22,6 +23,7 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/WithColor.h"
 #include <algorithm>
 #include <cassert>
@@ -127,6 +129,28 @@ DWARFUnit *DWARFUnitVector::addUnit(std::unique_ptr<DWARFUnit> Unit) {
   return this->insert(I, std::move(Unit))->get();
 }
 
+void DWARFUnitVector::extractDIEs(unsigned NumThreads) {
+  NumThreads = std::min<unsigned>(NumThreads, size());
+  if (NumThreads <= 1) {
+    for (const auto &U : *this)
+      U->getNumDIEs();
+    return;
+  }
+
+  // Resolve the abbreviation sets up front: they live in a table shared by
+  // all units of the context, while everything else a unit touches during
+  // extraction is private to it.
+  for (const auto &U : *this)
+    U->getAbbreviations();
+
+  ThreadPool Pool(NumThreads);
+  for (const auto &U : *this) {
+    DWARFUnit *Unit = U.get();
+    Pool.async([Unit] { Unit->getNumDIEs(); });
+  }
+  Pool.wait();
+}
+
 DWARFUnit *DWARFUnitVector::getUnitForOffset(uint32_t Offset) const {
   auto end = begin() + getNumInfoUnits();
   auto *CU =
@@ -397,17 +421,52 @@ void DWARFUnit::extractDIEsToVector(
                                    getOffset(), DIEOffset);
 }
 
+DWARFDie DWARFUnit::getUnitDIE(bool ExtractUnitDIEOnly) {
+  extractDIEsIfNeeded(ExtractUnitDIEOnly);
+  // Until all DIEs are extracted, another thread may replace DieArray.
+  std::unique_lock<std::recursive_mutex> Lock(ExtractionMutex,
+                                              std::defer_lock);
+  if (!AllDIEsExtracted.load(std::memory_order_acquire))
+    Lock.lock();
+  if (DieArray.empty())
+    return DWARFDie();
+  return DWARFDie(this, &DieArray[0]);
+}
+
 size_t DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
+  if (AllDIEsExtracted.load(std::memory_order_acquire) ||
+      (CUDieOnly && UnitDIEExtracted.load(std::memory_order_acquire)))
+    return 0; // Already parsed.
+
+  std::lock_guard<std::recursive_mutex> Lock(ExtractionMutex);
   if ((CUDieOnly && !DieArray.empty()) ||
       DieArray.size() > 1)
     return 0; // Already parsed.
 
   bool HasCUDie = !DieArray.empty();
-  extractDIEsToVector(!HasCUDie, !CUDieOnly, DieArray);
+  if (HasCUDie) {
+    // Other threads may be reading the unit DIE already. Extract the whole
+    // unit into a new vector instead of appending to DieArray, which could
+    // reallocate it under them.
+    std::vector<DWARFDebugInfoEntry> Dies;
+    extractDIEsToVector(true, true, Dies);
+    RetiredDieArrays.push_back(std::move(DieArray));
+    DieArray = std::move(Dies);
+  } else {
+    extractDIEsToVector(true, !CUDieOnly, DieArray);
+  }
 
   if (DieArray.empty())
     return 0;
 
+  // The flags are only published on return, after the attributes below have
+  // been copied out of the unit DIE.
+  auto Publish = make_scope_exit([&] {
+    UnitDIEExtracted.store(true, std::memory_order_release);
+    if (!CUDieOnly)
+      AllDIEsExtracted.store(true, std::memory_order_release);
+  });
+
   // If CU DIE was just parsed, copy several attribute values from it.
   if (!HasCUDie) {
     DWARFDie UnitDie = getUnitDIE();
@@ -526,10 +585,14 @@ bool DWARFUnit::parseDWO() {
 }
 
 void DWARFUnit::clearDIEs(bool KeepCUDie) {
+  AllDIEsExtracted.store(false, std::memory_order_relaxed);
+  UnitDIEExtracted.store(KeepCUDie && !DieArray.empty(),
+                         std::memory_order_relaxed);
   if (DieArray.size() > (unsigned)KeepCUDie) {
     DieArray.resize((unsigned)KeepCUDie);
     DieArray.shrink_to_fit();
   }
+  RetiredDieArrays.clear();
 }
 
 Expected<DWARFAddressRangesVector>
@@ -740,16 +803,22 @@ DWARFDie DWARFUnit::getLastChild(const DWARFDebugInfoEntry *Die) {
 }
 
 const DWARFAbbreviationDeclarationSet *DWARFUnit::getAbbreviations() const {
-  if (!Abbrevs)
-    Abbrevs = Abbrev->getAbbreviationDeclarationSet(Header.getAbbrOffset());
-  return Abbrevs;
+  // Racing threads look up the same set, so whichever store wins is fine.
+  const DWARFAbbreviationDeclarationSet *Set =
+      Abbrevs.load(std::memory_order_acquire);
+  if (!Set) {
+    Set = Abbrev->getAbbreviationDeclarationSet(Header.getAbbrOffset());
+    Abbrevs.store(Set, std::memory_order_release);
+  }
+  return Set;
 }
 
 llvm::Optional<SectionedAddress> DWARFUnit::getBaseAddress() {
+  DWARFDie UnitDie = getUnitDIE();
+  std::lock_guard<std::recursive_mutex> Lock(ExtractionMutex);
   if (BaseAddr)
     return BaseAddr;
 
-  DWARFDie UnitDie = getUnitDIE();
   Optional<DWARFFormValue> PC = UnitDie.find({DW_AT_low_pc, DW_AT_entry_pc});
   BaseAddr = toSectionedAddress(PC);
   return BaseAddr;
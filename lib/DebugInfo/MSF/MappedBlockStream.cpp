@@ -108,41 +108,34 @@ Error MappedBlockStream::readBytes(uint32_t Offset, uint32_t Size,
 
   // We couldn't find a buffer that started at the correct offset (the most
   // common scenario).  Try to see if there is a buffer that starts at some
-  // other offset but overlaps the desired range.
-  for (auto &CacheItem : CacheMap) {
-    Interval RequestExtent = std::make_pair(Offset, Offset + Size);
-
-    // We already checked this one on the fast path above.
-    if (CacheItem.first == Offset)
-      continue;
-    // If the initial extent of the cached item is beyond the ending extent
-    // of the request, there is no overlap.
-    if (CacheItem.first >= Offset + Size)
-      continue;
-
-    // We really only have to check the last item in the list, since we append
-    // in order of increasing length.
-    if (CacheItem.second.empty())
-      continue;
+  // other offset but overlaps the desired range.  Only buffers starting at
+  // most MaxCacheEntrySize bytes before the end of the request can contain
+  // it, so walk backwards from the request until we pass that point.
+  if (Size <= MaxCacheEntrySize) {
+    uint64_t End = uint64_t(Offset) + Size;
+    uint64_t MinStart = End > MaxCacheEntrySize ? End - MaxCacheEntrySize : 0;
+    for (auto It = CacheMap.upper_bound(Offset); It != CacheMap.begin();) {
+      --It;
+      if (It->first < MinStart)
+        break;
+      // We already checked this one on the fast path above.
+      if (It->first == Offset)
+        continue;
 
-    auto CachedAlloc = CacheItem.second.back();
-    // If the initial extent of the request is beyond the ending extent of
-    // the cached item, there is no overlap.
-    Interval CachedExtent =
-        std::make_pair(CacheItem.first, CacheItem.first + CachedAlloc.size());
-    if (RequestExtent.first >= CachedExtent.first + CachedExtent.second)
-      continue;
+      // We really only have to check the last item in the list, since we
+      // append in order of increasing length.
+      if (It->second.empty())
+        continue;
 
-    Interval Intersection = intersect(CachedExtent, RequestExtent);
-    // Only use this if the entire request extent is contained in the cached
-    // extent.
-    if (Intersection != RequestExtent)
-      continue;
+      auto CachedAlloc = It->second.back();
+      // Only use this if the entire request extent is contained in the cached
+      // extent.
+      if (It->first + CachedAlloc.size() < End)
+        continue;
 
-    uint32_t CacheRangeOffset =
-        AbsoluteDifference(CachedExtent.first, Intersection.first);
-    Buffer = CachedAlloc.slice(CacheRangeOffset, Size);
-    return Error::success();
+      Buffer = CachedAlloc.slice(Offset - It->first, Size);
+      return Error::success();
+    }
   }
 
   // Otherwise allocate a large enough buffer in the pool, memcpy the data
@@ -160,6 +153,7 @@ Error MappedBlockStream::readBytes(uint32_t Offset, uint32_t Size,
     List.emplace_back(WriteBuffer, Size);
     CacheMap.insert(std::make_pair(Offset, List));
   }
+  MaxCacheEntrySize = std::max(MaxCacheEntrySize, Size);
   Buffer = ArrayRef<uint8_t>(WriteBuffer, Size);
   return Error::success();
 }
@@ -270,7 +264,10 @@ Error MappedBlockStream::readBytes(uint32_t Offset,
   return Error::success();
 }
 
-void MappedBlockStream::invalidateCache() { CacheMap.shrink_and_clear(); }
+void MappedBlockStream::invalidateCache() {
+  CacheMap.clear();
+  MaxCacheEntrySize = 0;
+}
 
 void MappedBlockStream::fixCacheAfterWrite(uint32_t Offset,
                                            ArrayRef<uint8_t> Data) const {
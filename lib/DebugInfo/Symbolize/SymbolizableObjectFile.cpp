@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "SymbolizableObjectFile.h"
+#include "SymbolizerCache.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
@@ -24,6 +25,8 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
 #include <cstdint>
 #include <memory>
@@ -44,9 +47,10 @@ getDILineInfoSpecifier(FunctionNameKind FNKind) {
 
 ErrorOr<std::unique_ptr<SymbolizableObjectFile>>
 SymbolizableObjectFile::create(object::ObjectFile *Obj,
-                               std::unique_ptr<DIContext> DICtx) {
-  std::unique_ptr<SymbolizableObjectFile> res(
-      new SymbolizableObjectFile(Obj, std::move(DICtx)));
+                               std::unique_ptr<DIContext> DICtx,
+                               DIContextFactory CreateWorkerContext) {
+  std::unique_ptr<SymbolizableObjectFile> res(new SymbolizableObjectFile(
+      Obj, std::move(DICtx), std::move(CreateWorkerContext)));
   std::unique_ptr<DataExtractor> OpdExtractor;
   uint64_t OpdAddress = 0;
   // Find the .opd (function descriptor) section if any, for big-endian
@@ -82,9 +86,11 @@ SymbolizableObjectFile::create(object::ObjectFile *Obj,
   return std::move(res);
 }
 
-SymbolizableObjectFile::SymbolizableObjectFile(ObjectFile *Obj,
-                                               std::unique_ptr<DIContext> DICtx)
-    : Module(Obj), DebugInfoContext(std::move(DICtx)) {}
+SymbolizableObjectFile::SymbolizableObjectFile(
+    ObjectFile *Obj, std::unique_ptr<DIContext> DICtx,
+    DIContextFactory CreateWorkerContext)
+    : Module(Obj), DebugInfoContext(std::move(DICtx)),
+      CreateWorkerContext(std::move(CreateWorkerContext)) {}
 
 namespace {
 
@@ -213,18 +219,28 @@ bool SymbolizableObjectFile::shouldOverrideWithSymbolTable(
   // When DWARF is used with -gline-tables-only / -gmlt, the symbol table gives
   // better answers for linkage names than the DIContext. Otherwise, we are
   // probably using PEs and PDBs, and we shouldn't do the override. PE files
-  // generally only contain the names of exported symbols.
+  // generally only contain the names of exported symbols. A symbolizer cache
+  // is built from DWARF and has the same limitations.
   return FNKind == FunctionNameKind::LinkageName && UseSymbolTable &&
-         isa<DWARFContext>(DebugInfoContext.get());
+         (isa<DWARFContext>(DebugInfoContext.get()) ||
+          isa<SymbolizerCacheContext>(DebugInfoContext.get()));
 }
 
 DILineInfo SymbolizableObjectFile::symbolizeCode(uint64_t ModuleOffset,
                                                  FunctionNameKind FNKind,
                                                  bool UseSymbolTable) const {
+  return symbolizeCode(DebugInfoContext.get(), ModuleOffset, FNKind,
+                       UseSymbolTable);
+}
+
+DILineInfo SymbolizableObjectFile::symbolizeCode(DIContext *DICtx,
+                                                 uint64_t ModuleOffset,
+                                                 FunctionNameKind FNKind,
+                                                 bool UseSymbolTable) const {
   DILineInfo LineInfo;
-  if (DebugInfoContext) {
-    LineInfo = DebugInfoContext->getLineInfoForAddress(
-        ModuleOffset, getDILineInfoSpecifier(FNKind));
+  if (DICtx) {
+    LineInfo = DICtx->getLineInfoForAddress(ModuleOffset,
+                                            getDILineInfoSpecifier(FNKind));
   }
   // Override function name from symbol table if necessary.
   if (shouldOverrideWithSymbolTable(FNKind, UseSymbolTable)) {
@@ -240,10 +256,17 @@ DILineInfo SymbolizableObjectFile::symbolizeCode(uint64_t ModuleOffset,
 
 DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
     uint64_t ModuleOffset, FunctionNameKind FNKind, bool UseSymbolTable) const {
+  return symbolizeInlinedCode(DebugInfoContext.get(), ModuleOffset, FNKind,
+                              UseSymbolTable);
+}
+
+DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
+    DIContext *DICtx, uint64_t ModuleOffset, FunctionNameKind FNKind,
+    bool UseSymbolTable) const {
   DIInliningInfo InlinedContext;
 
-  if (DebugInfoContext)
-    InlinedContext = DebugInfoContext->getInliningInfoForAddress(
+  if (DICtx)
+    InlinedContext = DICtx->getInliningInfoForAddress(
         ModuleOffset, getDILineInfoSpecifier(FNKind));
   // Make sure there is at least one frame in context.
   if (InlinedContext.getNumberOfFrames() == 0)
@@ -263,6 +286,86 @@ DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
   return InlinedContext;
 }
 
+template <typename ResultT, typename ResolverT>
+std::vector<ResultT>
+SymbolizableObjectFile::symbolizeBatch(ArrayRef<uint64_t> ModuleOffsets,
+                                       unsigned NumThreads,
+                                       ResolverT Resolve) const {
+  // Resolving the addresses in increasing order makes consecutive lookups hit
+  // the same compile unit and line table, so every unit is parsed once.
+  std::vector<uint64_t> Addresses(ModuleOffsets.begin(), ModuleOffsets.end());
+  llvm::sort(Addresses);
+  Addresses.erase(std::unique(Addresses.begin(), Addresses.end()),
+                  Addresses.end());
+  std::vector<ResultT> Resolved(Addresses.size());
+
+  // A DWARFContext parses lazily and can't be shared between threads, so
+  // every additional thread needs a context of its own. A symbolizer cache
+  // serializes its queries and is shared.
+  bool ShareContext = isa<SymbolizerCacheContext>(DebugInfoContext.get());
+  if (!ShareContext && !CreateWorkerContext)
+    NumThreads = 1;
+  // Creating a context isn't free; don't bother for tiny chunks.
+  const size_t MinAddressesPerThread = 64;
+  NumThreads = std::max<size_t>(
+      1, std::min<size_t>(NumThreads,
+                          Addresses.size() / MinAddressesPerThread));
+
+  auto ResolveChunk = [&](DIContext *DICtx, size_t Begin, size_t End) {
+    for (size_t I = Begin; I != End; ++I)
+      Resolved[I] = Resolve(DICtx, Addresses[I]);
+  };
+  if (NumThreads == 1) {
+    ResolveChunk(DebugInfoContext.get(), 0, Addresses.size());
+  } else {
+    ThreadPool Pool(NumThreads);
+    size_t ChunkSize = divideCeil(Addresses.size(), NumThreads);
+    for (unsigned T = 0; T != NumThreads; ++T) {
+      size_t Begin = T * ChunkSize;
+      size_t End = std::min(Begin + ChunkSize, Addresses.size());
+      if (Begin >= End)
+        break;
+      Pool.async([&, T, Begin, End] {
+        if (T == 0 || ShareContext) {
+          ResolveChunk(DebugInfoContext.get(), Begin, End);
+          return;
+        }
+        std::unique_ptr<DIContext> WorkerContext = CreateWorkerContext();
+        ResolveChunk(WorkerContext.get(), Begin, End);
+      });
+    }
+    Pool.wait();
+  }
+
+  std::vector<ResultT> Result;
+  Result.reserve(ModuleOffsets.size());
+  for (uint64_t ModuleOffset : ModuleOffsets) {
+    auto It = std::lower_bound(Addresses.begin(), Addresses.end(),
+                               ModuleOffset);
+    Result.push_back(Resolved[It - Addresses.begin()]);
+  }
+  return Result;
+}
+
+std::vector<DILineInfo> SymbolizableObjectFile::symbolizeCodeBatch(
+    ArrayRef<uint64_t> ModuleOffsets, FunctionNameKind FNKind,
+    bool UseSymbolTable, unsigned NumThreads) const {
+  return symbolizeBatch<DILineInfo>(
+      ModuleOffsets, NumThreads, [&](DIContext *DICtx, uint64_t ModuleOffset) {
+        return symbolizeCode(DICtx, ModuleOffset, FNKind, UseSymbolTable);
+      });
+}
+
+std::vector<DIInliningInfo> SymbolizableObjectFile::symbolizeInlinedCodeBatch(
+    ArrayRef<uint64_t> ModuleOffsets, FunctionNameKind FNKind,
+    bool UseSymbolTable, unsigned NumThreads) const {
+  return symbolizeBatch<DIInliningInfo>(
+      ModuleOffsets, NumThreads, [&](DIContext *DICtx, uint64_t ModuleOffset) {
+        return symbolizeInlinedCode(DICtx, ModuleOffset, FNKind,
+                                    UseSymbolTable);
+      });
+}
+
 DIGlobal SymbolizableObjectFile::symbolizeData(uint64_t ModuleOffset) const {
   DIGlobal Res;
   getNameFromSymbolTable(SymbolRef::ST_Data, ModuleOffset, Res.Name, Res.Start,
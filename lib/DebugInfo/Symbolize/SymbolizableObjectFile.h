@@ -18,10 +18,12 @@
 #include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
 #include "llvm/Support/ErrorOr.h"
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
 
 namespace llvm {
 
@@ -31,8 +33,13 @@ namespace symbolize {
 
 class SymbolizableObjectFile : public SymbolizableModule {
 public:
+  /// Creates an independent DIContext for the debug info of this module. It
+  /// is called once for every additional thread of a batch query.
+  using DIContextFactory = std::function<std::unique_ptr<DIContext>()>;
+
   static ErrorOr<std::unique_ptr<SymbolizableObjectFile>>
-  create(object::ObjectFile *Obj, std::unique_ptr<DIContext> DICtx);
+  create(object::ObjectFile *Obj, std::unique_ptr<DIContext> DICtx,
+         DIContextFactory CreateWorkerContext = nullptr);
 
   DILineInfo symbolizeCode(uint64_t ModuleOffset, FunctionNameKind FNKind,
                            bool UseSymbolTable) const override;
@@ -41,6 +48,15 @@ public:
                                       bool UseSymbolTable) const override;
   DIGlobal symbolizeData(uint64_t ModuleOffset) const override;
 
+  std::vector<DILineInfo> symbolizeCodeBatch(ArrayRef<uint64_t> ModuleOffsets,
+                                             FunctionNameKind FNKind,
+                                             bool UseSymbolTable,
+                                             unsigned NumThreads) const override;
+  std::vector<DIInliningInfo>
+  symbolizeInlinedCodeBatch(ArrayRef<uint64_t> ModuleOffsets,
+                            FunctionNameKind FNKind, bool UseSymbolTable,
+                            unsigned NumThreads) const override;
+
   // Return true if this is a 32-bit x86 PE COFF module.
   bool isWin32Module() const override;
 
@@ -52,6 +68,20 @@ private:
   bool shouldOverrideWithSymbolTable(FunctionNameKind FNKind,
                                      bool UseSymbolTable) const;
 
+  DILineInfo symbolizeCode(DIContext *DICtx, uint64_t ModuleOffset,
+                           FunctionNameKind FNKind, bool UseSymbolTable) const;
+  DIInliningInfo symbolizeInlinedCode(DIContext *DICtx, uint64_t ModuleOffset,
+                                      FunctionNameKind FNKind,
+                                      bool UseSymbolTable) const;
+
+  /// Resolves the distinct addresses of \p ModuleOffsets in increasing order,
+  /// split into contiguous chunks over up to \p NumThreads threads, and
+  /// returns the results in the order of \p ModuleOffsets.
+  template <typename ResultT, typename ResolverT>
+  std::vector<ResultT> symbolizeBatch(ArrayRef<uint64_t> ModuleOffsets,
+                                      unsigned NumThreads,
+                                      ResolverT Resolve) const;
+
   bool getNameFromSymbolTable(object::SymbolRef::Type Type, uint64_t Address,
                               std::string &Name, uint64_t &Addr,
                               uint64_t &Size) const;
@@ -65,6 +95,7 @@ private:
 
   object::ObjectFile *Module;
   std::unique_ptr<DIContext> DebugInfoContext;
+  DIContextFactory CreateWorkerContext;
 
   struct SymbolDesc {
     uint64_t Addr;
@@ -80,7 +111,8 @@ private:
   std::map<SymbolDesc, StringRef> Objects;
 
   SymbolizableObjectFile(object::ObjectFile *Obj,
-                         std::unique_ptr<DIContext> DICtx);
+                         std::unique_ptr<DIContext> DICtx,
+                         DIContextFactory CreateWorkerContext);
 };
 
 } // end namespace symbolize
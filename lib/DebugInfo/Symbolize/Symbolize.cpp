@@ -14,6 +14,7 @@
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
 
 #include "SymbolizableObjectFile.h"
+#include "SymbolizerCache.h"
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/BinaryFormat/COFF.h"
@@ -134,7 +135,85 @@ Expected<DIGlobal> LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
   return Global;
 }
 
+Expected<std::vector<DILineInfo>>
+LLVMSymbolizer::symbolizeCodeBatch(const std::string &ModuleName,
+                                   ArrayRef<uint64_t> ModuleOffsets,
+                                   StringRef DWPName, unsigned NumThreads) {
+  SymbolizableModule *Info;
+  if (auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName))
+    Info = InfoOrErr.get();
+  else
+    return InfoOrErr.takeError();
+
+  // A null module means an error has already been reported. Return empty
+  // results.
+  if (!Info)
+    return std::vector<DILineInfo>(ModuleOffsets.size());
+
+  std::vector<uint64_t> Offsets(ModuleOffsets.begin(), ModuleOffsets.end());
+  if (Opts.RelativeAddresses)
+    for (uint64_t &Offset : Offsets)
+      Offset += Info->getModulePreferredBase();
+
+  std::vector<DILineInfo> LineInfos = Info->symbolizeCodeBatch(
+      Offsets, Opts.PrintFunctions, Opts.UseSymbolTable, NumThreads);
+  if (Opts.Demangle)
+    for (DILineInfo &LineInfo : LineInfos)
+      LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  return LineInfos;
+}
+
+Expected<std::vector<DIInliningInfo>>
+LLVMSymbolizer::symbolizeInlinedCodeBatch(const std::string &ModuleName,
+                                          ArrayRef<uint64_t> ModuleOffsets,
+                                          StringRef DWPName,
+                                          unsigned NumThreads) {
+  SymbolizableModule *Info;
+  if (auto InfoOrErr = getOrCreateModuleInfo(ModuleName, DWPName))
+    Info = InfoOrErr.get();
+  else
+    return InfoOrErr.takeError();
+
+  // A null module means an error has already been reported. Return empty
+  // results.
+  if (!Info)
+    return std::vector<DIInliningInfo>(ModuleOffsets.size());
+
+  std::vector<uint64_t> Offsets(ModuleOffsets.begin(), ModuleOffsets.end());
+  if (Opts.RelativeAddresses)
+    for (uint64_t &Offset : Offsets)
+      Offset += Info->getModulePreferredBase();
+
+  std::vector<DIInliningInfo> InlinedContexts =
+      Info->symbolizeInlinedCodeBatch(Offsets, Opts.PrintFunctions,
+                                      Opts.UseSymbolTable, NumThreads);
+  if (Opts.Demangle) {
+    for (DIInliningInfo &InlinedContext : InlinedContexts) {
+      for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
+        auto *Frame = InlinedContext.getMutableFrame(i);
+        Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
+      }
+    }
+  }
+  return InlinedContexts;
+}
+
 void LLVMSymbolizer::flush() {
+  for (SymbolizerCacheContext *Cache : CacheContexts) {
+    unsigned NumAddedUnits = Cache->getNumAddedUnits();
+    if (NumAddedUnits == 0)
+      continue;
+    Stats.Misses += NumAddedUnits;
+    // The cache is only an optimization, so failing to write it is not an
+    // error.
+    if (auto Err = Cache->save()) {
+      consumeError(std::move(Err));
+      ++Stats.Errors;
+    } else {
+      ++Stats.Writes;
+    }
+  }
+  CacheContexts.clear();
   ObjectForUBPathAndArch.clear();
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
@@ -417,14 +496,27 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
     }
   }
   if (!Context)
-    Context = DWARFContext::create(*Objects.second, nullptr,
-                                   DWARFContext::defaultErrorHandler, DWPName);
+    Context = createDWARFContext(*Objects.first, *Objects.second, DWPName);
   assert(Context);
-  auto InfoOrErr =
-      SymbolizableObjectFile::create(Objects.first, std::move(Context));
+  // Batch queries parse DWARF on several threads, each with its own context.
+  SymbolizableObjectFile::DIContextFactory CreateWorkerContext;
+  if (isa<DWARFContext>(Context.get())) {
+    ObjectFile *DbgObj = Objects.second;
+    std::string DWP = DWPName;
+    CreateWorkerContext = [DbgObj, DWP]() -> std::unique_ptr<DIContext> {
+      return DWARFContext::create(*DbgObj, nullptr,
+                                  DWARFContext::defaultErrorHandler, DWP);
+    };
+  }
+  auto *Cache = dyn_cast<SymbolizerCacheContext>(Context.get());
+  auto InfoOrErr = SymbolizableObjectFile::create(
+      Objects.first, std::move(Context), std::move(CreateWorkerContext));
   std::unique_ptr<SymbolizableModule> SymMod;
-  if (InfoOrErr)
+  if (InfoOrErr) {
     SymMod = std::move(InfoOrErr.get());
+    if (Cache)
+      CacheContexts.push_back(Cache);
+  }
   auto InsertResult =
       Modules.insert(std::make_pair(ModuleName, std::move(SymMod)));
   assert(InsertResult.second);
@@ -433,6 +525,42 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName,
   return InsertResult.first->second.get();
 }
 
+std::unique_ptr<DIContext>
+LLVMSymbolizer::createDWARFContext(const ObjectFile &Obj,
+                                   const ObjectFile &DbgObj,
+                                   StringRef DWPName) {
+  ArrayRef<uint8_t> BuildID;
+  if (!Opts.CacheDirectory.empty()) {
+    BuildID = getObjectBuildID(&DbgObj);
+    if (BuildID.empty())
+      BuildID = getObjectBuildID(&Obj);
+  }
+  if (BuildID.empty())
+    return DWARFContext::create(DbgObj, nullptr,
+                                DWARFContext::defaultErrorHandler, DWPName);
+
+  // DWARF is only parsed for the compile units the cache doesn't hold yet.
+  std::string CachePath = getSymbolizerCachePath(Opts.CacheDirectory, BuildID);
+  const ObjectFile *DbgObjPtr = &DbgObj;
+  std::string DWP = DWPName;
+  auto Cache = llvm::make_unique<SymbolizerCacheContext>(
+      BuildID, CachePath, [DbgObjPtr, DWP] {
+        return DWARFContext::create(*DbgObjPtr, nullptr,
+                                    DWARFContext::defaultErrorHandler, DWP);
+      });
+  if (auto BufOrErr = MemoryBuffer::getFile(CachePath, /*FileSize=*/-1,
+                                            /*RequiresNullTerminator=*/false)) {
+    if (auto Err = Cache->load(std::move(BufOrErr.get()))) {
+      // A stale or corrupt cache is replaced.
+      consumeError(std::move(Err));
+      ++Stats.Errors;
+    } else {
+      ++Stats.Hits;
+    }
+  }
+  return std::move(Cache);
+}
+
 namespace {
 
 // Undo these various manglings for Win32 extern "C" functions:
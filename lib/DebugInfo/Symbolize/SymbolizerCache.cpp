@@ -0,0 +1,470 @@
+//===- SymbolizerCache.cpp ------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of the on-disk address-to-line index used by LLVMSymbolizer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SymbolizerCache.h"
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/ELF.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace llvm;
+using namespace object;
+using namespace symbolize;
+
+namespace {
+
+template <class ELFT>
+ArrayRef<uint8_t> getELFBuildID(const ELFFile<ELFT> *Obj) {
+  auto PhdrsOrErr = Obj->program_headers();
+  if (!PhdrsOrErr) {
+    consumeError(PhdrsOrErr.takeError());
+    return {};
+  }
+  for (const auto &Phdr : *PhdrsOrErr) {
+    if (Phdr.p_type != ELF::PT_NOTE)
+      continue;
+    Error Err = Error::success();
+    for (const auto &Note : Obj->notes(Phdr, Err))
+      if (Note.getType() == ELF::NT_GNU_BUILD_ID &&
+          Note.getName() == ELF::ELF_NOTE_GNU)
+        return Note.getDesc();
+    consumeError(std::move(Err));
+  }
+  return {};
+}
+
+template <typename T> void writeArray(raw_ostream &OS, ArrayRef<T> Array) {
+  OS.write(reinterpret_cast<const char *>(Array.data()),
+           Array.size() * sizeof(T));
+}
+
+bool sameFrames(ArrayRef<symcache::Frame> LHS, ArrayRef<symcache::Frame> RHS) {
+  return LHS.size() == RHS.size() &&
+         memcmp(LHS.data(), RHS.data(), LHS.size() * sizeof(symcache::Frame)) ==
+             0;
+}
+
+// Returns the entry of the sorted, disjoint ranges \p Ranges that contains
+// \p Address, or null.
+template <typename RangeT>
+const RangeT *findInRanges(ArrayRef<RangeT> Ranges, uint64_t Address) {
+  auto It = std::upper_bound(
+      Ranges.begin(), Ranges.end(), Address,
+      [](uint64_t Address, const RangeT &R) { return Address < R.Start; });
+  if (It == Ranges.begin())
+    return nullptr;
+  --It;
+  return Address < It->End ? &*It : nullptr;
+}
+
+} // end anonymous namespace
+
+ArrayRef<uint8_t> symbolize::getObjectBuildID(const ObjectFile *Obj) {
+  if (!Obj)
+    return {};
+  if (auto *O = dyn_cast<ELF32LEObjectFile>(Obj))
+    return getELFBuildID(O->getELFFile());
+  if (auto *O = dyn_cast<ELF32BEObjectFile>(Obj))
+    return getELFBuildID(O->getELFFile());
+  if (auto *O = dyn_cast<ELF64LEObjectFile>(Obj))
+    return getELFBuildID(O->getELFFile());
+  if (auto *O = dyn_cast<ELF64BEObjectFile>(Obj))
+    return getELFBuildID(O->getELFFile());
+  if (auto *O = dyn_cast<MachOObjectFile>(Obj))
+    return O->getUuid();
+  return {};
+}
+
+std::string symbolize::getSymbolizerCachePath(StringRef CacheDir,
+                                              ArrayRef<uint8_t> BuildID) {
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, toHex(BuildID, /*LowerCase=*/true) + ".symcache");
+  return Path.str();
+}
+
+SymbolizerCacheContext::SymbolizerCacheContext(
+    ArrayRef<uint8_t> BuildID, StringRef Path,
+    DWARFContextFactory CreateDWARFContext)
+    : DIContext(CK_SymbolizerCache), BuildID(BuildID.begin(), BuildID.end()),
+      Path(Path), CreateDWARFContext(std::move(CreateDWARFContext)),
+      Copied(true) {
+  addString("");
+  Strings = StringTable;
+}
+
+SymbolizerCacheContext::~SymbolizerCacheContext() = default;
+
+Error SymbolizerCacheContext::load(std::unique_ptr<MemoryBuffer> NewBuffer) {
+  std::string Name = NewBuffer->getBufferIdentifier();
+  auto Invalid = [&](const char *Reason) {
+    return createStringError(errc::invalid_argument,
+                             "invalid symbolizer cache '%s': %s",
+                             Name.c_str(), Reason);
+  };
+
+  StringRef Data = NewBuffer->getBuffer();
+  if (Data.size() < sizeof(symcache::Header))
+    return Invalid("file too small");
+  const auto *H = reinterpret_cast<const symcache::Header *>(Data.data());
+  if (memcmp(H->Magic, symcache::Magic, sizeof(H->Magic)) != 0)
+    return Invalid("bad magic");
+  if (H->Version != symcache::Version)
+    return Invalid("unsupported version");
+
+  uint64_t Offset = sizeof(symcache::Header);
+  uint64_t UnitRangesOffset = Offset + alignTo(H->BuildIDSize, 8);
+  uint64_t RangesOffset = UnitRangesOffset + uint64_t(H->NumUnitRanges) *
+                                                 sizeof(symcache::UnitRange);
+  uint64_t FramesOffset =
+      RangesOffset + uint64_t(H->NumRanges) * sizeof(symcache::Range);
+  uint64_t StringsOffset =
+      FramesOffset + uint64_t(H->NumFrames) * sizeof(symcache::Frame);
+  if (StringsOffset + H->StringTableSize != Data.size())
+    return Invalid("truncated file");
+  if (Data.substr(Offset, H->BuildIDSize) != toStringRef(BuildID))
+    return Invalid("build ID mismatch");
+
+  auto NewUnitRanges = makeArrayRef(
+      reinterpret_cast<const symcache::UnitRange *>(Data.data() +
+                                                    UnitRangesOffset),
+      H->NumUnitRanges);
+  auto NewRanges = makeArrayRef(
+      reinterpret_cast<const symcache::Range *>(Data.data() + RangesOffset),
+      H->NumRanges);
+  auto NewFrames = makeArrayRef(
+      reinterpret_cast<const symcache::Frame *>(Data.data() + FramesOffset),
+      H->NumFrames);
+  StringRef NewStrings = Data.substr(StringsOffset);
+
+  for (const symcache::Range &R : NewRanges)
+    if (uint64_t(R.FirstFrame) + R.NumFrames > NewFrames.size())
+      return Invalid("frame index out of range");
+  for (const symcache::Frame &F : NewFrames)
+    if (F.LinkageName >= NewStrings.size() ||
+        F.ShortName >= NewStrings.size() || F.FileName >= NewStrings.size())
+      return Invalid("string offset out of range");
+  if (NewStrings.empty() || NewStrings.back() != '\0')
+    return Invalid("unterminated string table");
+
+  Buffer = std::move(NewBuffer);
+  UnitRanges = NewUnitRanges;
+  Ranges = NewRanges;
+  Frames = NewFrames;
+  Strings = NewStrings;
+  Copied = false;
+  UnitRangeTable.clear();
+  RangeTable.clear();
+  FrameTable.clear();
+  StringTable.clear();
+  StringOffsets.clear();
+  return Error::success();
+}
+
+void SymbolizerCacheContext::copyTables() {
+  if (Copied)
+    return;
+  UnitRangeTable.assign(UnitRanges.begin(), UnitRanges.end());
+  RangeTable.assign(Ranges.begin(), Ranges.end());
+  FrameTable.assign(Frames.begin(), Frames.end());
+  StringTable = Strings;
+  for (size_t Offset = 0; Offset < StringTable.size();) {
+    StringRef S(StringTable.data() + Offset);
+    StringOffsets.insert(std::make_pair(S, Offset));
+    Offset += S.size() + 1;
+  }
+  Buffer.reset();
+  Copied = true;
+}
+
+uint32_t SymbolizerCacheContext::addString(StringRef S) {
+  auto Insertion = StringOffsets.insert(std::make_pair(S, StringTable.size()));
+  if (Insertion.second) {
+    StringTable.append(S.begin(), S.end());
+    StringTable.push_back('\0');
+  }
+  return Insertion.first->second;
+}
+
+void SymbolizerCacheContext::addUnitFor(uint64_t Address) {
+  if (!DICtx)
+    DICtx = CreateDWARFContext();
+  uint32_t CUOffset = DICtx->getDebugAranges()->findAddress(Address);
+  if (CUOffset == -1U || AddedUnits.count(CUOffset))
+    return;
+  DWARFCompileUnit *CU = DICtx->getCompileUnitForOffset(CUOffset);
+  if (!CU)
+    return;
+  AddedUnits.insert(CUOffset);
+  copyTables();
+
+  // The addresses of the unit are held from now on, including the ones that
+  // no line table row describes.
+  std::vector<symcache::UnitRange> NewUnitRanges;
+  auto AddUnitRange = [&](uint64_t Start, uint64_t End) {
+    if (Start < End) {
+      NewUnitRanges.emplace_back();
+      NewUnitRanges.back().Start = Start;
+      NewUnitRanges.back().End = End;
+    }
+  };
+  if (auto UnitRangesOrErr = CU->collectAddressRanges()) {
+    for (const DWARFAddressRange &R : *UnitRangesOrErr)
+      AddUnitRange(R.LowPC, R.HighPC);
+  } else {
+    consumeError(UnitRangesOrErr.takeError());
+  }
+
+  DILineInfoSpecifier LinkageSpec(
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+      DILineInfoSpecifier::FunctionNameKind::LinkageName);
+  DILineInfoSpecifier ShortSpec(
+      DILineInfoSpecifier::FileLineInfoKind::None,
+      DILineInfoSpecifier::FunctionNameKind::ShortName);
+
+  std::vector<symcache::Range> NewRanges;
+  std::vector<symcache::Frame> RangeFrames;
+  if (const DWARFDebugLine::LineTable *LineTable =
+          DICtx->getLineTableForUnit(CU)) {
+    for (const DWARFDebugLine::Sequence &Seq : LineTable->Sequences)
+      AddUnitRange(Seq.LowPC, Seq.HighPC);
+
+    // Every row describes the addresses up to the next row of its sequence.
+    // Rather than decoding the row here, ask the context about the row's
+    // address so that the cache returns exactly what a DWARF lookup would.
+    const auto &Rows = LineTable->Rows;
+    for (size_t I = 0, E = Rows.size(); I + 1 < E; ++I) {
+      if (Rows[I].EndSequence || Rows[I].Address >= Rows[I + 1].Address)
+        continue;
+      uint64_t Start = Rows[I].Address;
+      DIInliningInfo Linkage =
+          DICtx->getInliningInfoForAddress(Start, LinkageSpec);
+      DIInliningInfo Short =
+          DICtx->getInliningInfoForAddress(Start, ShortSpec);
+      uint32_t NumFrames = Linkage.getNumberOfFrames();
+      if (NumFrames == 0 || Short.getNumberOfFrames() != NumFrames)
+        continue;
+
+      std::vector<symcache::Frame> Chain(NumFrames);
+      for (uint32_t F = 0; F != NumFrames; ++F) {
+        const DILineInfo &Frame = Linkage.getFrame(F);
+        Chain[F].LinkageName = addString(Frame.FunctionName);
+        Chain[F].ShortName = addString(Short.getFrame(F).FunctionName);
+        Chain[F].FileName = addString(Frame.FileName);
+        Chain[F].Line = Frame.Line;
+        Chain[F].Column = Frame.Column;
+        Chain[F].Discriminator = Frame.Discriminator;
+        Chain[F].StartLine = Frame.StartLine;
+      }
+      // Adjacent rows frequently only differ in flags we do not record.
+      if (!NewRanges.empty() && NewRanges.back().End == Start &&
+          sameFrames(makeArrayRef(RangeFrames)
+                         .slice(NewRanges.back().FirstFrame,
+                                NewRanges.back().NumFrames),
+                     Chain)) {
+        NewRanges.back().End = Rows[I + 1].Address;
+        continue;
+      }
+      NewRanges.emplace_back();
+      NewRanges.back().Start = Start;
+      NewRanges.back().End = Rows[I + 1].Address;
+      NewRanges.back().FirstFrame = RangeFrames.size();
+      NewRanges.back().NumFrames = NumFrames;
+      RangeFrames.insert(RangeFrames.end(), Chain.begin(), Chain.end());
+    }
+  }
+
+  // Line tables of different units may interleave. Drop the new ranges that
+  // overlap one already in the cache or an earlier one of this unit, which is
+  // what a lookup would have ignored anyway.
+  auto ByStart = [](const symcache::Range &LHS, const symcache::Range &RHS) {
+    return LHS.Start < RHS.Start;
+  };
+  std::stable_sort(NewRanges.begin(), NewRanges.end(), ByStart);
+  size_t NumOldRanges = RangeTable.size();
+  uint64_t LastEnd = 0;
+  for (symcache::Range R : NewRanges) {
+    if (R.Start < LastEnd)
+      continue;
+    auto OldBegin = RangeTable.begin(), OldEnd = OldBegin + NumOldRanges;
+    auto Next = std::upper_bound(OldBegin, OldEnd, R, ByStart);
+    if ((Next != OldBegin && R.Start < std::prev(Next)->End) ||
+        (Next != OldEnd && Next->Start < R.End))
+      continue;
+    LastEnd = R.End;
+    uint32_t FirstFrame = R.FirstFrame;
+    R.FirstFrame = FrameTable.size();
+    FrameTable.insert(FrameTable.end(), RangeFrames.begin() + FirstFrame,
+                      RangeFrames.begin() + FirstFrame + R.NumFrames);
+    RangeTable.push_back(R);
+  }
+  std::inplace_merge(RangeTable.begin(), RangeTable.begin() + NumOldRanges,
+                     RangeTable.end(), ByStart);
+
+  // Keep the held ranges sorted and disjoint.
+  UnitRangeTable.insert(UnitRangeTable.end(), NewUnitRanges.begin(),
+                        NewUnitRanges.end());
+  std::sort(UnitRangeTable.begin(), UnitRangeTable.end(),
+            [](const symcache::UnitRange &LHS, const symcache::UnitRange &RHS) {
+              return LHS.Start < RHS.Start;
+            });
+  std::vector<symcache::UnitRange> Merged;
+  for (const symcache::UnitRange &R : UnitRangeTable) {
+    if (!Merged.empty() && R.Start <= Merged.back().End)
+      Merged.back().End = std::max<uint64_t>(Merged.back().End, R.End);
+    else
+      Merged.push_back(R);
+  }
+  UnitRangeTable = std::move(Merged);
+
+  UnitRanges = UnitRangeTable;
+  Ranges = RangeTable;
+  Frames = FrameTable;
+  Strings = StringTable;
+}
+
+Error SymbolizerCacheContext::save() {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  symcache::Header H;
+  memcpy(H.Magic, symcache::Magic, sizeof(H.Magic));
+  H.Version = symcache::Version;
+  H.BuildIDSize = BuildID.size();
+  H.NumUnitRanges = UnitRanges.size();
+  H.NumRanges = Ranges.size();
+  H.NumFrames = Frames.size();
+  H.StringTableSize = Strings.size();
+
+  Expected<sys::fs::TempFile> Temp =
+      sys::fs::TempFile::create(Path + ".tmp%%%%%%");
+  if (!Temp)
+    return Temp.takeError();
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    OS.write(reinterpret_cast<const char *>(&H), sizeof(H));
+    writeArray(OS, makeArrayRef(BuildID));
+    OS.write_zeros(alignTo(BuildID.size(), 8) - BuildID.size());
+    writeArray(OS, UnitRanges);
+    writeArray(OS, Ranges);
+    writeArray(OS, Frames);
+    OS << Strings;
+    OS.flush();
+    if (OS.has_error()) {
+      OS.clear_error();
+      consumeError(Temp->discard());
+      return createStringError(errc::io_error,
+                               "failed to write symbolizer cache '%s'",
+                               Path.c_str());
+    }
+  }
+  return Temp->keep(Path);
+}
+
+void SymbolizerCacheContext::dump(raw_ostream &OS, DIDumpOptions DumpOpts) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  for (const symcache::Range &R : Ranges) {
+    OS << format("[0x%016" PRIx64 ", 0x%016" PRIx64 ")\n", uint64_t(R.Start),
+                 uint64_t(R.End));
+    for (uint32_t I = 0; I != R.NumFrames; ++I) {
+      DILineInfo Frame = getFrame(R.FirstFrame + I, DILineInfoSpecifier());
+      OS << "  " << Frame.FunctionName << " at " << Frame.FileName << ':'
+         << Frame.Line << ':' << Frame.Column << '\n';
+    }
+  }
+}
+
+bool SymbolizerCacheContext::holdsAddress(uint64_t Address) const {
+  return findInRanges(UnitRanges, Address) != nullptr;
+}
+
+const symcache::Range *SymbolizerCacheContext::findRange(uint64_t Address) {
+  if (!holdsAddress(Address))
+    addUnitFor(Address);
+  return findInRanges(Ranges, Address);
+}
+
+StringRef SymbolizerCacheContext::getString(uint32_t Offset) const {
+  return Strings.data() + Offset;
+}
+
+DILineInfo
+SymbolizerCacheContext::getFrame(uint32_t Index,
+                                 DILineInfoSpecifier Specifier) const {
+  using FunctionNameKind = DILineInfoSpecifier::FunctionNameKind;
+  using FileLineInfoKind = DILineInfoSpecifier::FileLineInfoKind;
+
+  const symcache::Frame &F = Frames[Index];
+  DILineInfo Frame;
+  if (Specifier.FNKind == FunctionNameKind::LinkageName)
+    Frame.FunctionName = getString(F.LinkageName);
+  else if (Specifier.FNKind == FunctionNameKind::ShortName)
+    Frame.FunctionName = getString(F.ShortName);
+  Frame.StartLine = F.StartLine;
+  if (Specifier.FLIKind != FileLineInfoKind::None) {
+    Frame.FileName = getString(F.FileName);
+    Frame.Line = F.Line;
+    Frame.Column = F.Column;
+    Frame.Discriminator = F.Discriminator;
+  }
+  return Frame;
+}
+
+DILineInfo
+SymbolizerCacheContext::getLineInfoForAddress(uint64_t Address,
+                                              DILineInfoSpecifier Specifier) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (const symcache::Range *R = findRange(Address))
+    return getFrame(R->FirstFrame, Specifier);
+  return DILineInfo();
+}
+
+DILineInfoTable SymbolizerCacheContext::getLineInfoForAddressRange(
+    uint64_t Address, uint64_t Size, DILineInfoSpecifier Specifier) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  // Only the unit of the first address is added if needed.
+  if (!holdsAddress(Address))
+    addUnitFor(Address);
+  DILineInfoTable Lines;
+  uint64_t End = Address + Size;
+  auto It = std::upper_bound(
+      Ranges.begin(), Ranges.end(), Address,
+      [](uint64_t Address, const symcache::Range &R) {
+        return Address < R.Start;
+      });
+  if (It != Ranges.begin() && Address < std::prev(It)->End)
+    --It;
+  for (; It != Ranges.end() && It->Start < End; ++It)
+    Lines.push_back(std::make_pair(uint64_t(It->Start),
+                                   getFrame(It->FirstFrame, Specifier)));
+  return Lines;
+}
+
+DIInliningInfo SymbolizerCacheContext::getInliningInfoForAddress(
+    uint64_t Address, DILineInfoSpecifier Specifier) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  DIInliningInfo InliningInfo;
+  if (const symcache::Range *R = findRange(Address))
+    for (uint32_t I = 0; I != R->NumFrames; ++I)
+      InliningInfo.addFrame(getFrame(R->FirstFrame + I, Specifier));
+  return InliningInfo;
+}
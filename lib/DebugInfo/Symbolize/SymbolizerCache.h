@@ -0,0 +1,200 @@
+//===- SymbolizerCache.h ----------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the on-disk address-to-line index used by
+// LLVMSymbolizer to avoid re-parsing DWARF for binaries it has already seen.
+//
+// A cache file is keyed by the build ID (or Mach-O UUID) of the binary. It is
+// filled one compile unit at a time, as addresses of the unit are looked up,
+// and lists the address ranges of the units it holds. For those it contains
+// a table of address ranges sorted by start address. Every range refers to the
+// chain of (possibly inlined) frames that covers it, innermost frame first,
+// and every frame refers to names stored in a string table. All integers are
+// little-endian and the file is used directly from a memory-mapped buffer
+// without any decoding step.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZERCACHE_H
+#define LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZERCACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class DWARFContext;
+
+namespace object {
+class ObjectFile;
+} // end namespace object
+
+namespace symbolize {
+
+namespace symcache {
+
+using support::ulittle32_t;
+using support::ulittle64_t;
+
+const char Magic[8] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'C'};
+const uint32_t Version = 2;
+
+struct Header {
+  char Magic[8];
+  ulittle32_t Version;
+  /// Size of the build ID that immediately follows the header.
+  ulittle32_t BuildIDSize;
+  ulittle32_t NumUnitRanges;
+  ulittle32_t NumRanges;
+  ulittle32_t NumFrames;
+  ulittle32_t StringTableSize;
+};
+
+/// The half-open address range [Start, End) belongs to a compile unit whose
+/// line table rows are in the file.
+struct UnitRange {
+  ulittle64_t Start;
+  ulittle64_t End;
+};
+
+/// The half-open address range [Start, End) is described by frames
+/// [FirstFrame, FirstFrame + NumFrames).
+struct Range {
+  ulittle64_t Start;
+  ulittle64_t End;
+  ulittle32_t FirstFrame;
+  ulittle32_t NumFrames;
+};
+
+/// Name and file fields are offsets of NUL-terminated strings in the string
+/// table.
+struct Frame {
+  ulittle32_t LinkageName;
+  ulittle32_t ShortName;
+  ulittle32_t FileName;
+  ulittle32_t Line;
+  ulittle32_t Column;
+  ulittle32_t Discriminator;
+  ulittle32_t StartLine;
+};
+
+} // end namespace symcache
+
+/// Returns the build ID of an ELF file or the UUID of a Mach-O file, or an
+/// empty array if the object has neither.
+ArrayRef<uint8_t> getObjectBuildID(const object::ObjectFile *Obj);
+
+/// Returns the name of the cache file for the given build ID in \p CacheDir.
+std::string getSymbolizerCachePath(StringRef CacheDir,
+                                   ArrayRef<uint8_t> BuildID);
+
+/// A DIContext that answers queries from a cache file.
+///
+/// An address outside the compile units the cache holds is looked up in the
+/// DWARF context, which is only created then. The line table rows of its unit
+/// are resolved and added to the cache, and the unit's address ranges are
+/// recorded as held. The other units are not parsed, so that a single query
+/// costs no more than it would without a cache.
+///
+/// File names are always recorded as absolute paths, which is what
+/// SymbolizableObjectFile asks for. Addresses of a held unit that are not
+/// covered by any of its line table rows have no information. Queries may
+/// come from several threads at once.
+class SymbolizerCacheContext : public DIContext {
+public:
+  using DWARFContextFactory = std::function<std::unique_ptr<DWARFContext>()>;
+
+  /// Creates an empty cache for the binary with the given build ID, which is
+  /// saved to \p Path.
+  SymbolizerCacheContext(ArrayRef<uint8_t> BuildID, StringRef Path,
+                         DWARFContextFactory CreateDWARFContext);
+  ~SymbolizerCacheContext() override;
+
+  SymbolizerCacheContext(SymbolizerCacheContext &) = delete;
+  SymbolizerCacheContext &operator=(SymbolizerCacheContext &) = delete;
+
+  static bool classof(const DIContext *DICtx) {
+    return DICtx->getKind() == CK_SymbolizerCache;
+  }
+
+  void dump(raw_ostream &OS, DIDumpOptions DumpOpts) override;
+
+  DILineInfo getLineInfoForAddress(
+      uint64_t Address,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
+  DILineInfoTable getLineInfoForAddressRange(
+      uint64_t Address, uint64_t Size,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
+  DIInliningInfo getInliningInfoForAddress(
+      uint64_t Address,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
+
+  /// Reads the cache file from \p Buffer after validating it against the
+  /// build ID. On error the cache stays empty.
+  Error load(std::unique_ptr<MemoryBuffer> Buffer);
+
+  /// Returns the number of compile units added since the cache was loaded.
+  unsigned getNumAddedUnits() const { return AddedUnits.size(); }
+
+  /// Writes the cache to its path. The file is written to a temporary and
+  /// renamed into place so that concurrent symbolizers never observe a
+  /// partially written cache.
+  Error save();
+
+private:
+  /// Adds the compile unit of \p Address unless the cache holds it already.
+  void addUnitFor(uint64_t Address);
+  bool holdsAddress(uint64_t Address) const;
+  const symcache::Range *findRange(uint64_t Address);
+  DILineInfo getFrame(uint32_t Index, DILineInfoSpecifier Specifier) const;
+  StringRef getString(uint32_t Offset) const;
+
+  /// Copies the tables of the loaded file, so that they can be added to.
+  void copyTables();
+  uint32_t addString(StringRef S);
+
+  std::vector<uint8_t> BuildID;
+  std::string Path;
+  DWARFContextFactory CreateDWARFContext;
+  std::unique_ptr<DWARFContext> DICtx;
+  /// Offsets of the compile units added to the cache.
+  DenseSet<uint32_t> AddedUnits;
+  std::mutex Mutex;
+
+  /// The tables in use, which refer either to the loaded file or to the
+  /// copies below once a unit has been added.
+  ArrayRef<symcache::UnitRange> UnitRanges;
+  ArrayRef<symcache::Range> Ranges;
+  ArrayRef<symcache::Frame> Frames;
+  StringRef Strings;
+
+  std::unique_ptr<MemoryBuffer> Buffer;
+  bool Copied = false;
+  std::vector<symcache::UnitRange> UnitRangeTable;
+  std::vector<symcache::Range> RangeTable;
+  std::vector<symcache::Frame> FrameTable;
+  std::string StringTable;
+  StringMap<uint32_t> StringOffsets;
+};
+
+} // end namespace symbolize
+} // end namespace llvm
+
+#endif // LLVM_LIB_DEBUGINFO_SYMBOLIZE_SYMBOLIZERCACHE_H
@@ -17,6 +17,7 @@
 #include "llvm/MCA/Support.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <limits>
 
 namespace llvm {
 namespace mca {
@@ -316,6 +317,20 @@ void ResourceManager::cycleEvent(SmallVectorImpl<ResourceRef> &ResourcesFreed) {
     BusyResources.erase(RF);
 }
 
+unsigned ResourceManager::getNumIdleCycles() const {
+  unsigned Cycles = std::numeric_limits<unsigned>::max();
+  for (const std::pair<ResourceRef, unsigned> &BR : BusyResources)
+    Cycles = std::min(Cycles, BR.second - 1);
+  return Cycles;
+}
+
+void ResourceManager::skipIdleCycles(unsigned Cycles) {
+  for (std::pair<ResourceRef, unsigned> &BR : BusyResources) {
+    assert(BR.second > Cycles && "Resource released while idle!");
+    BR.second -= Cycles;
+  }
+}
+
 void ResourceManager::reserveResource(uint64_t ResourceID) {
   ResourceState &Resource = *Resources[getResourceStateIndex(ResourceID)];
   assert(!Resource.isReserved());
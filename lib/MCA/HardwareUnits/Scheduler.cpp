@@ -198,6 +198,23 @@ void Scheduler::cycleEvent(SmallVectorImpl<ResourceRef> &Freed,
   promoteToReadySet(Ready);
 }
 
+unsigned Scheduler::getNumIdleCycles() const {
+  unsigned Cycles = Resources->getNumIdleCycles();
+  for (const InstRef &IR : IssuedSet)
+    Cycles = std::min(Cycles, IR.getInstruction()->getNumIdleCycles());
+  for (const InstRef &IR : WaitSet)
+    Cycles = std::min(Cycles, IR.getInstruction()->getNumIdleCycles());
+  return Cycles;
+}
+
+void Scheduler::skipIdleCycles(unsigned Cycles) {
+  Resources->skipIdleCycles(Cycles);
+  for (InstRef &IR : IssuedSet)
+    IR.getInstruction()->skipIdleCycles(Cycles);
+  for (InstRef &IR : WaitSet)
+    IR.getInstruction()->skipIdleCycles(Cycles);
+}
+
 bool Scheduler::mustIssueImmediately(const InstRef &IR) const {
   const InstrDesc &Desc = IR.getInstruction()->getDesc();
   if (Desc.isZeroLatency())
@@ -15,6 +15,7 @@
 #include "llvm/MCA/Instruction.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <limits>
 
 namespace llvm {
 namespace mca {
@@ -94,6 +95,13 @@ void WriteState::cycleEvent() {
     DependentWriteCyclesLeft--;
 }
 
+void WriteState::skipIdleCycles(unsigned Cycles) {
+  if (CyclesLeft != UNKNOWN_CYCLES)
+    CyclesLeft -= Cycles;
+
+  DependentWriteCyclesLeft -= std::min(Cycles, DependentWriteCyclesLeft);
+}
+
 void ReadState::cycleEvent() {
   // Update the total number of cycles.
   if (DependentWrites && TotalCycles) {
@@ -111,6 +119,25 @@ void ReadState::cycleEvent() {
   }
 }
 
+unsigned ReadState::getCyclesToReady() const {
+  if (DependentWrites || CyclesLeft == UNKNOWN_CYCLES || !CyclesLeft)
+    return std::numeric_limits<unsigned>::max();
+  return CyclesLeft;
+}
+
+void ReadState::skipIdleCycles(unsigned Cycles) {
+  if (DependentWrites) {
+    TotalCycles -= std::min(Cycles, TotalCycles);
+    return;
+  }
+
+  if (CyclesLeft == UNKNOWN_CYCLES || !CyclesLeft)
+    return;
+
+  assert(CyclesLeft > static_cast<int>(Cycles) && "Read ready while idle!");
+  CyclesLeft -= Cycles;
+}
+
 #ifndef NDEBUG
 void WriteState::dump() const {
   dbgs() << "{ OpIdx=" << WD->OpIndex << ", Lat=" << getLatency() << ", RegID "
@@ -199,6 +226,53 @@ void Instruction::cycleEvent() {
     Stage = IS_EXECUTED;
 }
 
+unsigned Instruction::getNumIdleCycles() const {
+  if (isExecuting())
+    return CyclesLeft - 1;
+
+  if (!isDispatched())
+    return std::numeric_limits<unsigned>::max();
+
+  // The instruction may become ready when one of its reads becomes ready, or
+  // when a partial write no longer has to wait on the write it depends on
+  // (see method update()).
+  unsigned CyclesToUpdate = std::numeric_limits<unsigned>::max();
+  for (const ReadState &Use : getUses())
+    CyclesToUpdate = std::min(CyclesToUpdate, Use.getCyclesToReady());
+
+  for (const WriteState &Def : getDefs()) {
+    unsigned WriteCycles = Def.getDependentWriteCyclesLeft();
+    if (Def.getDependentWrite() || !WriteCycles || WriteCycles < getLatency())
+      continue;
+    CyclesToUpdate = std::min(
+        CyclesToUpdate, std::min(WriteCycles, WriteCycles - getLatency() + 1));
+  }
+
+  if (CyclesToUpdate == std::numeric_limits<unsigned>::max())
+    return CyclesToUpdate;
+  return CyclesToUpdate - 1;
+}
+
+void Instruction::skipIdleCycles(unsigned Cycles) {
+  if (isReady())
+    return;
+
+  if (isDispatched()) {
+    for (ReadState &Use : getUses())
+      Use.skipIdleCycles(Cycles);
+
+    for (WriteState &Def : getDefs())
+      Def.skipIdleCycles(Cycles);
+    return;
+  }
+
+  assert(isExecuting() && "Instruction not in-flight?");
+  assert(CyclesLeft > static_cast<int>(Cycles) && "Executed while idle!");
+  for (WriteState &Def : getDefs())
+    Def.skipIdleCycles(Cycles);
+  CyclesLeft -= Cycles;
+}
+
 const unsigned WriteRef::INVALID_IID = std::numeric_limits<unsigned>::max();
 
 } // namespace mca
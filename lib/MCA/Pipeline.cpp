@@ -16,6 +16,7 @@
 #include "llvm/MCA/Pipeline.h"
 #include "llvm/MCA/HWEventListener.h"
 #include "llvm/Support/Debug.h"
+#include <limits>
 
 namespace llvm {
 namespace mca {
@@ -39,16 +40,46 @@ Expected<unsigned> Pipeline::run() {
   assert(!Stages.empty() && "Unexpected empty pipeline found!");
 
   do {
+    Activity.reset();
     notifyCycleBegin();
     if (Error Err = runCycle())
       return std::move(Err);
     notifyCycleEnd();
     ++Cycles;
+    if (!Activity.isActive() && hasWorkToProcess())
+      skipIdleCycles();
   } while (hasWorkToProcess());
 
   return Cycles;
 }
 
+void Pipeline::skipIdleCycles() {
+  unsigned NumCycles = std::numeric_limits<unsigned>::max();
+  for (const std::unique_ptr<Stage> &S : Stages)
+    NumCycles = std::min(NumCycles, S->getNumIdleCycles());
+
+  // No stage has a timer running; let the next cycle run as usual.
+  if (!NumCycles || NumCycles == std::numeric_limits<unsigned>::max())
+    return;
+
+  LLVM_DEBUG(dbgs() << "\n[E] Skipping " << NumCycles << " idle cycles\n");
+  for (const std::unique_ptr<Stage> &S : Stages)
+    S->skipIdleCycles(NumCycles);
+
+  // Listeners still observe every cycle, including the stall event that
+  // prevented the first stage from accepting an instruction in the last one.
+  InstRef IR;
+  Stage &FirstStage = *Stages[0];
+  for (unsigned I = 0; I < NumCycles; ++I) {
+    notifyCycleBegin();
+    bool IsAvailable = FirstStage.isAvailable(IR);
+    (void)IsAvailable;
+    assert(!IsAvailable && "Instruction dispatched in an idle cycle!");
+    notifyCycleEnd();
+    ++Cycles;
+  }
+}
+
 Error Pipeline::runCycle() {
   Error Err = ErrorSuccess();
   // Update stages before we start processing new instructions.
@@ -74,6 +105,7 @@ Error Pipeline::runCycle() {
 
 void Pipeline::appendStage(std::unique_ptr<Stage> S) {
   assert(S && "Invalid null stage in input!");
+  S->addListener(&Activity);
   if (!Stages.empty()) {
     Stage *Last = Stages.back().get();
     Last->setNextInSequence(S.get());
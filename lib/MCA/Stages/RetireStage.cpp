@@ -17,6 +17,7 @@
 #include "llvm/MCA/Stages/RetireStage.h"
 #include "llvm/MCA/HWEventListener.h"
 #include "llvm/Support/Debug.h"
+#include <limits>
 
 #define DEBUG_TYPE "llvm-mca"
 
@@ -43,6 +44,13 @@ llvm::Error RetireStage::cycleStart() {
   return llvm::ErrorSuccess();
 }
 
+unsigned RetireStage::getNumIdleCycles() const {
+  // Instructions only become ready to retire when they finish executing.
+  if (!RCU.isEmpty() && RCU.peekCurrentToken().Executed)
+    return 0;
+  return std::numeric_limits<unsigned>::max();
+}
+
 llvm::Error RetireStage::execute(InstRef &IR) {
   RCU.onInstructionExecuted(IR.getInstruction()->getRCUTokenID());
   return llvm::ErrorSuccess();
@@ -0,0 +1,114 @@
+//===- ArchiveMemberCache.cpp - Parsed archive members --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/ArchiveMemberCache.h"
+#include "llvm/BinaryFormat/Magic.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+using namespace object;
+
+ArchiveMemberCache::ArchiveMemberCache(const Archive &A, LLVMContext *Context)
+    : A(A), Context(Context) {}
+
+void ArchiveMemberCache::preload(unsigned Threads, size_t WindowSize) {
+  NumThreads = Threads ? Threads : hardware_concurrency();
+  Window = WindowSize;
+  NextChild.reset();
+  Error Err = Error::success();
+  auto I = A.child_begin(Err);
+  // The caller's own walk over the children reports a malformed archive.
+  if (!Err && I != A.child_end())
+    NextChild = *I;
+  consumeError(std::move(Err));
+  preloadWindow();
+}
+
+void ArchiveMemberCache::preloadWindow() {
+  struct PendingMember {
+    uint64_t Offset;
+    MemoryBufferRef Buffer;
+    std::unique_ptr<Binary> Result;
+  };
+
+  // Finding the members is cheap and, for thin archives, reads the member
+  // files into buffers owned by the archive, so do it here on one thread.
+  std::vector<PendingMember> Pending;
+  for (size_t Seen = 0; NextChild && (!Window || Seen != Window); ++Seen) {
+    const Archive::Child C = *NextChild;
+    // Past the last member, getNext() returns a child without a parent.
+    Expected<Archive::Child> NextOrErr = C.getNext();
+    if (NextOrErr && NextOrErr->getParent())
+      NextChild = *NextOrErr;
+    else
+      NextChild.reset();
+    consumeError(NextOrErr.takeError());
+
+    uint64_t Offset = C.getChildOffset();
+    if (Members.count(Offset))
+      continue;
+    Expected<MemoryBufferRef> BufferOrErr = C.getMemoryBufferRef();
+    if (!BufferOrErr) {
+      consumeError(BufferOrErr.takeError());
+      continue;
+    }
+    // Bitcode is read into the caller's context by getMember().
+    if (identify_magic(BufferOrErr->getBuffer()) == file_magic::bitcode)
+      continue;
+    Pending.push_back({Offset, *BufferOrErr, nullptr});
+  }
+
+  auto Parse = [](PendingMember &P) {
+    Expected<std::unique_ptr<Binary>> BinaryOrErr = createBinary(P.Buffer);
+    if (BinaryOrErr)
+      P.Result = std::move(*BinaryOrErr);
+    else
+      consumeError(BinaryOrErr.takeError());
+  };
+
+  unsigned Threads = std::min<size_t>(NumThreads, Pending.size());
+  if (Threads <= 1) {
+    for (PendingMember &P : Pending)
+      Parse(P);
+  } else {
+    ThreadPool Pool(Threads);
+    for (PendingMember &P : Pending)
+      Pool.async(Parse, std::ref(P));
+    Pool.wait();
+  }
+
+  for (PendingMember &P : Pending)
+    if (P.Result)
+      Members[P.Offset] = std::move(P.Result);
+}
+
+Expected<std::shared_ptr<Binary>>
+ArchiveMemberCache::getMember(const Archive::Child &C) {
+  uint64_t Offset = C.getChildOffset();
+  // The caller walked past the preloaded members; parse the next window.
+  if (Window && NextChild && Offset >= NextChild->getChildOffset())
+    preloadWindow();
+  auto It = Members.find(Offset);
+  if (It != Members.end())
+    return It->second;
+
+  Expected<std::unique_ptr<Binary>> BinaryOrErr = C.getAsBinary(Context);
+  if (!BinaryOrErr)
+    return BinaryOrErr.takeError();
+  std::shared_ptr<Binary> Result = std::move(*BinaryOrErr);
+  Members[Offset] = Result;
+  return Result;
+}
+
+void ArchiveMemberCache::release(const Archive::Child &C) {
+  Members.erase(C.getChildOffset());
+}
@@ -22,8 +22,10 @@
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileOutputBuffer.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -431,10 +433,47 @@ getSymbols(MemoryBufferRef Buf, raw_ostream &SymNames, bool &HasObject) {
   return Ret;
 }
 
+namespace {
+// The symbols of one member, with offsets into its own Names.
+struct MemberSymbols {
+  bool HasObject = false;
+  std::string Names;
+  Optional<Expected<std::vector<unsigned>>> Offsets;
+};
+} // namespace
+
+// Reading the symbols means parsing every member, and loading bitcode ones into
+// an LLVMContext, so with more than one thread this is done for all members at
+// once on a thread pool. getSymbols creates a context per member, so nothing is
+// shared between threads.
+static std::vector<MemberSymbols>
+computeMemberSymbols(ArrayRef<NewArchiveMember> NewMembers, unsigned Threads) {
+  std::vector<MemberSymbols> Ret(NewMembers.size());
+  auto Compute = [&](size_t I) {
+    raw_string_ostream Names(Ret[I].Names);
+    Ret[I].Offsets.emplace(getSymbols(NewMembers[I].Buf->getMemBufferRef(),
+                                      Names, Ret[I].HasObject));
+    Names.flush();
+  };
+
+  unsigned NumThreads = std::min<size_t>(Threads, NewMembers.size());
+  if (NumThreads <= 1) {
+    for (size_t I = 0, E = NewMembers.size(); I != E; ++I)
+      Compute(I);
+    return Ret;
+  }
+  ThreadPool Pool(NumThreads);
+  for (size_t I = 0, E = NewMembers.size(); I != E; ++I)
+    Pool.async(Compute, I);
+  Pool.wait();
+  return Ret;
+}
+
 static Expected<std::vector<MemberData>>
 computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
                   object::Archive::Kind Kind, bool Thin, StringRef ArcName,
-                  bool Deterministic, ArrayRef<NewArchiveMember> NewMembers) {
+                  bool Deterministic, bool NeedSymbols,
+                  ArrayRef<NewArchiveMember> NewMembers, unsigned Threads) {
   static char PaddingData[8] = {'\n', '\n', '\n', '\n', '\n', '\n', '\n', '\n'};
 
   // This ignores the symbol table, but we only need the value mod 8 and the
@@ -499,7 +538,14 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
       Entry.second = Entry.second > 1 ? 1 : 0;
   }
 
-  for (const NewArchiveMember &M : NewMembers) {
+  // The symbol table is only written if asked for, so don't read the symbols
+  // otherwise.
+  std::vector<MemberSymbols> Symbols;
+  if (NeedSymbols)
+    Symbols = computeMemberSymbols(NewMembers, Threads);
+
+  for (size_t I = 0, E = NewMembers.size(); I != E; ++I) {
+    const NewArchiveMember &M = NewMembers[I];
     std::string Header;
     raw_string_ostream Out(Header);
 
@@ -525,13 +571,27 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
                       M, ModTime, Buf.getBufferSize() + MemberPadding);
     Out.flush();
 
-    Expected<std::vector<unsigned>> Symbols =
-        getSymbols(Buf, SymNames, HasObject);
-    if (auto E = Symbols.takeError())
-      return std::move(E);
+    // Move the member's symbol names into the shared table, in member order so
+    // that the output doesn't depend on the threads.
+    std::vector<unsigned> MemberSyms;
+    if (NeedSymbols) {
+      MemberSymbols &Syms = Symbols[I];
+      Expected<std::vector<unsigned>> &Offsets = *Syms.Offsets;
+      if (Error E = Offsets.takeError()) {
+        for (MemberSymbols &Rest : MutableArrayRef<MemberSymbols>(Symbols)
+                                       .drop_front(I + 1))
+          consumeError(Rest.Offsets->takeError());
+        return std::move(E);
+      }
+      HasObject |= Syms.HasObject;
+      unsigned Base = SymNames.tell();
+      for (unsigned Offset : *Offsets)
+        MemberSyms.push_back(Base + Offset);
+      SymNames << Syms.Names;
+    }
 
     Pos += Header.size() + Data.size() + Padding.size();
-    Ret.push_back({std::move(*Symbols), std::move(Header), Data, Padding});
+    Ret.push_back({std::move(MemberSyms), std::move(Header), Data, Padding});
   }
   // If there are no symbols, emit an empty symbol table, to satisfy Solaris
   // tools, older versions of which expect a symbol table in a non-empty
@@ -545,7 +605,8 @@ Error llvm::writeArchive(StringRef ArcName,
                          ArrayRef<NewArchiveMember> NewMembers,
                          bool WriteSymtab, object::Archive::Kind Kind,
                          bool Deterministic, bool Thin,
-                         std::unique_ptr<MemoryBuffer> OldArchiveBuf) {
+                         std::unique_ptr<MemoryBuffer> OldArchiveBuf,
+                         unsigned Threads) {
   assert((!Thin || !isBSDLike(Kind)) && "Only the gnu format has a thin mode");
 
   SmallString<0> SymNamesBuf;
@@ -553,8 +614,9 @@ Error llvm::writeArchive(StringRef ArcName,
   SmallString<0> StringTableBuf;
   raw_svector_ostream StringTable(StringTableBuf);
 
-  Expected<std::vector<MemberData>> DataOrErr = computeMemberData(
-      StringTable, SymNames, Kind, Thin, ArcName, Deterministic, NewMembers);
+  Expected<std::vector<MemberData>> DataOrErr =
+      computeMemberData(StringTable, SymNames, Kind, Thin, ArcName,
+                        Deterministic, WriteSymtab, NewMembers, Threads);
   if (Error E = DataOrErr.takeError())
     return E;
   std::vector<MemberData> &Data = *DataOrErr;
@@ -598,24 +660,51 @@ Error llvm::writeArchive(StringRef ArcName,
     }
   }
 
-  Expected<sys::fs::TempFile> Temp =
-      sys::fs::TempFile::create(ArcName + ".temp-archive-%%%%%%%.a");
-  if (!Temp)
-    return Temp.takeError();
-
-  raw_fd_ostream Out(Temp->FD, false);
+  // Everything but the member contents is small, so format it up front. That
+  // gives the size of the output file, and the members can then be copied into
+  // it concurrently.
+  SmallString<0> HeadBuf;
+  raw_svector_ostream Head(HeadBuf);
   if (Thin)
-    Out << "!<thin>\n";
+    Head << "!<thin>\n";
   else
-    Out << "!<arch>\n";
+    Head << "!<arch>\n";
 
   if (WriteSymtab)
-    writeSymbolTable(Out, Kind, Deterministic, Data, SymNamesBuf);
+    writeSymbolTable(Head, Kind, Deterministic, Data, SymNamesBuf);
 
-  for (const MemberData &M : Data)
-    Out << M.Header << M.Data << M.Padding;
+  std::vector<uint64_t> Offsets;
+  uint64_t Size = HeadBuf.size();
+  for (const MemberData &M : Data) {
+    Offsets.push_back(Size);
+    Size += M.Header.size() + M.Data.size() + M.Padding.size();
+  }
 
-  Out.flush();
+  Expected<std::unique_ptr<FileOutputBuffer>> OutOrErr =
+      FileOutputBuffer::create(ArcName, Size);
+  if (!OutOrErr)
+    return OutOrErr.takeError();
+  std::unique_ptr<FileOutputBuffer> Out = std::move(*OutOrErr);
+  uint8_t *Start = Out->getBufferStart();
+  llvm::copy(HeadBuf, Start);
+
+  auto CopyMember = [&](size_t I) {
+    const MemberData &M = Data[I];
+    uint8_t *Buf = Start + Offsets[I];
+    Buf = llvm::copy(M.Header, Buf);
+    Buf = llvm::copy(M.Data, Buf);
+    llvm::copy(M.Padding, Buf);
+  };
+  unsigned NumThreads = std::min<size_t>(Threads, Data.size());
+  if (NumThreads <= 1) {
+    for (size_t I = 0, E = Data.size(); I != E; ++I)
+      CopyMember(I);
+  } else {
+    ThreadPool Pool(NumThreads);
+    for (size_t I = 0, E = Data.size(); I != E; ++I)
+      Pool.async(CopyMember, I);
+    Pool.wait();
+  }
 
   // At this point, we no longer need whatever backing memory
   // was used to generate the NewMembers. On Windows, this buffer
@@ -629,5 +718,5 @@ Error llvm::writeArchive(StringRef ArcName,
   // closed before we attempt to rename.
   OldArchiveBuf.reset();
 
-  return Temp->keep(ArcName);
+  return Out->commit();
 }
@@ -18,7 +18,9 @@
 #include "llvm/ADT/None.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ProfileData/Coverage/CoverageMappingReader.h"
 #include "llvm/ProfileData/InstrProfReader.h"
@@ -26,9 +28,12 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -250,6 +255,20 @@ Error CoverageMapping::loadFunctionRecord(
     return Error::success();
 
   Functions.push_back(std::move(Function));
+
+  // Performance optimization: keep track of the indices of the function records
+  // which correspond to each filename. This can be used to substantially speed
+  // up queries for coverage info in a file.
+  unsigned RecordIndex = Functions.size() - 1;
+  for (StringRef Filename : Record.Filenames) {
+    auto &RecordIndices = FilenameHash2RecordIndices[hash_value(Filename)];
+    // Note that there may be duplicates in the filename set for a function
+    // record, because of e.g. macro expansions in the function in which both
+    // the macro and the function are defined in the same file.
+    if (RecordIndices.empty() || RecordIndices.back() != RecordIndex)
+      RecordIndices.push_back(RecordIndex);
+  }
+
   return Error::success();
 }
 
@@ -271,9 +290,64 @@ Expected<std::unique_ptr<CoverageMapping>> CoverageMapping::load(
   return std::move(Coverage);
 }
 
+/// Get the path of the mapping cache file for an object with the given
+/// contents and architecture.
+static std::string getMappingCachePath(StringRef MappingCacheDir,
+                                       StringRef ObjectData, StringRef Arch) {
+  SmallString<128> Path(MappingCacheDir);
+  std::string Name = utohexstr(xxHash64(ObjectData));
+  if (!Arch.empty())
+    Name += ("-" + Arch).str();
+  sys::path::append(Path, Name + ".covmapcache");
+  return Path.str();
+}
+
+/// Create a reader over the coverage mapping records of \p ObjectBuffer. The
+/// records are taken from the mapping cache if it has them, and are otherwise
+/// decoded using \p NumThreads threads and added to the cache.
+static Expected<std::unique_ptr<CoverageMappingReader>>
+createCoverageReader(std::unique_ptr<MemoryBuffer> &ObjectBuffer,
+                     StringRef Arch, unsigned NumThreads,
+                     StringRef MappingCacheDir) {
+  std::string CachePath;
+  if (!MappingCacheDir.empty()) {
+    CachePath = getMappingCachePath(MappingCacheDir, ObjectBuffer->getBuffer(),
+                                    Arch);
+    if (auto CacheBufOrErr = MemoryBuffer::getFile(CachePath)) {
+      auto CachedReaderOrErr =
+          DecodedCoverageReader::createFromCache(std::move(CacheBufOrErr.get()));
+      if (CachedReaderOrErr)
+        return std::move(CachedReaderOrErr.get());
+      // A stale or corrupt cache file is simply replaced.
+      consumeError(CachedReaderOrErr.takeError());
+    }
+  }
+
+  auto CoverageReaderOrErr = BinaryCoverageReader::create(ObjectBuffer, Arch);
+  if (Error E = CoverageReaderOrErr.takeError())
+    return std::move(E);
+  // Decoding one record at a time needs the least memory, so only decode up
+  // front when that buys parallelism or a cache file.
+  if (NumThreads == 1 && CachePath.empty())
+    return std::move(CoverageReaderOrErr.get());
+
+  auto DecodedReaderOrErr = DecodedCoverageReader::create(
+      std::move(CoverageReaderOrErr.get()), NumThreads);
+  if (Error E = DecodedReaderOrErr.takeError())
+    return std::move(E);
+  if (!CachePath.empty()) {
+    // The cache is only an optimization, so failing to write it is not an
+    // error.
+    if (!sys::fs::create_directories(MappingCacheDir))
+      consumeError(DecodedReaderOrErr.get()->writeCache(CachePath));
+  }
+  return std::move(DecodedReaderOrErr.get());
+}
+
 Expected<std::unique_ptr<CoverageMapping>>
 CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
-                      StringRef ProfileFilename, ArrayRef<StringRef> Arches) {
+                      StringRef ProfileFilename, ArrayRef<StringRef> Arches,
+                      unsigned NumThreads, StringRef MappingCacheDir) {
   auto ProfileReaderOrErr = IndexedInstrProfReader::create(ProfileFilename);
   if (Error E = ProfileReaderOrErr.takeError())
     return std::move(E);
@@ -286,8 +360,8 @@ CoverageMapping::load(ArrayRef<StringRef> ObjectFilenames,
     if (std::error_code EC = CovMappingBufOrErr.getError())
       return errorCodeToError(EC);
     StringRef Arch = Arches.empty() ? StringRef() : Arches[File.index()];
-    auto CoverageReaderOrErr =
-        BinaryCoverageReader::create(CovMappingBufOrErr.get(), Arch);
+    auto CoverageReaderOrErr = createCoverageReader(
+        CovMappingBufOrErr.get(), Arch, NumThreads, MappingCacheDir);
     if (Error E = CoverageReaderOrErr.takeError())
       return std::move(E);
     Readers.push_back(std::move(CoverageReaderOrErr.get()));
@@ -601,11 +675,23 @@ static bool isExpansion(const CountedRegion &R, unsigned FileID) {
   return R.Kind == CounterMappingRegion::ExpansionRegion && R.FileID == FileID;
 }
 
+ArrayRef<unsigned> CoverageMapping::getImpreciseRecordIndicesForFilename(
+    StringRef Filename) const {
+  size_t FilenameHash = hash_value(Filename);
+  auto RecordIt = FilenameHash2RecordIndices.find(FilenameHash);
+  if (RecordIt == FilenameHash2RecordIndices.end())
+    return {};
+  return RecordIt->second;
+}
+
 CoverageData CoverageMapping::getCoverageForFile(StringRef Filename) const {
   CoverageData FileCoverage(Filename);
   std::vector<CountedRegion> Regions;
 
-  for (const auto &Function : Functions) {
+  // Look up the function records in the given file. Due to hash collisions on
+  // the filename, we may get back some records that are not in the file.
+  for (unsigned RecordIndex : getImpreciseRecordIndicesForFilename(Filename)) {
+    const FunctionRecord &Function = Functions[RecordIndex];
     auto MainFileID = findMainViewFileID(Filename, Function);
     auto FileIDs = gatherFileIDs(Filename, Function);
     for (const auto &CR : Function.CountedRegions)
@@ -625,7 +711,10 @@ CoverageData CoverageMapping::getCoverageForFile(StringRef Filename) const {
 std::vector<InstantiationGroup>
 CoverageMapping::getInstantiationGroups(StringRef Filename) const {
   FunctionInstantiationSetCollector InstantiationSetCollector;
-  for (const auto &Function : Functions) {
+  // Look up the function records in the given file. Due to hash collisions on
+  // the filename, we may get back some records that are not in the file.
+  for (unsigned RecordIndex : getImpreciseRecordIndicesForFilename(Filename)) {
+    const FunctionRecord &Function = Functions[RecordIndex];
     auto MainFileID = findMainViewFileID(Filename, Function);
     if (!MainFileID)
       continue;
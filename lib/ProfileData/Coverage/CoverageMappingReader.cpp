@@ -17,6 +17,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/Object/Binary.h"
@@ -27,11 +28,18 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <functional>
 #include <vector>
 
 using namespace llvm;
@@ -724,6 +732,17 @@ BinaryCoverageReader::create(std::unique_ptr<MemoryBuffer> &ObjectBuffer,
   return std::move(Reader);
 }
 
+Error BinaryCoverageReader::decodeRecord(
+    const ProfileMappingRecord &R, std::vector<StringRef> &FunctionsFilenames,
+    std::vector<CounterExpression> &Expressions,
+    std::vector<CounterMappingRegion> &MappingRegions) const {
+  RawCoverageMappingReader Reader(
+      R.CoverageMapping,
+      makeArrayRef(Filenames).slice(R.FilenamesBegin, R.FilenamesSize),
+      FunctionsFilenames, Expressions, MappingRegions);
+  return Reader.read();
+}
+
 Error BinaryCoverageReader::readNextRecord(CoverageMappingRecord &Record) {
   if (CurrentRecord >= MappingRecords.size())
     return make_error<CoverageMapError>(coveragemap_error::eof);
@@ -732,11 +751,8 @@ Error BinaryCoverageReader::readNextRecord(CoverageMappingRecord &Record) {
   Expressions.clear();
   MappingRegions.clear();
   auto &R = MappingRecords[CurrentRecord];
-  RawCoverageMappingReader Reader(
-      R.CoverageMapping,
-      makeArrayRef(Filenames).slice(R.FilenamesBegin, R.FilenamesSize),
-      FunctionsFilenames, Expressions, MappingRegions);
-  if (auto Err = Reader.read())
+  if (auto Err =
+          decodeRecord(R, FunctionsFilenames, Expressions, MappingRegions))
     return Err;
 
   Record.FunctionName = R.FunctionName;
@@ -748,3 +764,307 @@ Error BinaryCoverageReader::readNextRecord(CoverageMappingRecord &Record) {
   ++CurrentRecord;
   return Error::success();
 }
+
+Expected<std::unique_ptr<DecodedCoverageReader>>
+DecodedCoverageReader::create(std::unique_ptr<BinaryCoverageReader> Reader,
+                              unsigned NumThreads) {
+  std::unique_ptr<DecodedCoverageReader> Decoded(new DecodedCoverageReader());
+  const auto &MappingRecords = Reader->MappingRecords;
+  auto &Records = Decoded->Records;
+  Records.resize(MappingRecords.size());
+
+  // Decode the records in contiguous chunks. Each task only writes to the
+  // records of its own chunk, and remembers the first record it failed to
+  // decode so that the error can be reproduced deterministically below.
+  auto DecodeRange = [&](size_t Begin, size_t End, size_t &FirstFailure) {
+    for (size_t I = Begin; I != End; ++I) {
+      DecodedRecord &D = Records[I];
+      D.FunctionName = MappingRecords[I].FunctionName;
+      D.FunctionHash = MappingRecords[I].FunctionHash;
+      if (Error E = Reader->decodeRecord(MappingRecords[I], D.Filenames,
+                                         D.Expressions, D.MappingRegions)) {
+        consumeError(std::move(E));
+        FirstFailure = I;
+        return;
+      }
+    }
+  };
+
+  if (NumThreads == 0)
+    NumThreads = hardware_concurrency();
+  // Records are small, so don't bother spawning threads for a handful of them.
+  const size_t MinRecordsPerChunk = 64;
+  size_t NumChunks = std::min<size_t>(NumThreads * 4,
+                                      Records.size() / MinRecordsPerChunk);
+  std::vector<size_t> FirstFailures(std::max<size_t>(NumChunks, 1),
+                                    Records.size());
+  if (NumThreads <= 1 || NumChunks <= 1) {
+    DecodeRange(0, Records.size(), FirstFailures[0]);
+  } else {
+    size_t ChunkSize = divideCeil(Records.size(), NumChunks);
+    ThreadPool Pool(std::min<size_t>(NumThreads, NumChunks));
+    for (size_t Chunk = 0; Chunk != NumChunks; ++Chunk) {
+      size_t Begin = std::min(Chunk * ChunkSize, Records.size());
+      size_t End = std::min(Begin + ChunkSize, Records.size());
+      Pool.async(DecodeRange, Begin, End, std::ref(FirstFailures[Chunk]));
+    }
+    Pool.wait();
+  }
+
+  size_t FirstFailure =
+      *std::min_element(FirstFailures.begin(), FirstFailures.end());
+  if (FirstFailure != Records.size()) {
+    DecodedRecord &D = Records[FirstFailure];
+    D.Filenames.clear();
+    D.Expressions.clear();
+    D.MappingRegions.clear();
+    if (Error E = Reader->decodeRecord(MappingRecords[FirstFailure],
+                                       D.Filenames, D.Expressions,
+                                       D.MappingRegions))
+      return std::move(E);
+    llvm_unreachable("coverage mapping record decoded inconsistently");
+  }
+
+  Decoded->Source = std::move(Reader);
+  return std::move(Decoded);
+}
+
+namespace {
+
+const char CacheMagic[8] = {'L', 'L', 'V', 'M', 'C', 'O', 'V', 'C'};
+
+/// The version of the mapping cache layout. Bump it whenever the layout
+/// changes, so that caches written by older builds are decoded again instead
+/// of being misread.
+const uint32_t CacheVersion = 1;
+const size_t CacheHeaderSize = sizeof(CacheMagic) + sizeof(CacheVersion);
+
+/// Reader for the contents of a mapping cache file.
+class CoverageCacheReader : public RawCoverageReader {
+  std::vector<StringRef> Strings;
+
+  Error readStringRef(StringRef &Result) {
+    uint64_t Index;
+    if (auto Err = readIntMax(Index, Strings.size()))
+      return Err;
+    Result = Strings[Index];
+    return Error::success();
+  }
+
+  Error readUnsigned(unsigned &Result) {
+    uint64_t Value;
+    if (auto Err = readIntMax(Value, uint64_t(UINT32_MAX) + 1))
+      return Err;
+    Result = Value;
+    return Error::success();
+  }
+
+  Error readCounter(Counter &C) {
+    uint64_t Kind;
+    unsigned ID;
+    if (auto Err = readIntMax(Kind, Counter::Expression + 1))
+      return Err;
+    if (auto Err = readUnsigned(ID))
+      return Err;
+    switch (Kind) {
+    case Counter::Zero:
+      C = Counter::getZero();
+      break;
+    case Counter::CounterValueReference:
+      C = Counter::getCounter(ID);
+      break;
+    default:
+      C = Counter::getExpression(ID);
+      break;
+    }
+    return Error::success();
+  }
+
+public:
+  CoverageCacheReader(StringRef Data) : RawCoverageReader(Data) {}
+
+  template <typename RecordT> Error read(std::vector<RecordT> &Records) {
+    uint64_t NumStrings;
+    if (auto Err = readSize(NumStrings))
+      return Err;
+    Strings.resize(NumStrings);
+    for (StringRef &S : Strings)
+      if (auto Err = readString(S))
+        return Err;
+
+    uint64_t NumRecords;
+    if (auto Err = readSize(NumRecords))
+      return Err;
+    Records.resize(NumRecords);
+    for (RecordT &R : Records) {
+      uint64_t Size;
+      if (auto Err = readStringRef(R.FunctionName))
+        return Err;
+      if (auto Err = readULEB128(R.FunctionHash))
+        return Err;
+
+      if (auto Err = readSize(Size))
+        return Err;
+      R.Filenames.resize(Size);
+      for (StringRef &Filename : R.Filenames)
+        if (auto Err = readStringRef(Filename))
+          return Err;
+
+      if (auto Err = readSize(Size))
+        return Err;
+      R.Expressions.reserve(Size);
+      for (uint64_t I = 0; I != Size; ++I) {
+        uint64_t Kind;
+        Counter LHS, RHS;
+        if (auto Err = readIntMax(Kind, CounterExpression::Add + 1))
+          return Err;
+        if (auto Err = readCounter(LHS))
+          return Err;
+        if (auto Err = readCounter(RHS))
+          return Err;
+        R.Expressions.emplace_back(CounterExpression::ExprKind(Kind), LHS, RHS);
+      }
+
+      if (auto Err = readSize(Size))
+        return Err;
+      R.MappingRegions.reserve(Size);
+      for (uint64_t I = 0; I != Size; ++I) {
+        Counter C;
+        unsigned FileID, ExpandedFileID, LineStart, ColumnStart, LineEnd,
+            ColumnEnd;
+        uint64_t Kind;
+        if (auto Err = readCounter(C))
+          return Err;
+        if (auto Err = readUnsigned(FileID))
+          return Err;
+        if (auto Err = readUnsigned(ExpandedFileID))
+          return Err;
+        if (auto Err = readUnsigned(LineStart))
+          return Err;
+        if (auto Err = readUnsigned(ColumnStart))
+          return Err;
+        if (auto Err = readUnsigned(LineEnd))
+          return Err;
+        if (auto Err = readUnsigned(ColumnEnd))
+          return Err;
+        if (auto Err = readIntMax(Kind, CounterMappingRegion::GapRegion + 1))
+          return Err;
+        R.MappingRegions.emplace_back(
+            C, FileID, ExpandedFileID, LineStart, ColumnStart, LineEnd,
+            ColumnEnd, CounterMappingRegion::RegionKind(Kind));
+      }
+    }
+
+    if (!Data.empty())
+      return make_error<CoverageMapError>(coveragemap_error::malformed);
+    return Error::success();
+  }
+};
+
+} // end anonymous namespace
+
+Expected<std::unique_ptr<DecodedCoverageReader>>
+DecodedCoverageReader::createFromCache(std::unique_ptr<MemoryBuffer> Buffer) {
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < CacheHeaderSize ||
+      !Data.startswith(StringRef(CacheMagic, sizeof(CacheMagic))))
+    return make_error<CoverageMapError>(coveragemap_error::malformed);
+  if (support::endian::read32le(Data.data() + sizeof(CacheMagic)) !=
+      CacheVersion)
+    return make_error<CoverageMapError>(coveragemap_error::unsupported_version);
+
+  std::unique_ptr<DecodedCoverageReader> Decoded(new DecodedCoverageReader());
+  CoverageCacheReader Reader(Data.drop_front(CacheHeaderSize));
+  if (Error E = Reader.read(Decoded->Records))
+    return std::move(E);
+  Decoded->CacheBuffer = std::move(Buffer);
+  return std::move(Decoded);
+}
+
+static void writeCounter(raw_ostream &OS, Counter C) {
+  encodeULEB128(C.getKind(), OS);
+  encodeULEB128(C.getCounterID(), OS);
+}
+
+Error DecodedCoverageReader::writeCache(StringRef Path) const {
+  // Function names and filenames repeat a lot across records, so they are
+  // written once to a string table.
+  StringMap<unsigned> StringIndices;
+  std::vector<StringRef> Strings;
+  auto addString = [&](StringRef S) {
+    auto Inserted = StringIndices.insert({S, Strings.size()});
+    if (Inserted.second)
+      Strings.push_back(S);
+  };
+  for (const DecodedRecord &R : Records) {
+    addString(R.FunctionName);
+    for (StringRef Filename : R.Filenames)
+      addString(Filename);
+  }
+
+  Expected<sys::fs::TempFile> Temp =
+      sys::fs::TempFile::create(Path + ".tmp%%%%%%");
+  if (!Temp)
+    return Temp.takeError();
+  {
+    raw_fd_ostream OS(Temp->FD, /*shouldClose=*/false);
+    OS.write(CacheMagic, sizeof(CacheMagic));
+    support::endian::write<uint32_t>(OS, CacheVersion, support::little);
+    encodeULEB128(Strings.size(), OS);
+    for (StringRef S : Strings) {
+      encodeULEB128(S.size(), OS);
+      OS << S;
+    }
+
+    encodeULEB128(Records.size(), OS);
+    for (const DecodedRecord &R : Records) {
+      encodeULEB128(StringIndices[R.FunctionName], OS);
+      encodeULEB128(R.FunctionHash, OS);
+      encodeULEB128(R.Filenames.size(), OS);
+      for (StringRef Filename : R.Filenames)
+        encodeULEB128(StringIndices[Filename], OS);
+      encodeULEB128(R.Expressions.size(), OS);
+      for (const CounterExpression &E : R.Expressions) {
+        encodeULEB128(E.Kind, OS);
+        writeCounter(OS, E.LHS);
+        writeCounter(OS, E.RHS);
+      }
+      encodeULEB128(R.MappingRegions.size(), OS);
+      for (const CounterMappingRegion &MR : R.MappingRegions) {
+        writeCounter(OS, MR.Count);
+        encodeULEB128(MR.FileID, OS);
+        encodeULEB128(MR.ExpandedFileID, OS);
+        encodeULEB128(MR.LineStart, OS);
+        encodeULEB128(MR.ColumnStart, OS);
+        encodeULEB128(MR.LineEnd, OS);
+        encodeULEB128(MR.ColumnEnd, OS);
+        encodeULEB128(MR.Kind, OS);
+      }
+    }
+
+    OS.flush();
+    if (OS.has_error()) {
+      OS.clear_error();
+      consumeError(Temp->discard());
+      return createStringError(errc::io_error,
+                               "failed to write coverage mapping cache '%s'",
+                               Path.str().c_str());
+    }
+  }
+  return Temp->keep(Path);
+}
+
+Error DecodedCoverageReader::readNextRecord(CoverageMappingRecord &Record) {
+  if (CurrentRecord >= Records.size())
+    return make_error<CoverageMapError>(coveragemap_error::eof);
+
+  const DecodedRecord &R = Records[CurrentRecord];
+  Record.FunctionName = R.FunctionName;
+  Record.FunctionHash = R.FunctionHash;
+  Record.Filenames = R.Filenames;
+  Record.Expressions = R.Expressions;
+  Record.MappingRegions = R.MappingRegions;
+
+  ++CurrentRecord;
+  return Error::success();
+}
@@ -502,60 +502,83 @@ InstrProfLookupTrait::ComputeHash(StringRef K) {
 using data_type = InstrProfLookupTrait::data_type;
 using offset_type = InstrProfLookupTrait::offset_type;
 
-bool InstrProfLookupTrait::readValueProfilingData(
-    const unsigned char *&D, const unsigned char *const End) {
-  Expected<std::unique_ptr<ValueProfData>> VDataPtrOrErr =
-      ValueProfData::getValueProfData(D, End, ValueProfDataEndianness);
-
-  if (VDataPtrOrErr.takeError())
-    return false;
-
-  VDataPtrOrErr.get()->deserializeTo(DataBuffer.back(), nullptr);
-  D += VDataPtrOrErr.get()->TotalSize;
+Error OnDiskInstrProfRecord::decode(InstrProfRecord &Record,
+                                    bool ReadValueProfile) const {
+  Record.Counts.assign(Counts.begin(), Counts.end());
+  if (!ReadValueProfile || ValueData.empty())
+    return Error::success();
 
-  return true;
+  Expected<std::unique_ptr<ValueProfData>> VDataPtrOrErr =
+      ValueProfData::getValueProfData(ValueData.begin(), ValueData.end(),
+                                      ValueDataEndianness);
+  if (Error E = VDataPtrOrErr.takeError())
+    return E;
+  VDataPtrOrErr.get()->deserializeTo(Record, nullptr);
+  return Error::success();
 }
 
-data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
-                                         offset_type N) {
+bool InstrProfLookupTrait::readRawRecords(
+    const unsigned char *D, offset_type N,
+    SmallVectorImpl<OnDiskInstrProfRecord> &Records) const {
   using namespace support;
 
   // Check if the data is corrupt. If so, don't try to read it.
   if (N % sizeof(uint64_t))
-    return data_type();
-
-  DataBuffer.clear();
-  std::vector<uint64_t> CounterBuffer;
+    return false;
 
   const unsigned char *End = D + N;
   while (D < End) {
+    OnDiskInstrProfRecord Record;
+
     // Read hash.
     if (D + sizeof(uint64_t) >= End)
-      return data_type();
-    uint64_t Hash = endian::readNext<uint64_t, little, unaligned>(D);
+      return false;
+    Record.Hash = endian::readNext<uint64_t, little, unaligned>(D);
 
     // Initialize number of counters for GET_VERSION(FormatVersion) == 1.
     uint64_t CountsSize = N / sizeof(uint64_t) - 1;
     // If format version is different then read the number of counters.
     if (GET_VERSION(FormatVersion) != IndexedInstrProf::ProfVersion::Version1) {
       if (D + sizeof(uint64_t) > End)
-        return data_type();
+        return false;
       CountsSize = endian::readNext<uint64_t, little, unaligned>(D);
     }
-    // Read counter values.
-    if (D + CountsSize * sizeof(uint64_t) > End)
-      return data_type();
-
-    CounterBuffer.clear();
-    CounterBuffer.reserve(CountsSize);
-    for (uint64_t J = 0; J < CountsSize; ++J)
-      CounterBuffer.push_back(endian::readNext<uint64_t, little, unaligned>(D));
+    // The counter values are used in place.
+    if (CountsSize > uint64_t(End - D) / sizeof(uint64_t))
+      return false;
+    Record.Counts = makeArrayRef(
+        reinterpret_cast<const support::ulittle64_t *>(D), CountsSize);
+    D += CountsSize * sizeof(uint64_t);
+
+    // Find the extent of the value profiling data, which is only decoded on
+    // demand.
+    if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2) {
+      if (D + sizeof(ValueProfData) > End)
+        return false;
+      uint32_t TotalSize =
+          endian::read<uint32_t, unaligned>(D, ValueProfDataEndianness);
+      if (TotalSize < sizeof(ValueProfData) || TotalSize > uint64_t(End - D))
+        return false;
+      Record.ValueData = makeArrayRef(D, TotalSize);
+      Record.ValueDataEndianness = ValueProfDataEndianness;
+      D += TotalSize;
+    }
+    Records.push_back(Record);
+  }
+  return true;
+}
 
-    DataBuffer.emplace_back(K, Hash, std::move(CounterBuffer));
+data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
+                                         offset_type N) {
+  DataBuffer.clear();
+  SmallVector<OnDiskInstrProfRecord, 4> Records;
+  if (!readRawRecords(D, N, Records))
+    return data_type();
 
-    // Read value profiling data.
-    if (GET_VERSION(FormatVersion) > IndexedInstrProf::ProfVersion::Version2 &&
-        !readValueProfilingData(D, End)) {
+  for (const OnDiskInstrProfRecord &Record : Records) {
+    DataBuffer.emplace_back(K, Record.Hash, std::vector<uint64_t>());
+    if (Error E = Record.decode(DataBuffer.back(), ReadValueProfile)) {
+      consumeError(std::move(E));
       DataBuffer.clear();
       return data_type();
     }
@@ -564,14 +587,16 @@ data_type InstrProfLookupTrait::ReadData(StringRef K, const unsigned char *D,
 }
 
 template <typename HashTableImpl>
-Error InstrProfReaderIndex<HashTableImpl>::getRecords(
-    StringRef FuncName, ArrayRef<NamedInstrProfRecord> &Data) {
+Error InstrProfReaderIndex<HashTableImpl>::getRawRecords(
+    StringRef FuncName, SmallVectorImpl<OnDiskInstrProfRecord> &Records) {
   auto Iter = HashTable->find(FuncName);
   if (Iter == HashTable->end())
     return make_error<InstrProfError>(instrprof_error::unknown_function);
 
-  Data = (*Iter);
-  if (Data.empty())
+  Records.clear();
+  if (!HashTable->getInfoObj().readRawRecords(Iter.getDataPtr(),
+                                              Iter.getDataLen(), Records) ||
+      Records.empty())
     return make_error<InstrProfError>(instrprof_error::malformed);
 
   return Error::success();
@@ -612,9 +637,10 @@ public:
   InstrProfReaderNullRemapper(InstrProfReaderIndexBase &Underlying)
       : Underlying(Underlying) {}
 
-  Error getRecords(StringRef FuncName,
-                   ArrayRef<NamedInstrProfRecord> &Data) override {
-    return Underlying.getRecords(FuncName, Data);
+  Error
+  getRawRecords(StringRef FuncName,
+                SmallVectorImpl<OnDiskInstrProfRecord> &Records) override {
+    return Underlying.getRawRecords(FuncName, Records);
   }
 };
 }
@@ -671,8 +697,9 @@ public:
     return Error::success();
   }
 
-  Error getRecords(StringRef FuncName,
-                   ArrayRef<NamedInstrProfRecord> &Data) override {
+  Error
+  getRawRecords(StringRef FuncName,
+                SmallVectorImpl<OnDiskInstrProfRecord> &Records) override {
     StringRef RealName = extractName(FuncName);
     if (auto Key = Remappings.lookup(RealName)) {
       StringRef Remapped = MappedNames.lookup(Key);
@@ -684,7 +711,7 @@ public:
           // Try rebuilding the name from the given remapping.
           SmallString<256> Reconstituted;
           reconstituteName(FuncName, RealName, Remapped, Reconstituted);
-          Error E = Underlying.getRecords(Reconstituted, Data);
+          Error E = Underlying.getRawRecords(Reconstituted, Records);
           if (!E)
             return E;
 
@@ -700,7 +727,7 @@ public:
         }
       }
     }
-    return Underlying.getRecords(FuncName, Data);
+    return Underlying.getRawRecords(FuncName, Records);
   }
 
 private:
@@ -852,31 +879,65 @@ InstrProfSymtab &IndexedInstrProfReader::getSymtab() {
 Expected<InstrProfRecord>
 IndexedInstrProfReader::getInstrProfRecord(StringRef FuncName,
                                            uint64_t FuncHash) {
-  ArrayRef<NamedInstrProfRecord> Data;
-  Error Err = Remapper->getRecords(FuncName, Data);
+  SmallVector<OnDiskInstrProfRecord, 4> Records;
+  Error Err = Remapper->getRawRecords(FuncName, Records);
   if (Err)
     return std::move(Err);
-  // Found it. Look for counters with the right hash.
-  for (unsigned I = 0, E = Data.size(); I < E; ++I) {
-    // Check for a match and fill the vector if there is one.
-    if (Data[I].Hash == FuncHash) {
-      return std::move(Data[I]);
+  // Found it. Look for counters with the right hash, and only decode those.
+  for (const OnDiskInstrProfRecord &Raw : Records) {
+    if (Raw.Hash == FuncHash) {
+      InstrProfRecord Record;
+      if (Error E = Raw.decode(Record)) {
+        consumeError(std::move(E));
+        return error(instrprof_error::malformed);
+      }
+      return std::move(Record);
     }
   }
   return error(instrprof_error::hash_mismatch);
 }
 
+Expected<ArrayRef<support::ulittle64_t>>
+IndexedInstrProfReader::getFunctionCountsView(StringRef FuncName,
+                                              uint64_t FuncHash) {
+  SmallVector<OnDiskInstrProfRecord, 4> Records;
+  Error Err = Remapper->getRawRecords(FuncName, Records);
+  if (Err)
+    return std::move(Err);
+  for (const OnDiskInstrProfRecord &Raw : Records)
+    if (Raw.Hash == FuncHash)
+      return Raw.Counts;
+  return error(instrprof_error::hash_mismatch);
+}
+
 Error IndexedInstrProfReader::getFunctionCounts(StringRef FuncName,
                                                 uint64_t FuncHash,
                                                 std::vector<uint64_t> &Counts) {
-  Expected<InstrProfRecord> Record = getInstrProfRecord(FuncName, FuncHash);
-  if (Error E = Record.takeError())
+  Expected<ArrayRef<support::ulittle64_t>> View =
+      getFunctionCountsView(FuncName, FuncHash);
+  if (Error E = View.takeError())
     return error(std::move(E));
 
-  Counts = Record.get().Counts;
+  Counts.assign(View->begin(), View->end());
   return success();
 }
 
+Error IndexedInstrProfReader::getFunctionRecords(
+    StringRef FuncName, std::vector<NamedInstrProfRecord> &Records) {
+  Records.clear();
+  SmallVector<OnDiskInstrProfRecord, 4> RawRecords;
+  if (Error E = Index->getRawRecords(FuncName, RawRecords))
+    return E;
+  for (const OnDiskInstrProfRecord &Raw : RawRecords) {
+    Records.emplace_back(FuncName, Raw.Hash, std::vector<uint64_t>());
+    if (Error E = Raw.decode(Records.back())) {
+      consumeError(std::move(E));
+      return make_error<InstrProfError>(instrprof_error::malformed);
+    }
+  }
+  return Error::success();
+}
+
 Error IndexedInstrProfReader::readNextRecord(NamedInstrProfRecord &Record) {
   ArrayRef<NamedInstrProfRecord> Data;
 
@@ -359,7 +359,10 @@ ErrorOr<StringRef> SampleProfileReaderCompactBinary::readStringFromTable() {
   if (std::error_code EC = Idx.getError())
     return EC;
 
-  return StringRef(NameTable[*Idx]);
+  std::string &Name = NameStrings[*Idx];
+  if (Name.empty())
+    Name = std::to_string(NameTable[*Idx]);
+  return StringRef(Name);
 }
 
 std::error_code
@@ -469,18 +472,22 @@ std::error_code SampleProfileReaderBinary::read() {
 }
 
 std::error_code SampleProfileReaderCompactBinary::read() {
+  if (UseAllFuncs)
+    return SampleProfileReaderBinary::read();
+
+  const uint8_t *SavedData = Data;
   for (auto Name : FuncsToUse) {
-    auto GUID = std::to_string(MD5Hash(Name));
-    auto iter = FuncOffsetTable.find(StringRef(GUID));
+    auto iter = FuncOffsetTable.find(MD5Hash(Name));
     if (iter == FuncOffsetTable.end())
       continue;
-    const uint8_t *SavedData = Data;
     Data = reinterpret_cast<const uint8_t *>(Buffer->getBufferStart()) +
            iter->second;
+    if (Data >= End)
+      return sampleprof_error::malformed;
     if (std::error_code EC = readFuncProfile())
       return EC;
-    Data = SavedData;
   }
+  Data = SavedData;
   return sampleprof_error::success;
 }
 
@@ -521,8 +528,9 @@ std::error_code SampleProfileReaderCompactBinary::readNameTable() {
     auto FID = readNumber<uint64_t>();
     if (std::error_code EC = FID.getError())
       return EC;
-    NameTable.push_back(std::to_string(*FID));
+    NameTable.push_back(*FID);
   }
+  NameStrings.resize(NameTable.size());
   return sampleprof_error::success;
 }
 
@@ -553,7 +561,8 @@ std::error_code SampleProfileReaderBinary::readHeader() {
 }
 
 std::error_code SampleProfileReaderCompactBinary::readHeader() {
-  SampleProfileReaderBinary::readHeader();
+  if (std::error_code EC = SampleProfileReaderBinary::readHeader())
+    return EC;
   if (std::error_code EC = readFuncOffsetTable())
     return EC;
   return sampleprof_error::success;
@@ -564,6 +573,9 @@ std::error_code SampleProfileReaderCompactBinary::readFuncOffsetTable() {
   if (std::error_code EC = TableOffset.getError())
     return EC;
 
+  if (*TableOffset > Buffer->getBufferSize())
+    return sampleprof_error::malformed;
+
   const uint8_t *SavedData = Data;
   const uint8_t *TableStart =
       reinterpret_cast<const uint8_t *>(Buffer->getBufferStart()) +
@@ -576,15 +588,15 @@ std::error_code SampleProfileReaderCompactBinary::readFuncOffsetTable() {
 
   FuncOffsetTable.reserve(*Size);
   for (uint32_t I = 0; I < *Size; ++I) {
-    auto FName(readStringFromTable());
-    if (std::error_code EC = FName.getError())
+    auto Idx = readStringIndex(NameTable);
+    if (std::error_code EC = Idx.getError())
       return EC;
 
     auto Offset = readNumber<uint64_t>();
     if (std::error_code EC = Offset.getError())
       return EC;
 
-    FuncOffsetTable[*FName] = *Offset;
+    FuncOffsetTable[NameTable[*Idx]] = *Offset;
   }
   End = TableStart;
   Data = SavedData;
@@ -592,8 +604,13 @@ std::error_code SampleProfileReaderCompactBinary::readFuncOffsetTable() {
 }
 
 void SampleProfileReaderCompactBinary::collectFuncsToUse(const Module &M) {
+  UseAllFuncs = false;
   FuncsToUse.clear();
   for (auto &F : M) {
+    // Only the profiles of defined functions are looked up. The profiles of
+    // their callees that get inlined are nested in their own.
+    if (F.isDeclaration())
+      continue;
     StringRef Fname = F.getName().split('.').first;
     FuncsToUse.insert(Fname);
   }
@@ -0,0 +1,75 @@
+//===- ShardedStringPool.cpp - Concurrent string table builder ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ShardedStringPool.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+using namespace llvm;
+
+ShardedStringPool::ShardedStringPool(unsigned NumShards)
+    : NumShards(PowerOf2Ceil(std::max(NumShards, 1U))) {
+  Shards.reset(new Shard[this->NumShards]);
+}
+
+ShardedStringPool::Shard &ShardedStringPool::getShard(StringRef S) const {
+  // StringMap hashes with DJB internally; use an unrelated hash to pick the
+  // shard so that the buckets within a shard stay evenly populated.
+  return Shards[xxHash64(S) & (NumShards - 1)];
+}
+
+StringRef ShardedStringPool::intern(StringRef S) {
+  assert(!Finalized && "interning into a finalized pool");
+  Shard &Sh = getShard(S);
+  std::lock_guard<std::mutex> Lock(Sh.Mutex);
+  return Sh.Strings.insert({S, 0}).first->getKey();
+}
+
+size_t ShardedStringPool::size() const {
+  size_t Result = 0;
+  for (unsigned I = 0; I != NumShards; ++I) {
+    std::lock_guard<std::mutex> Lock(Shards[I].Mutex);
+    Result += Shards[I].Strings.size();
+  }
+  return Result;
+}
+
+void ShardedStringPool::finalize() {
+  if (Finalized)
+    return;
+  Sorted.reserve(size());
+  for (unsigned I = 0; I != NumShards; ++I)
+    for (const auto &Entry : Shards[I].Strings)
+      Sorted.push_back(Entry.getKey());
+  llvm::sort(Sorted);
+
+  for (StringRef S : Sorted) {
+    getShard(S).Strings.find(S)->second = Size;
+    Size += S.size() + 1;
+  }
+  Finalized = true;
+}
+
+uint64_t ShardedStringPool::getOffset(StringRef S) const {
+  assert(Finalized && "pool is not finalized");
+  const Shard &Sh = getShard(S);
+  auto I = Sh.Strings.find(S);
+  assert(I != Sh.Strings.end() && "string was not interned");
+  return I->second;
+}
+
+void ShardedStringPool::write(raw_ostream &OS) const {
+  assert(Finalized && "pool is not finalized");
+  for (StringRef S : Sorted) {
+    OS << S;
+    OS.write('\0');
+  }
+}
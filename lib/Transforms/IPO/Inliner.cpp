@@ -83,6 +83,15 @@ STATISTIC(NumMergedAllocas, "Number of allocas merged together");
 // if those would be more profitable and blocked inline steps.
 STATISTIC(NumCallerCallersAnalyzed, "Number of caller-callers analyzed");
 
+STATISTIC(NumInlineCostCacheHits, "Number of inline costs reused from cache");
+STATISTIC(NumInlineCostCacheMisses, "Number of inline costs computed");
+
+/// Flag to disable the cache of inline costs kept across inliner iterations.
+static cl::opt<bool> EnableInlineCostCache(
+    "inline-cost-cache", cl::init(true), cl::Hidden,
+    cl::desc("Reuse the inline cost of a call site until its caller or "
+             "callee changes"));
+
 /// Flag to disable manual alloca merging.
 ///
 /// Merging of allocas was originally done as a stack-size saving technique
@@ -299,6 +308,74 @@ static InlineResult InlineCallIfPossible(
   return IR; // success
 }
 
+namespace {
+
+/// Memoizes inline cost queries while the inliner works on one SCC.
+///
+/// The same call site is often costed many times: once per round of the
+/// inliner's fixpoint loop and once for every candidate in its callee that
+/// shouldBeDeferred considers. A cached cost stays valid until the inliner
+/// reports a change to the caller or callee through \c invalidate, or the
+/// callee gains or loses its only use, which the cost's last-call bonus
+/// depends on.
+class InlineCostCache {
+  struct Entry {
+    Function *Caller;
+    Function *Callee;
+    unsigned CallerEpoch;
+    unsigned CalleeEpoch;
+    bool CalleeHasOneUse;
+    InlineCost IC;
+  };
+
+  DenseMap<Instruction *, Entry> Costs;
+  DenseMap<Function *, unsigned> Epochs;
+  bool Enabled;
+
+public:
+  /// The cache is bypassed when cost analysis remarks are requested, so
+  /// that every query still emits them.
+  InlineCostCache(LLVMContext &Ctx)
+      : Enabled(EnableInlineCostCache && !Ctx.getDiagnosticsOutputFile() &&
+                !Ctx.getDiagHandlerPtr()->isAnyRemarkEnabled("inline-cost")) {}
+
+  /// Return the cost of \p CS, calling \p GetInlineCost only if no valid
+  /// cost is cached.
+  InlineCost get(CallSite CS,
+                 function_ref<InlineCost(CallSite CS)> GetInlineCost) {
+    Function *Callee = CS.getCalledFunction();
+    if (!Enabled || !Callee)
+      return GetInlineCost(CS);
+
+    Function *Caller = CS.getCaller();
+    unsigned CallerEpoch = Epochs.lookup(Caller);
+    unsigned CalleeEpoch = Epochs.lookup(Callee);
+    auto I = Costs.find(CS.getInstruction());
+    if (I != Costs.end()) {
+      const Entry &E = I->second;
+      if (E.Caller == Caller && E.Callee == Callee &&
+          E.CallerEpoch == CallerEpoch && E.CalleeEpoch == CalleeEpoch &&
+          E.CalleeHasOneUse == Callee->hasOneUse()) {
+        ++NumInlineCostCacheHits;
+        return E.IC;
+      }
+      Costs.erase(I);
+    }
+
+    ++NumInlineCostCacheMisses;
+    InlineCost IC = GetInlineCost(CS);
+    Costs.insert({CS.getInstruction(),
+                  Entry{Caller, Callee, CallerEpoch, CalleeEpoch,
+                        Callee->hasOneUse(), IC}});
+    return IC;
+  }
+
+  /// Forget every cost computed for calls in or to \p F, which has changed.
+  void invalidate(Function *F) { ++Epochs[F]; }
+};
+
+} // end anonymous namespace
+
 /// Return true if inlining of CS can block the caller from being
 /// inlined which is proved to be more beneficial. \p IC is the
 /// estimated inline cost associated with callsite \p CS.
@@ -606,6 +683,11 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
   InlinedArrayAllocasTy InlinedArrayAllocas;
   InlineFunctionInfo InlineInfo(&CG, &GetAssumptionCache, PSI);
 
+  InlineCostCache CostCache(CG.getModule().getContext());
+  auto GetCachedInlineCost = [&](CallSite CS) {
+    return CostCache.get(CS, GetInlineCost);
+  };
+
   // Now that we have all of the call sites, loop over them and inline them if
   // it looks profitable to do so.
   bool Changed = false;
@@ -649,7 +731,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
       // just become a regular analysis dependency.
       OptimizationRemarkEmitter ORE(Caller);
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC = shouldInline(CS, GetCachedInlineCost, ORE);
       // If the policy determines that we should inline this function,
       // delete the call instead.
       if (!OIC.hasValue()) {
@@ -674,6 +756,7 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
         setInlineRemark(CS, "trivially dead");
         CG[Caller]->removeCallEdgeFor(CS);
         Instr->eraseFromParent();
+        CostCache.invalidate(Caller);
         ++NumCallsDeleted;
       } else {
         // Get DebugLoc to report. CS will be invalid after Inliner.
@@ -686,6 +769,11 @@ inlineCallsImpl(CallGraphSCC &SCC, CallGraph &CG,
         InlineResult IR = InlineCallIfPossible(
             CS, InlineInfo, InlinedArrayAllocas, InlineHistoryID,
             InsertLifetime, AARGetter, ImportedFunctionsStats);
+        // Even a failed attempt may have touched the caller. Inlining also
+        // lowers the callee's entry count and rescales the profile of the
+        // calls in its body, which the costs of its calls depend on.
+        CostCache.invalidate(Caller);
+        CostCache.invalidate(Callee);
         if (!IR) {
           setInlineRemark(CS, std::string(IR) + "; " + inlineCostStr(*OIC));
           ORE.emit([&]() {
@@ -954,6 +1042,10 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
   // index into the InlineHistory vector.
   SmallVector<std::pair<Function *, int>, 16> InlineHistory;
 
+  // Costs are reused across callers and rounds until the functions involved
+  // change.
+  InlineCostCache CostCache(M.getContext());
+
   // Track a set vector of inlined callees so that we can augment the caller
   // with all of their edges in the call graph before pruning out the ones that
   // got simplified away.
@@ -1040,7 +1132,9 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
         continue;
       }
 
-      Optional<InlineCost> OIC = shouldInline(CS, GetInlineCost, ORE);
+      Optional<InlineCost> OIC = shouldInline(
+          CS, [&](CallSite CS) { return CostCache.get(CS, GetInlineCost); },
+          ORE);
       // Check whether we want to inline this callsite.
       if (!OIC.hasValue()) {
         setInlineRemark(CS, "deferred");
@@ -1068,6 +1162,11 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
       using namespace ore;
 
       InlineResult IR = InlineFunction(CS, IFI);
+      // Even a failed attempt may have touched the caller. Inlining also
+      // lowers the callee's entry count and rescales the profile of the calls
+      // in its body, which the costs of its calls depend on.
+      CostCache.invalidate(&F);
+      CostCache.invalidate(&Callee);
       if (!IR) {
         setInlineRemark(CS, std::string(IR) + "; " + inlineCostStr(*OIC));
         ORE.emit([&]() {
@@ -1120,6 +1219,7 @@ PreservedAnalyses InlinerPass::run(LazyCallGraph::SCC &InitialC,
           // Note that after this point, it is an error to do anything other
           // than use the callee's address or delete it.
           Callee.dropAllReferences();
+          CostCache.invalidate(&Callee);
           assert(find(DeadFunctions, &Callee) == DeadFunctions.end() &&
                  "Cannot put cause a function to become dead twice!");
           DeadFunctions.push_back(&Callee);
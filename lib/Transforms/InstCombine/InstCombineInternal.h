@@ -734,6 +734,20 @@ public:
   /// Maximum size of array considered when transforming.
   uint64_t MaxArraySizeForCombine;
 
+  /// Maximum number of instructions run() may visit, or zero for no limit.
+  /// When the budget runs out the remaining worklist is dropped.
+  uint64_t MaxVisits = 0;
+
+  /// Number of instructions visited by run() so far.
+  uint64_t NumVisits = 0;
+
+  /// Set when run() dropped a non-empty worklist because of MaxVisits.
+  bool VisitBudgetExhausted = false;
+
+  /// When non-null, the number of times a visitor changed an instruction,
+  /// indexed by the opcode of the instruction it was visiting.
+  SmallVectorImpl<unsigned> *VisitorFires = nullptr;
+
 private:
   /// Performs a few simplifications for operators which are associative
   /// or commutative.
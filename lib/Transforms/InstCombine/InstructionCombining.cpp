@@ -43,6 +43,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/AssumptionCache.h"
@@ -116,6 +117,16 @@ STATISTIC(NumSunkInst , "Number of instructions sunk");
 STATISTIC(NumExpand,    "Number of expansions");
 STATISTIC(NumFactor   , "Number of factorizations");
 STATISTIC(NumReassoc  , "Number of reassociations");
+STATISTIC(NumWorklistIterations,
+          "Number of instruction combining iterations performed");
+STATISTIC(NumOneIteration, "Number of functions with one iteration");
+STATISTIC(NumTwoIterations, "Number of functions with two iterations");
+STATISTIC(NumThreeIterations, "Number of functions with three iterations");
+STATISTIC(NumFourOrMoreIterations,
+          "Number of functions with four or more iterations");
+STATISTIC(NumInstVisits, "Number of instructions visited");
+STATISTIC(NumVisitBudgetExhausted,
+          "Number of functions that ran out of instruction visits");
 DEBUG_COUNTER(VisitCounter, "instcombine-visit",
               "Controls which instructions are visited");
 
@@ -131,6 +142,16 @@ static cl::opt<unsigned>
 MaxArraySize("instcombine-maxarray-size", cl::init(1024),
              cl::desc("Maximum array size considered when doing a combine"));
 
+static cl::opt<unsigned> MaxVisitsPerFunction(
+    "instcombine-max-visits", cl::Hidden, cl::init(0),
+    cl::desc("Maximum number of instructions visited per function across all "
+             "iterations (0 = unlimited)"));
+
+static cl::opt<bool> IncrementalWorklist(
+    "instcombine-incremental-worklist", cl::Hidden, cl::init(false),
+    cl::desc("After the first iteration, only seed the worklist with the "
+             "instructions the previous iteration added to it"));
+
 // FIXME: Remove this flag when it is no longer necessary to convert
 // llvm.dbg.declare to avoid inaccurate debug info. Setting this to false
 // increases variable availability at the cost of accuracy. Variables that
@@ -3107,8 +3128,16 @@ static bool TryToSinkInstruction(Instruction *I, BasicBlock *DestBlock) {
 
 bool InstCombiner::run() {
   while (!Worklist.isEmpty()) {
+    if (MaxVisits && NumVisits >= MaxVisits) {
+      LLVM_DEBUG(dbgs() << "IC: Visit budget exhausted, dropping worklist\n");
+      Worklist.Clear();
+      VisitBudgetExhausted = true;
+      break;
+    }
+
     Instruction *I = Worklist.RemoveOne();
     if (I == nullptr) continue;  // skip null values.
+    ++NumVisits;
 
     // Check to see if we can DCE the instruction.
     if (isInstructionTriviallyDead(I, &TLI)) {
@@ -3209,8 +3238,11 @@ bool InstCombiner::run() {
     LLVM_DEBUG(raw_string_ostream SS(OrigI); I->print(SS); OrigI = SS.str(););
     LLVM_DEBUG(dbgs() << "IC: Visiting: " << OrigI << '\n');
 
+    unsigned Opcode = I->getOpcode();
     if (Instruction *Result = visit(*I)) {
       ++NumCombined;
+      if (VisitorFires)
+        ++(*VisitorFires)[Opcode];
       // Should we replace the old instruction with a new one?
       if (Result != I) {
         LLVM_DEBUG(dbgs() << "IC: Old = " << *I << '\n'
@@ -3272,7 +3304,8 @@ bool InstCombiner::run() {
 static bool AddReachableCodeToWorklist(BasicBlock *BB, const DataLayout &DL,
                                        SmallPtrSetImpl<BasicBlock *> &Visited,
                                        InstCombineWorklist &ICWorklist,
-                                       const TargetLibraryInfo *TLI) {
+                                       const TargetLibraryInfo *TLI,
+                                       bool OnlyRecorded) {
   bool MadeIRChange = false;
   SmallVector<BasicBlock*, 256> Worklist;
   Worklist.push_back(BB);
@@ -3337,8 +3370,15 @@ static bool AddReachableCodeToWorklist(BasicBlock *BB, const DataLayout &DL,
 
       // Skip processing debug intrinsics in InstCombine. Processing these call instructions
       // consumes non-trivial amount of time and provides no value for the optimization.
-      if (!isa<DbgInfoIntrinsic>(Inst))
-        InstrsForInstCombineWorklist.push_back(Inst);
+      if (isa<DbgInfoIntrinsic>(Inst))
+        continue;
+
+      // On incremental iterations only revisit what the last iteration
+      // touched; everything else already reached a fixpoint.
+      if (OnlyRecorded && !ICWorklist.wasAdded(Inst))
+        continue;
+
+      InstrsForInstCombineWorklist.push_back(Inst);
     }
 
     // Recursively visit successors.  If this is a branch or switch on a
@@ -3376,10 +3416,13 @@ static bool AddReachableCodeToWorklist(BasicBlock *BB, const DataLayout &DL,
 /// blocks discovered in the process.
 ///
 /// This also does basic constant propagation and other forward fixing to make
-/// the combiner itself run much faster.
+/// the combiner itself run much faster.  If \p OnlyRecorded is set, only the
+/// instructions the worklist recorded during the previous iteration are
+/// added, but the whole function is still folded and pruned.
 static bool prepareICWorklistFromFunction(Function &F, const DataLayout &DL,
                                           TargetLibraryInfo *TLI,
-                                          InstCombineWorklist &ICWorklist) {
+                                          InstCombineWorklist &ICWorklist,
+                                          bool OnlyRecorded = false) {
   bool MadeIRChange = false;
 
   // Do a depth-first traversal of the function, populate the worklist with
@@ -3387,7 +3430,8 @@ static bool prepareICWorklistFromFunction(Function &F, const DataLayout &DL,
   // track of which blocks we visit.
   SmallPtrSet<BasicBlock *, 32> Visited;
   MadeIRChange |=
-      AddReachableCodeToWorklist(&F.front(), DL, Visited, ICWorklist, TLI);
+      AddReachableCodeToWorklist(&F.front(), DL, Visited, ICWorklist, TLI,
+                                 OnlyRecorded);
 
   // Do a quick scan over the function.  If we find any blocks that are
   // unreachable, remove any instructions inside of them.  This prevents
@@ -3428,23 +3472,98 @@ static bool combineInstructionsOverFunction(
   if (ShouldLowerDbgDeclare)
     MadeIRChange = LowerDbgDeclare(F);
 
+  // Per-opcode visitor telemetry is only gathered when someone is listening
+  // for instcombine analysis remarks.
+  bool ReportSummary = ORE.allowExtraAnalysis(DEBUG_TYPE);
+  SmallVector<unsigned, 64> VisitorFires;
+  SmallVector<uint64_t, 4> IterationVisits;
+  if (ReportSummary)
+    VisitorFires.resize(Instruction::OtherOpsEnd);
+
+  // Record what each iteration touches so the next one can be seeded with
+  // just those instructions.
+  if (IncrementalWorklist)
+    Worklist.setRecordAdded(true);
+
   // Iterate while there is work to do.
   int Iteration = 0;
+  uint64_t TotalVisits = 0;
+  bool BudgetExhausted = false;
   while (true) {
     ++Iteration;
     LLVM_DEBUG(dbgs() << "\n\nINSTCOMBINE ITERATION #" << Iteration << " on "
                       << F.getName() << "\n");
 
-    MadeIRChange |= prepareICWorklistFromFunction(F, DL, &TLI, Worklist);
+    MadeIRChange |= prepareICWorklistFromFunction(
+        F, DL, &TLI, Worklist, IncrementalWorklist && Iteration > 1);
+    Worklist.clearRecorded();
 
     InstCombiner IC(Worklist, Builder, F.optForMinSize(), ExpensiveCombines, AA,
                     AC, TLI, DT, ORE, DL, LI);
     IC.MaxArraySizeForCombine = MaxArraySize;
-
-    if (!IC.run())
+    if (MaxVisitsPerFunction)
+      IC.MaxVisits = MaxVisitsPerFunction - TotalVisits;
+    if (ReportSummary)
+      IC.VisitorFires = &VisitorFires;
+
+    bool Changed = IC.run();
+    MadeIRChange |= Changed;
+    TotalVisits += IC.NumVisits;
+    if (ReportSummary)
+      IterationVisits.push_back(IC.NumVisits);
+    if (IC.VisitBudgetExhausted ||
+        (Changed && MaxVisitsPerFunction &&
+         TotalVisits >= MaxVisitsPerFunction)) {
+      LLVM_DEBUG(dbgs() << "IC: Visit budget of " << MaxVisitsPerFunction
+                        << " exhausted on " << F.getName() << "\n");
+      ++NumVisitBudgetExhausted;
+      BudgetExhausted = true;
+      break;
+    }
+    if (!Changed)
       break;
   }
 
+  if (IncrementalWorklist)
+    Worklist.setRecordAdded(false);
+
+  NumWorklistIterations += Iteration;
+  NumInstVisits += TotalVisits;
+  switch (Iteration) {
+  case 1:
+    ++NumOneIteration;
+    break;
+  case 2:
+    ++NumTwoIterations;
+    break;
+  case 3:
+    ++NumThreeIterations;
+    break;
+  default:
+    ++NumFourOrMoreIterations;
+    break;
+  }
+
+  if (ReportSummary) {
+    ORE.emit([&]() {
+      OptimizationRemarkAnalysis R(DEBUG_TYPE, "Summary", F.getSubprogram(),
+                                   &F.front());
+      R << "ran " << ore::NV("Iterations", Iteration)
+        << " iterations and " << ore::NV("Visits", TotalVisits) << " visits";
+      if (BudgetExhausted)
+        R << " (visit budget exhausted)";
+      R << "; visits per iteration: ";
+      for (unsigned I = 0, E = IterationVisits.size(); I != E; ++I)
+        R << (I ? ", " : "") << utostr(IterationVisits[I]);
+      for (unsigned Opcode = 0, E = VisitorFires.size(); Opcode != E; ++Opcode)
+        if (VisitorFires[Opcode])
+          R << "; " << Instruction::getOpcodeName(Opcode) << ": "
+            << ore::NV(Instruction::getOpcodeName(Opcode),
+                       VisitorFires[Opcode]);
+      return R;
+    });
+  }
+
   return MadeIRChange || Iteration > 1;
 }
 
@@ -77,6 +77,7 @@
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Transforms/Utils/Local.h"
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/BasicBlock.h"
@@ -140,6 +141,10 @@ STATISTIC(NumGVNDeadStores, "Number of redundant/dead stores eliminated");
 STATISTIC(NumGVNPHIOfOpsCreated, "Number of PHI of ops created");
 STATISTIC(NumGVNPHIOfOpsEliminations,
           "Number of things eliminated using PHI of ops");
+STATISTIC(NumGVNIterationLimitHit,
+          "Number of functions left unchanged after hitting the iteration "
+          "limit");
+STATISTIC(NumGVNLoadPRE, "Number of loads PRE'd");
 DEBUG_COUNTER(VNCounter, "newgvn-vn",
               "Controls which instructions are value numbered");
 DEBUG_COUNTER(PHIOfOpsCounter, "newgvn-phi",
@@ -154,6 +159,19 @@ static cl::opt<bool> EnableStoreRefinement("enable-store-refinement",
 static cl::opt<bool> EnablePhiOfOps("enable-phi-of-ops", cl::init(true),
                                     cl::Hidden);
 
+/// Bounds the compile time spent finding the fixpoint on pathological
+/// functions.  The congruence classes are only valid at the fixpoint, so a
+/// function that hits the limit is left unchanged.
+static cl::opt<unsigned> MaxIterations(
+    "newgvn-max-iterations", cl::init(100), cl::Hidden,
+    cl::desc("Maximum number of iterations over the touched instructions "
+             "before NewGVN gives up on a function (0 = unlimited)"));
+
+static cl::opt<bool> EnableLoadPRE(
+    "newgvn-load-pre", cl::init(false), cl::Hidden,
+    cl::desc("Make partially redundant loads fully redundant by loading them "
+             "in the predecessor where they are not available"));
+
 //===----------------------------------------------------------------------===//
 //                                GVN Pass
 //===----------------------------------------------------------------------===//
@@ -790,6 +808,7 @@ private:
                                     SmallVectorImpl<ValueDFS> &) const;
 
   bool eliminateInstructions(Function &);
+  bool performLoadPRE(LoadInst *);
   void replaceInstruction(Instruction *, Value *);
   void markInstructionForDeletion(Instruction *);
   void deleteInstructionsInBlock(BasicBlock *);
@@ -816,7 +835,8 @@ private:
   void addAdditionalUsers(Value *To, Value *User) const;
 
   // Main loop of value numbering
-  void iterateTouchedInstructions();
+  bool iterateTouchedInstructions();
+  void removePredicateInfoCopies();
 
   // Utilities.
   void cleanupTables();
@@ -3365,16 +3385,24 @@ void NewGVN::verifyStoreExpressions() const {
 
 // This is the main value numbering loop, it iterates over the initial touched
 // instruction set, propagating value numbers, marking things touched, etc,
-// until the set of touched instructions is completely empty.
-void NewGVN::iterateTouchedInstructions() {
+// until the set of touched instructions is completely empty.  Returns false if
+// MaxIterations was reached before that happened.
+bool NewGVN::iterateTouchedInstructions() {
   unsigned int Iterations = 0;
   // Figure out where touchedinstructions starts
   int FirstInstr = TouchedInstructions.find_first();
   // Nothing set, nothing to iterate, just return.
   if (FirstInstr == -1)
-    return;
+    return true;
   const BasicBlock *LastBlock = getBlockForValue(InstrFromDFSNum(FirstInstr));
   while (TouchedInstructions.any()) {
+    if (MaxIterations && Iterations >= MaxIterations) {
+      LLVM_DEBUG(dbgs() << "Giving up on " << F.getName() << " after "
+                        << Iterations << " iterations\n");
+      NumGVNMaxIterations =
+          std::max(NumGVNMaxIterations.getValue(), Iterations);
+      return false;
+    }
     ++Iterations;
     // Walk through all the instructions in all the blocks in RPO.
     // TODO: As we hit a new block, we should push and pop equalities into a
@@ -3424,6 +3452,21 @@ void NewGVN::iterateTouchedInstructions() {
     }
   }
   NumGVNMaxIterations = std::max(NumGVNMaxIterations.getValue(), Iterations);
+  return true;
+}
+
+// Undo the ssa.copy intrinsics PredicateInfo inserted, for when we bail out
+// before elimination would have removed them.
+void NewGVN::removePredicateInfoCopies() {
+  for (BasicBlock &BB : F)
+    for (auto I = BB.begin(), E = BB.end(); I != E;) {
+      auto *II = dyn_cast<IntrinsicInst>(&*I++);
+      if (!II || II->getIntrinsicID() != Intrinsic::ssa_copy ||
+          !PredInfo->getPredicateInfoFor(II))
+        continue;
+      II->replaceAllUsesWith(II->getOperand(0));
+      II->eraseFromParent();
+    }
 }
 
 // This is the main transformation entry point.
@@ -3487,13 +3530,31 @@ bool NewGVN::runGVN() {
                     << " marked reachable\n");
   ReachableBlocks.insert(&F.getEntryBlock());
 
-  iterateTouchedInstructions();
+  if (!iterateTouchedInstructions()) {
+    ++NumGVNIterationLimitHit;
+    removePredicateInfoCopies();
+    cleanupTables();
+    return false;
+  }
   verifyMemoryCongruency();
   verifyIterationSettled(F);
   verifyStoreExpressions();
 
   Changed |= eliminateInstructions(F);
 
+  if (EnableLoadPRE) {
+    // Collect the loads up front, as PRE inserts new ones.
+    SmallVector<LoadInst *, 16> Loads;
+    for (BasicBlock &BB : F)
+      if (ReachableBlocks.count(&BB))
+        for (Instruction &I : BB)
+          if (auto *LI = dyn_cast<LoadInst>(&I))
+            if (!InstructionsToErase.count(LI))
+              Loads.push_back(LI);
+    for (LoadInst *LI : Loads)
+      Changed |= performLoadPRE(LI);
+  }
+
   // Delete all instructions marked for deletion.
   for (Instruction *ToErase : InstructionsToErase) {
     if (!ToErase->use_empty())
@@ -3826,6 +3887,86 @@ Value *NewGVN::findPHIOfOpsLeader(const Expression *E,
   return nullptr;
 }
 
+// Load PRE for the simple cases: \p LI is the first instruction in its block
+// to read its memory, and on every incoming edge but at most one, the value is
+// available from a store to the same pointer. The load is hoisted into the
+// remaining predecessor, which must branch only to LI's block, and LI is
+// replaced by a phi of the values. This runs after elimination, before the
+// instructions marked for deletion are erased, so MemorySSA still describes
+// the function. The new loads are not added to it, which is fine because they
+// do not clobber anything.
+bool NewGVN::performLoadPRE(LoadInst *LI) {
+  if (!LI->isSimple() || LI->use_empty())
+    return false;
+  BasicBlock *BB = LI->getParent();
+  auto *MemPhi = MSSA->getMemoryAccess(BB);
+  if (!MemPhi || MSSAWalker->getClobberingMemoryAccess(LI) != MemPhi)
+    return false;
+
+  // The pointer must have the same value on every incoming edge.
+  Value *Ptr = LI->getPointerOperand();
+  if (auto *PtrInst = dyn_cast<Instruction>(Ptr))
+    if (!DT->properlyDominates(PtrInst->getParent(), BB))
+      return false;
+
+  // The load must be executed whenever BB is entered, so that loading in a
+  // predecessor does not introduce a load on some path.
+  for (Instruction &I : *BB) {
+    if (&I == LI)
+      break;
+    if (!isGuaranteedToTransferExecutionToSuccessor(&I))
+      return false;
+  }
+
+  const MemoryLocation Loc = MemoryLocation::get(LI);
+  SmallVector<std::pair<BasicBlock *, Value *>, 8> Available;
+  BasicBlock *UnavailablePred = nullptr;
+  SmallPtrSet<BasicBlock *, 8> Preds;
+  for (BasicBlock *Pred : predecessors(BB)) {
+    if (!Preds.insert(Pred).second || !ReachableBlocks.count(Pred))
+      return false;
+    MemoryAccess *Clobber = MSSAWalker->getClobberingMemoryAccess(
+        MemPhi->getIncomingValueForBlock(Pred), Loc);
+    auto *Def = dyn_cast<MemoryDef>(Clobber);
+    auto *SI = Def ? dyn_cast_or_null<StoreInst>(Def->getMemoryInst())
+                   : nullptr;
+    if (SI && SI->isSimple() && SI->getPointerOperand() == Ptr &&
+        SI->getValueOperand()->getType() == LI->getType() &&
+        DT->dominates(SI, Pred->getTerminator())) {
+      Available.push_back({Pred, SI->getValueOperand()});
+      continue;
+    }
+    // Only one predecessor may need a new load, and it must not be a critical
+    // edge.
+    if (UnavailablePred || Pred->getTerminator()->getNumSuccessors() != 1)
+      return false;
+    UnavailablePred = Pred;
+  }
+
+  if (UnavailablePred) {
+    auto *NewLoad = new LoadInst(Ptr, LI->getName() + ".pre", false,
+                                 LI->getAlignment(),
+                                 UnavailablePred->getTerminator());
+    NewLoad->copyMetadata(
+        *LI, {LLVMContext::MD_tbaa, LLVMContext::MD_alias_scope,
+              LLVMContext::MD_noalias, LLVMContext::MD_range,
+              LLVMContext::MD_nonnull, LLVMContext::MD_invariant_load});
+    NewLoad->setDebugLoc(LI->getDebugLoc());
+    Available.push_back({UnavailablePred, NewLoad});
+  }
+
+  auto *Phi = PHINode::Create(LI->getType(), Available.size(),
+                              LI->getName() + ".pre-phi", &BB->front());
+  for (auto &P : Available)
+    Phi->addIncoming(P.second, P.first);
+  Phi->setDebugLoc(LI->getDebugLoc());
+  LLVM_DEBUG(dbgs() << "Load PRE of " << *LI << " as " << *Phi << "\n");
+  LI->replaceAllUsesWith(Phi);
+  markInstructionForDeletion(LI);
+  ++NumGVNLoadPRE;
+  return true;
+}
+
 bool NewGVN::eliminateInstructions(Function &F) {
   // This is a non-standard eliminator. The normal way to eliminate is
   // to walk the dominator tree in order, keeping track of available
@@ -11,10 +11,14 @@
 //
 //===----------------------------------------------------------------------===//
 #include "llvm/XRay/Trace.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/XRay/BlockIndexer.h"
 #include "llvm/XRay/BlockVerifier.h"
 #include "llvm/XRay/FDRRecordConsumer.h"
@@ -23,7 +27,12 @@
 #include "llvm/XRay/FDRTraceExpander.h"
 #include "llvm/XRay/FileHeaderReader.h"
 #include "llvm/XRay/YAMLXRayRecord.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <queue>
 #include <vector>
 
 using namespace llvm;
@@ -341,6 +350,335 @@ Error loadFDRLog(StringRef Data, bool IsLittleEndian,
   return Error::success();
 }
 
+// The extent of one block of an FDR log, which is decoded again when the
+// records of its thread are needed. BufferBytes is what a
+// FileBasedRecordProducer has left of the current buffer at Begin.
+struct BlockRange {
+  uint32_t Begin;
+  uint32_t End;
+  uint32_t BufferBytes;
+  uint64_t Seconds;
+  uint32_t Nanos;
+};
+
+using BlockRangeIndex =
+    DenseMap<std::pair<uint64_t, int32_t>, std::vector<BlockRange>>;
+
+// Groups the blocks of an FDR log by process+thread like the BlockIndexer
+// does, without keeping their records, and sorts the blocks of each thread
+// like loadFDRLog does, so that they are expanded in the same order.
+Error indexFDRLog(const XRayFileHeader &FileHeader, DataExtractor &DE,
+                  uint32_t OffsetPtr, BlockRangeIndex &Index) {
+  FileBasedRecordProducer P(FileHeader, DE, OffsetPtr);
+  BlockRange Current{OffsetPtr, OffsetPtr, 0, 0, 0};
+  uint64_t ProcessID = 0;
+  int32_t ThreadID = 0;
+  bool HasRecords = false;
+  auto Flush = [&](uint32_t End) {
+    Current.End = End;
+    Index[{ProcessID, ThreadID}].push_back(Current);
+    Current = {End, End, 0, 0, 0};
+    ProcessID = 0;
+    ThreadID = 0;
+    HasRecords = false;
+  };
+
+  while (DE.isValidOffsetForDataOfSize(OffsetPtr, 1)) {
+    uint32_t Begin = OffsetPtr;
+    uint32_t BufferBytes = P.currentBufferBytes();
+    auto R = P.produce();
+    if (!R)
+      return R.takeError();
+    Record *Rec = R->get();
+    if (isa<BufferExtents>(Rec))
+      continue;
+    if (auto *NB = dyn_cast<NewBufferRecord>(Rec)) {
+      if (HasRecords)
+        Flush(Begin);
+      ThreadID = NB->tid();
+    } else if (auto *PR = dyn_cast<PIDRecord>(Rec)) {
+      ProcessID = PR->pid();
+    } else if (auto *W = dyn_cast<WallclockRecord>(Rec)) {
+      Current.Seconds = W->seconds();
+      Current.Nanos = W->nanos();
+    }
+    if (!HasRecords) {
+      Current.Begin = Begin;
+      Current.BufferBytes = BufferBytes;
+      HasRecords = true;
+    }
+  }
+  Flush(OffsetPtr);
+
+  for (auto &PTB : Index)
+    llvm::sort(PTB.second, [](const BlockRange &L, const BlockRange &R) {
+      return L.Seconds < R.Seconds && L.Nanos < R.Nanos;
+    });
+  return Error::success();
+}
+
+// Verifies and expands the blocks of one thread, one block at a time.
+class ThreadDecoder {
+  const XRayFileHeader &FileHeader;
+  DataExtractor DE;
+  ArrayRef<BlockRange> Blocks;
+  std::vector<XRayRecord> Records;
+  std::function<void(const XRayRecord &)> Adder;
+  TraceExpander Expander;
+  bool Finished = false;
+
+public:
+  ThreadDecoder(const XRayFileHeader &FH, const DataExtractor &DE,
+                ArrayRef<BlockRange> Blocks)
+      : FileHeader(FH), DE(DE), Blocks(Blocks),
+        Adder([this](const XRayRecord &R) { Records.push_back(R); }),
+        Expander(Adder, FH.Version) {}
+
+  ThreadDecoder(const ThreadDecoder &) = delete;
+  ThreadDecoder &operator=(const ThreadDecoder &) = delete;
+
+  /// The records expanded so far, which the caller is expected to clear once
+  /// it is done with them.
+  std::vector<XRayRecord> &records() { return Records; }
+
+  /// Whether all the blocks have been expanded and the expander flushed.
+  bool finished() const { return Finished; }
+
+  /// Expands the next block, or flushes the expander after the last one.
+  Error decodeNext() {
+    if (Blocks.empty()) {
+      Finished = true;
+      return Expander.flush();
+    }
+    const BlockRange &B = Blocks.front();
+    Blocks = Blocks.drop_front();
+
+    uint32_t OffsetPtr = B.Begin;
+    FileBasedRecordProducer P(FileHeader, DE, OffsetPtr, B.BufferBytes);
+    std::vector<std::unique_ptr<Record>> BlockRecords;
+    BlockVerifier Verifier;
+    while (OffsetPtr < B.End) {
+      auto R = P.produce();
+      if (!R)
+        return R.takeError();
+      if (isa<BufferExtents>(R->get()))
+        continue;
+      if (auto E = (*R)->apply(Verifier))
+        return E;
+      BlockRecords.push_back(std::move(R.get()));
+    }
+    if (auto E = Verifier.verify())
+      return E;
+
+    for (auto &R : BlockRecords)
+      if (auto E = R->apply(Expander))
+        return E;
+    return Error::success();
+  }
+};
+
+// Passes the records of all threads to Callback in TSC order. The records of
+// one thread keep their order, and on equal TSCs earlier threads go first.
+Error mergeThreadsByTSC(const XRayFileHeader &FileHeader,
+                        const DataExtractor &DE,
+                        ArrayRef<ArrayRef<BlockRange>> Threads,
+                        function_ref<Error(const XRayRecord &)> Callback) {
+  struct Cursor {
+    std::unique_ptr<ThreadDecoder> Decoder;
+    size_t Next;
+  };
+  // Expands blocks until the cursor has a record or its thread is done.
+  auto Refill = [](Cursor &C) -> Error {
+    std::vector<XRayRecord> &Records = C.Decoder->records();
+    while (C.Next == Records.size() && !C.Decoder->finished()) {
+      Records.clear();
+      C.Next = 0;
+      if (auto E = C.Decoder->decodeNext())
+        return E;
+    }
+    return Error::success();
+  };
+
+  using QueueEntry = std::pair<uint64_t, size_t>;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      Queue;
+  std::vector<Cursor> Cursors;
+  Cursors.reserve(Threads.size());
+  for (ArrayRef<BlockRange> Blocks : Threads) {
+    Cursors.push_back({llvm::make_unique<ThreadDecoder>(FileHeader, DE, Blocks),
+                       0});
+    Cursor &C = Cursors.back();
+    if (auto E = Refill(C))
+      return E;
+    if (C.Next < C.Decoder->records().size())
+      Queue.push({C.Decoder->records()[C.Next].TSC, Cursors.size() - 1});
+  }
+
+  while (!Queue.empty()) {
+    size_t I = Queue.top().second;
+    Queue.pop();
+    Cursor &C = Cursors[I];
+    if (auto E = Callback(C.Decoder->records()[C.Next++]))
+      return E;
+    if (auto E = Refill(C))
+      return E;
+    if (C.Next < C.Decoder->records().size())
+      Queue.push({C.Decoder->records()[C.Next].TSC, I});
+  }
+  return Error::success();
+}
+
+#if LLVM_ENABLE_THREADS
+// Decodes the threads on NumThreads threads, a few batches of records ahead
+// of Callback, which gets the records of one thread after the other on the
+// calling thread.
+Error decodeThreadsAhead(const XRayFileHeader &FileHeader,
+                         const DataExtractor &DE,
+                         ArrayRef<ArrayRef<BlockRange>> Threads,
+                         function_ref<Error(const XRayRecord &)> Callback,
+                         unsigned NumThreads) {
+  // The number of records a decoder collects before handing them over, and
+  // the number of those batches a thread may have waiting for Callback.
+  const size_t BatchSize = 4096;
+  const size_t MaxPendingBatches = 4;
+
+  struct ThreadRecords {
+    std::deque<std::vector<XRayRecord>> Batches;
+    bool Done = false;
+    Error Err = Error::success();
+  };
+  std::vector<ThreadRecords> Pending(Threads.size());
+  std::mutex Mutex;
+  std::condition_variable Changed;
+  bool Cancelled = false;
+
+  // The pool starts the threads in order, so the one Callback is waiting for
+  // is always being decoded, while the others block once they are far enough
+  // ahead.
+  auto Decode = [&](size_t I) {
+    ThreadDecoder D(FileHeader, DE, Threads[I]);
+    ThreadRecords &Out = Pending[I];
+    while (true) {
+      Error E = D.decodeNext();
+      bool Done = E || D.finished();
+      if (!Done && D.records().size() < BatchSize)
+        continue;
+
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Changed.wait(Lock, [&] {
+        return Cancelled || Out.Batches.size() < MaxPendingBatches;
+      });
+      if (Cancelled) {
+        consumeError(std::move(E));
+        return;
+      }
+      if (!D.records().empty()) {
+        Out.Batches.push_back(std::move(D.records()));
+        D.records().clear();
+      }
+      if (Done) {
+        Out.Done = true;
+        cantFail(std::move(Out.Err));
+        Out.Err = std::move(E);
+      }
+      Lock.unlock();
+      Changed.notify_all();
+      if (Done)
+        return;
+    }
+  };
+
+  ThreadPool Pool(NumThreads);
+  for (size_t I = 0; I < Threads.size(); ++I)
+    Pool.async(Decode, I);
+
+  auto Consume = [&]() -> Error {
+    for (ThreadRecords &Out : Pending) {
+      while (true) {
+        std::vector<XRayRecord> Batch;
+        {
+          std::unique_lock<std::mutex> Lock(Mutex);
+          Changed.wait(Lock, [&] { return !Out.Batches.empty() || Out.Done; });
+          if (Out.Batches.empty()) {
+            if (Out.Err)
+              return std::move(Out.Err);
+            break;
+          }
+          Batch = std::move(Out.Batches.front());
+          Out.Batches.pop_front();
+        }
+        Changed.notify_all();
+        for (const XRayRecord &R : Batch)
+          if (auto E = Callback(R))
+            return E;
+      }
+    }
+    return Error::success();
+  };
+  Error Err = Consume();
+
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Cancelled = true;
+  }
+  Changed.notify_all();
+  Pool.wait();
+  for (ThreadRecords &Out : Pending)
+    consumeError(std::move(Out.Err));
+  return Err;
+}
+#endif
+
+Error streamFDRLog(const DataExtractor &Extractor, XRayFileHeader &FileHeader,
+                   function_ref<Error(const XRayRecord &)> Callback, bool Sort,
+                   unsigned NumThreads) {
+  StringRef Data = Extractor.getData();
+  if (Data.size() < 32)
+    return createStringError(std::make_error_code(std::errc::invalid_argument),
+                             "Not enough bytes for an XRay FDR log.");
+  DataExtractor DE(Data, Extractor.isLittleEndian(), 8);
+
+  uint32_t OffsetPtr = 0;
+  auto FileHeaderOrError = readBinaryFormatHeader(DE, OffsetPtr);
+  if (!FileHeaderOrError)
+    return FileHeaderOrError.takeError();
+  FileHeader = std::move(FileHeaderOrError.get());
+
+  BlockRangeIndex Index;
+  if (auto E = indexFDRLog(FileHeader, DE, OffsetPtr, Index))
+    return E;
+  std::vector<ArrayRef<BlockRange>> Threads;
+  for (auto &PTB : Index)
+    Threads.push_back(PTB.second);
+
+  if (Sort)
+    return mergeThreadsByTSC(FileHeader, DE, Threads, Callback);
+
+#if LLVM_ENABLE_THREADS
+  if (NumThreads == 0)
+    NumThreads = hardware_concurrency();
+  NumThreads = std::min<size_t>(NumThreads, Threads.size());
+  if (NumThreads > 1)
+    return decodeThreadsAhead(FileHeader, DE, Threads, Callback, NumThreads);
+#else
+  (void)NumThreads;
+#endif
+
+  for (ArrayRef<BlockRange> Blocks : Threads) {
+    ThreadDecoder D(FileHeader, DE, Blocks);
+    while (!D.finished()) {
+      if (auto E = D.decodeNext())
+        return E;
+      for (const XRayRecord &R : D.records())
+        if (auto E = Callback(R))
+          return E;
+      D.records().clear();
+    }
+  }
+  return Error::success();
+}
+
 Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
                   std::vector<XRayRecord> &Records) {
   YAMLXRayTrace Trace;
@@ -369,9 +707,10 @@ Error loadYAMLLog(StringRef Data, XRayFileHeader &FileHeader,
                  });
   return Error::success();
 }
-} // namespace
-
-Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+// Maps the opened file into memory, so that a StringRef can be used to access
+// it later.
+Expected<std::unique_ptr<sys::fs::mapped_file_region>>
+mapTraceFile(StringRef Filename) {
   int Fd;
   if (auto EC = sys::fs::openFileForRead(Filename, Fd)) {
     return make_error<StringError>(
@@ -389,15 +728,31 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
         std::make_error_code(std::errc::executable_format_error));
   }
 
-  // Map the opened file into memory and use a StringRef to access it later.
   std::error_code EC;
-  sys::fs::mapped_file_region MappedFile(
+  auto MappedFile = llvm::make_unique<sys::fs::mapped_file_region>(
       Fd, sys::fs::mapped_file_region::mapmode::readonly, FileSize, 0, EC);
   if (EC) {
     return make_error<StringError>(
         Twine("Cannot read log from '") + Filename + "'", EC);
   }
-  auto Data = StringRef(MappedFile.data(), MappedFile.size());
+  return std::move(MappedFile);
+}
+
+bool isFDRLog(const DataExtractor &DE) {
+  DataExtractor HeaderExtractor(DE.getData(), DE.isLittleEndian(), 8);
+  uint32_t OffsetPtr = 0;
+  uint16_t Version = HeaderExtractor.getU16(&OffsetPtr);
+  uint16_t Type = HeaderExtractor.getU16(&OffsetPtr);
+  return Type == 1 && Version >= 1 && Version <= 5;
+}
+} // namespace
+
+Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
+  auto MappedFileOrErr = mapTraceFile(Filename);
+  if (!MappedFileOrErr)
+    return MappedFileOrErr.takeError();
+  auto &MappedFile = *MappedFileOrErr;
+  auto Data = StringRef(MappedFile->data(), MappedFile->size());
 
   // TODO: Lift the endianness and implementation selection here.
   DataExtractor LittleEndianDE(Data, true, 8);
@@ -409,6 +764,56 @@ Expected<Trace> llvm::xray::loadTraceFile(StringRef Filename, bool Sort) {
   return TraceOrError;
 }
 
+Expected<XRayFileHeader>
+llvm::xray::streamTraceFile(StringRef Filename,
+                            function_ref<Error(const XRayRecord &)> Callback,
+                            bool Sort, unsigned NumThreads) {
+  auto MappedFileOrErr = mapTraceFile(Filename);
+  if (!MappedFileOrErr)
+    return MappedFileOrErr.takeError();
+  auto &MappedFile = *MappedFileOrErr;
+  auto Data = StringRef(MappedFile->data(), MappedFile->size());
+
+  // Records may already have been passed to Callback when an error comes up,
+  // so unlike loadTraceFile we pick the endianness from the header up front.
+  DataExtractor LittleEndianDE(Data, true, 8);
+  DataExtractor BigEndianDE(Data, false, 8);
+  if (isFDRLog(LittleEndianDE))
+    return streamTrace(LittleEndianDE, Callback, Sort, NumThreads);
+  if (isFDRLog(BigEndianDE))
+    return streamTrace(BigEndianDE, Callback, Sort, NumThreads);
+
+  auto TraceOrErr = loadTrace(LittleEndianDE, Sort);
+  if (!TraceOrErr)
+    TraceOrErr = loadTrace(BigEndianDE, Sort);
+  if (!TraceOrErr)
+    return TraceOrErr.takeError();
+  for (const XRayRecord &R : *TraceOrErr)
+    if (auto E = Callback(R))
+      return std::move(E);
+  return TraceOrErr->getFileHeader();
+}
+
+Expected<XRayFileHeader>
+llvm::xray::streamTrace(const DataExtractor &DE,
+                        function_ref<Error(const XRayRecord &)> Callback,
+                        bool Sort, unsigned NumThreads) {
+  if (isFDRLog(DE)) {
+    XRayFileHeader FileHeader;
+    if (auto E = streamFDRLog(DE, FileHeader, Callback, Sort, NumThreads))
+      return std::move(E);
+    return FileHeader;
+  }
+
+  auto TraceOrErr = loadTrace(DE, Sort);
+  if (!TraceOrErr)
+    return TraceOrErr.takeError();
+  for (const XRayRecord &R : *TraceOrErr)
+    if (auto E = Callback(R))
+      return std::move(E);
+  return TraceOrErr->getFileHeader();
+}
+
 Expected<Trace> llvm::xray::loadTrace(const DataExtractor &DE, bool Sort) {
   // Attempt to detect the file type using file magic. We have a slight bias
   // towards the binary format, and we do this by making sure that the first 4
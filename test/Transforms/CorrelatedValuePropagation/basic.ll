@@ -1,5 +1,6 @@
 ; NOTE: Assertions have been autogenerated by utils/update_test_checks.py
 ; RUN: opt < %s -correlated-propagation -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-cache-max-entries=1 -S | FileCheck %s
 ; PR2581
 
 define i32 @test1(i1 %C) {
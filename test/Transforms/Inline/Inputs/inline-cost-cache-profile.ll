@@ -0,0 +1,72 @@
+; @g is hot and forms one SCC with its callers @x and @y. Every call to @g
+; that is inlined lowers its entry count and rescales the weights of the calls
+; in its body, so the costs of the remaining calls to and from @g change.
+
+define void @g(i32 %n) !prof !20 {
+entry:
+  %a = add i32 %n, 1
+  %b = add i32 %a, 1
+  %c = add i32 %b, 1
+  call void @extern(i32 %c)
+  %cmp = icmp eq i32 %n, 0
+  br i1 %cmp, label %rec, label %exit, !prof !30
+
+rec:
+  call void @x(i32 %c)
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @x(i32 %n) !prof !21 {
+entry:
+  call void @g(i32 %n)
+  %cmp = icmp eq i32 %n, 1
+  br i1 %cmp, label %again, label %exit, !prof !31
+
+again:
+  call void @g(i32 0)
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @y(i32 %n) !prof !22 {
+entry:
+  call void @g(i32 %n)
+  %cmp = icmp eq i32 %n, 2
+  br i1 %cmp, label %rec, label %exit, !prof !31
+
+rec:
+  call void @x(i32 %n)
+  br label %exit
+
+exit:
+  ret void
+}
+
+declare void @extern(i32)
+
+!llvm.module.flags = !{!1}
+!20 = !{!"function_entry_count", i64 300}
+!21 = !{!"function_entry_count", i64 200}
+!22 = !{!"function_entry_count", i64 100}
+!30 = !{!"branch_weights", i32 1, i32 299}
+!31 = !{!"branch_weights", i32 150, i32 50}
+
+!1 = !{i32 1, !"ProfileSummary", !2}
+!2 = !{!3, !4, !5, !6, !7, !8, !9, !10}
+!3 = !{!"ProfileFormat", !"InstrProf"}
+!4 = !{!"TotalCount", i64 10000}
+!5 = !{!"MaxCount", i64 1000}
+!6 = !{!"MaxInternalCount", i64 1}
+!7 = !{!"MaxFunctionCount", i64 1000}
+!8 = !{!"NumCounts", i64 3}
+!9 = !{!"NumFunctions", i64 3}
+!10 = !{!"DetailedSummary", !11}
+!11 = !{!12, !13, !14}
+!12 = !{i32 10000, i64 100, i32 1}
+!13 = !{i32 999000, i64 100, i32 1}
+!14 = !{i32 999999, i64 1, i32 2}
@@ -0,0 +1,84 @@
+; RUN: opt < %s -inline -inline-threshold=0 -S | FileCheck %s
+; RUN: opt < %s -inline -inline-threshold=0 -inline-cost-cache=false -S \
+; RUN:   | FileCheck %s
+; RUN: opt < %s -passes='cgscc(inline)' -inline-threshold=0 -S | FileCheck %s
+; RUN: opt < %s -passes='cgscc(inline)' -inline-threshold=0 \
+; RUN:   -inline-cost-cache=false -S | FileCheck %s
+
+; With a profile, inlining changes the callee too. The decisions must not
+; depend on the cache.
+; RUN: opt < %S/Inputs/inline-cost-cache-profile.ll -inline \
+; RUN:   -inline-threshold=0 -inlinehint-threshold=100 -S > %t.on
+; RUN: opt < %S/Inputs/inline-cost-cache-profile.ll -inline \
+; RUN:   -inline-threshold=0 -inlinehint-threshold=100 \
+; RUN:   -inline-cost-cache=false -S > %t.off
+; RUN: diff %t.on %t.off
+; RUN: opt < %S/Inputs/inline-cost-cache-profile.ll -passes='cgscc(inline)' \
+; RUN:   -inline-threshold=0 -inlinehint-threshold=100 -S > %t.npm.on
+; RUN: opt < %S/Inputs/inline-cost-cache-profile.ll -passes='cgscc(inline)' \
+; RUN:   -inline-threshold=0 -inlinehint-threshold=100 \
+; RUN:   -inline-cost-cache=false -S > %t.npm.off
+; RUN: diff %t.npm.on %t.npm.off
+
+; @x and @y form one SCC. The call in @x is too expensive to inline while @f
+; has two callers. Once the cheap call in @y is inlined, @x holds the last
+; call to @f and gets the last call bonus. The cached cost of the call in @x
+; must not hide that change even though neither @x nor @f was modified.
+
+define internal void @f(i1 %b) {
+entry:
+  %p = alloca i32
+  br i1 %b, label %then, label %exit
+
+then:
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  store volatile i32 0, i32* %p
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @x(i1 %c) noinline {
+; CHECK-LABEL: define void @x(
+; CHECK-NOT:     call void @f(
+; CHECK:         call void @y(
+; CHECK-NOT:     call void @f(
+; CHECK:         ret void
+entry:
+  call void @f(i1 true)
+  br i1 %c, label %rec, label %exit
+
+rec:
+  call void @y(i1 false)
+  br label %exit
+
+exit:
+  ret void
+}
+
+define void @y(i1 %c) noinline {
+; CHECK-LABEL: define void @y(
+; CHECK-NOT:     call void @f(
+; CHECK:         call void @x(
+; CHECK-NOT:     call void @f(
+; CHECK:         ret void
+entry:
+  call void @f(i1 false)
+  br i1 %c, label %rec, label %exit
+
+rec:
+  call void @x(i1 false)
+  br label %exit
+
+exit:
+  ret void
+}
+
+; CHECK-NOT: define internal void @f(
@@ -0,0 +1,67 @@
+; RUN: opt < %s -instcombine -S | FileCheck %s
+; RUN: opt < %s -instcombine -instcombine-incremental-worklist -S | FileCheck %s
+; RUN: opt < %s -instcombine -instcombine-max-visits=1 -S \
+; RUN:   | FileCheck %s --check-prefix=BUDGET
+; RUN: opt < %s -instcombine -pass-remarks-analysis=instcombine \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=REMARK
+; RUN: opt < %s -instcombine -instcombine-max-visits=1 \
+; RUN:   -pass-remarks-analysis=instcombine -disable-output 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=BUDGET-REMARK
+; RUN: opt < %s -instcombine -pass-remarks-analysis=instcombine \
+; RUN:   -disable-output 2>&1 | FileCheck %s --check-prefix=FULL-REMARK
+; RUN: opt < %s -instcombine -instcombine-incremental-worklist \
+; RUN:   -pass-remarks-analysis=instcombine -disable-output 2>&1 \
+; RUN:   | FileCheck %s --check-prefix=INCREMENTAL-REMARK
+
+; The per-function visit budget stops instcombine before it reaches a
+; fixpoint, and the summary remark reports the work that was done.
+
+define i32 @f(i32 %x) {
+; CHECK-LABEL: @f(
+; CHECK-NEXT:    ret i32 %x
+;
+; BUDGET-LABEL: @f(
+; BUDGET-NEXT:    %a = add i32 %x, 1
+; BUDGET-NEXT:    %b = add i32 %a, 1
+; BUDGET-NEXT:    %c = sub i32 %b, 2
+; BUDGET-NEXT:    ret i32 %c
+;
+  %a = add i32 %x, 1
+  %b = add i32 %a, 1
+  %c = sub i32 %b, 2
+  ret i32 %c
+}
+
+; REMARK: remark: {{.*}}ran {{[0-9]+}} iterations and {{[0-9]+}} visits; visits per iteration: {{[0-9, ]+}}; add: {{[0-9]+}}
+; REMARK-NOT: budget exhausted
+
+; BUDGET-REMARK: remark: {{.*}}ran 1 iterations and 1 visits (visit budget exhausted)
+
+; Only %a changes in the first iteration. Seeding the second iteration with
+; the whole function visits every remaining instruction again, while the
+; incremental worklist only revisits %c0, the user of %a.
+
+declare i32 @h(i32)
+
+define i32 @g(i32 %x, i32 %y) {
+; CHECK-LABEL: @g(
+; CHECK-NEXT:    [[C0:%.*]] = call i32 @h(i32 %x)
+;
+  %a = add i32 %x, 0
+  %c0 = call i32 @h(i32 %a)
+  %c1 = call i32 @h(i32 %y)
+  %c2 = call i32 @h(i32 %y)
+  %c3 = call i32 @h(i32 %y)
+  %c4 = call i32 @h(i32 %y)
+  %c5 = call i32 @h(i32 %y)
+  %c6 = call i32 @h(i32 %y)
+  %c7 = call i32 @h(i32 %y)
+  %c8 = call i32 @h(i32 %y)
+  ret i32 %c0
+}
+
+; The first remark is for @f.
+; FULL-REMARK: remark: {{.*}}ran {{[0-9]+}} iterations
+; FULL-REMARK-NEXT: remark: {{.*}}ran 2 iterations and {{[0-9]+}} visits; visits per iteration: {{[0-9]+}}, 10{{$|;}}
+; INCREMENTAL-REMARK: remark: {{.*}}ran {{[0-9]+}} iterations
+; INCREMENTAL-REMARK-NEXT: remark: {{.*}}ran 2 iterations and {{[0-9]+}} visits; visits per iteration: {{[0-9]+}}, 1{{$|;}}
@@ -0,0 +1,109 @@
+; RUN: opt < %s -basicaa -newgvn -newgvn-load-pre -S | FileCheck %s
+; RUN: opt < %s -basicaa -newgvn -S | FileCheck %s --check-prefix=NOPRE
+
+; The load in %merge is available from the store in %then but not along the
+; edge from %else, so it is loaded at the end of %else instead.
+define i32 @partial(i32* %p, i1 %c) {
+; CHECK-LABEL: @partial(
+; CHECK:       else:
+; CHECK-NEXT:    [[V_PRE:%.*]] = load i32, i32* %p, align 4
+; CHECK-NEXT:    br label %merge
+; CHECK:       merge:
+; CHECK-NEXT:    [[PHI:%.*]] = phi i32 [ 7, %then ], [ [[V_PRE]], %else ]
+; CHECK-NEXT:    ret i32 [[PHI]]
+;
+; NOPRE-LABEL: @partial(
+; NOPRE:       merge:
+; NOPRE-NEXT:    [[V:%.*]] = load i32, i32* %p, align 4
+; NOPRE-NEXT:    ret i32 [[V]]
+;
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 7, i32* %p, align 4
+  br label %merge
+
+else:
+  br label %merge
+
+merge:
+  %v = load i32, i32* %p, align 4
+  ret i32 %v
+}
+
+; The value is available on both edges, so no load is needed at all.
+define i32 @full(i32* %p, i1 %c, i32 %a, i32 %b) {
+; CHECK-LABEL: @full(
+; CHECK:       merge:
+; CHECK-NEXT:    [[PHI:%.*]] = phi i32 {{\[ %a, %then \], \[ %b, %else \]|\[ %b, %else \], \[ %a, %then \]}}
+; CHECK-NEXT:    ret i32 [[PHI]]
+;
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 %a, i32* %p, align 4
+  br label %merge
+
+else:
+  store i32 %b, i32* %p, align 4
+  br label %merge
+
+merge:
+  %v = load i32, i32* %p, align 4
+  ret i32 %v
+}
+
+; %entry also branches to %exit, so loading at its end would add a load on
+; the path to %exit.
+define i32 @critical_edge(i32* %p, i1 %c, i1 %d) {
+; CHECK-LABEL: @critical_edge(
+; CHECK-NOT:     .pre
+; CHECK:       merge:
+; CHECK-NEXT:    [[V:%.*]] = load i32, i32* %p, align 4
+;
+entry:
+  br i1 %c, label %then, label %next
+
+next:
+  br i1 %d, label %merge, label %exit
+
+then:
+  store i32 7, i32* %p, align 4
+  br label %merge
+
+merge:
+  %v = load i32, i32* %p, align 4
+  ret i32 %v
+
+exit:
+  ret i32 0
+}
+
+declare void @may_throw() readnone
+
+; The call before the load may throw, so the load is not anticipated at
+; the end of %else.
+define i32 @not_anticipated(i32* %p, i1 %c) {
+; CHECK-LABEL: @not_anticipated(
+; CHECK-NOT:     .pre
+; CHECK:       merge:
+; CHECK-NEXT:    call void @may_throw()
+; CHECK-NEXT:    [[V:%.*]] = load i32, i32* %p, align 4
+;
+entry:
+  br i1 %c, label %then, label %else
+
+then:
+  store i32 7, i32* %p, align 4
+  br label %merge
+
+else:
+  br label %merge
+
+merge:
+  call void @may_throw()
+  %v = load i32, i32* %p, align 4
+  ret i32 %v
+}
@@ -0,0 +1,38 @@
+; RUN: opt < %s -newgvn -S | FileCheck %s
+; RUN: opt < %s -newgvn -newgvn-max-iterations=1 -S \
+; RUN:   | FileCheck %s --check-prefix=LIMIT
+; RUN: opt < %s -passes=newgvn -newgvn-max-iterations=1 -S \
+; RUN:   | FileCheck %s --check-prefix=LIMIT
+
+; Proving %a and %b congruent needs a second iteration over the loop. When
+; the iteration limit stops NewGVN before the fixpoint, the function must be
+; left exactly as it was, without PredicateInfo's ssa.copy calls.
+
+define i32 @f(i32 %n) {
+; CHECK-LABEL: @f(
+; CHECK-NOT:     %b =
+; CHECK:         ret i32 0
+;
+; LIMIT-LABEL: @f(
+; LIMIT:         %b = phi i32
+; LIMIT-NOT:     ssa.copy
+; LIMIT:         %r = sub i32 %a.next, %b.next
+; LIMIT-NEXT:    ret i32 %r
+;
+entry:
+  br label %loop
+
+loop:
+  %a = phi i32 [ 0, %entry ], [ %a.next, %loop ]
+  %b = phi i32 [ 0, %entry ], [ %b.next, %loop ]
+  %a.next = add i32 %a, 1
+  %b.next = add i32 %b, 1
+  %cmp = icmp slt i32 %a.next, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  %r = sub i32 %a.next, %b.next
+  ret i32 %r
+}
+
+; LIMIT-NOT: declare {{.*}}@llvm.ssa.copy
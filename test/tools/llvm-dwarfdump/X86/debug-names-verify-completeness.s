@@ -10,6 +10,7 @@
 # CHECK: error: Name Index @ 0x0: Entry for DIE @ 0x3e (DW_TAG_subprogram) with name _Z8fun_name missing.
 # CHECK: error: Name Index @ 0x0: Entry for DIE @ 0x4f (DW_TAG_inlined_subroutine) with name fun_inline missing.
 # CHECK: error: Name Index @ 0x0: Entry for DIE @ 0x64 (DW_TAG_label) with name label missing.
+# CHECK: error: Name Index @ 0x0: Entry for DIE @ 0x72 (DW_TAG_subprogram) with name _Z9link_only missing.
 
 	.section	.debug_str,"MS",@progbits,1
 .Linfo_producer:
@@ -32,6 +33,8 @@
 	.asciz	"namesp"
 .Lname_label:
 	.asciz	"label"
+.Lname_link_only:
+	.asciz	"_Z9link_only"
 
 	.section	.debug_loc,"",@progbits
 .Ldebug_loc0:
@@ -122,6 +125,16 @@
 	.byte	0                       # EOM(1)
 	.byte	0                       # EOM(2)
 
+	.byte	9                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	110                     # DW_AT_linkage_name
+	.byte	14                      # DW_FORM_strp
+	.byte	82                      # DW_AT_entry_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+
 	.byte	0                       # EOM(3)
 	.section	.debug_info,"",@progbits
 .Lcu_begin0:
@@ -171,6 +184,10 @@
 	.quad	0x4a                    # DW_AT_entry_pc
 	.byte	0                       # End Of Children Mark
 
+	.byte	9                       # Abbrev [9] DW_TAG_subprogram
+	.long	.Lname_link_only        # DW_AT_linkage_name
+	.quad	0x4b                    # DW_AT_entry_pc
+
 	.byte	0                       # End Of Children Mark
 .Lcu_end0:
 
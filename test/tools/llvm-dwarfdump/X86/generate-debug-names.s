@@ -0,0 +1,200 @@
+# RUN: llvm-mc -triple x86_64-pc-linux %s -filetype=obj -o %t
+# RUN: llvm-dwarfdump -generate-debug-names -o %t.names %t 2>&1 \
+# RUN:   | FileCheck --allow-empty --check-prefix=NOWARN %s
+# RUN: llvm-dwarfdump -generate-debug-names -num-threads=2 -o %t.names2 %t
+# RUN: cmp %t.names %t.names2
+# RUN: llvm-objcopy --add-section .debug_names=%t.names %t %t.indexed
+# RUN: llvm-dwarfdump -verify %t.indexed | FileCheck --check-prefix=VERIFY %s
+# RUN: llvm-dwarfdump -debug-names %t.indexed | FileCheck --check-prefix=NAMES %s
+
+# Without an index, -find searches the units for the same DIEs.
+# RUN: llvm-dwarfdump -find=foo %t | FileCheck --check-prefix=FOO %s
+# RUN: llvm-dwarfdump -find=foo %t.indexed | FileCheck --check-prefix=FOO %s
+# RUN: llvm-dwarfdump -find=decl %t.indexed | FileCheck --check-prefix=DECL %s
+
+# Names that are not in .debug_str can't be indexed.
+# RUN: llvm-mc -triple x86_64-pc-linux %s -filetype=obj --defsym STRING=1 \
+# RUN:   -o %t.string
+# RUN: llvm-dwarfdump -generate-debug-names -o %t.names3 %t.string 2>&1 \
+# RUN:   | FileCheck --check-prefix=WARN %s
+
+# NOWARN-NOT: warning
+
+# VERIFY: No errors.
+
+# NAMES: Name Index @ 0x0 {
+# NAMES-NEXT: Header {
+# NAMES-NEXT:   Length:
+# NAMES-NEXT:   Version: 5
+# NAMES-NEXT:   Padding: 0x0
+# NAMES-NEXT:   CU count: 2
+# NAMES-NEXT:   Local TU count: 0
+# NAMES-NEXT:   Foreign TU count: 0
+# NAMES-NEXT:   Bucket count: 4
+# NAMES-NEXT:   Name count: 4
+# NAMES:      String: {{.*}} "foo"
+# NAMES-NEXT: Entry @ {{.*}} {
+# NAMES-NEXT:   Abbrev:
+# NAMES-NEXT:   Tag: DW_TAG_subprogram
+# NAMES-NEXT:   DW_IDX_compile_unit: 0x00
+# NAMES-NEXT:   DW_IDX_die_offset:
+# NAMES-NEXT: }
+# NAMES-NEXT: Entry @ {{.*}} {
+# NAMES-NEXT:   Abbrev:
+# NAMES-NEXT:   Tag: DW_TAG_subprogram
+# NAMES-NEXT:   DW_IDX_compile_unit: 0x01
+# NAMES-NEXT:   DW_IDX_die_offset:
+# NAMES-NEXT: }
+# NAMES-NOT: "decl"
+
+# FOO: DW_TAG_subprogram
+# FOO-NEXT: DW_AT_name ("foo")
+# FOO: DW_TAG_subprogram
+# FOO-NEXT: DW_AT_name ("foo")
+
+# DECL-NOT: DW_TAG
+
+# WARN: warning: {{.*}}: 1 name(s) not in .debug_str were left out of the index
+
+	.text
+foo:
+	retq
+.Lfoo_end:
+bar:
+	retq
+.Lbar_end:
+
+	.data
+var:
+	.long	0
+
+	.section	.debug_str,"MS",@progbits,1
+.Lstring_producer:
+	.asciz	"Hand-written dwarf"
+.Lstring_foo:
+	.asciz	"foo"
+.Lstring_var:
+	.asciz	"var"
+.Lstring_decl:
+	.asciz	"decl"
+.Lstring_S:
+	.asciz	"S"
+	.asciz	"(anonymous namespace)"
+
+	.section	.debug_abbrev,"",@progbits
+.Lsection_abbrev:
+	.byte	1                       # Abbreviation Code
+	.byte	17                      # DW_TAG_compile_unit
+	.byte	1                       # DW_CHILDREN_yes
+	.byte	37                      # DW_AT_producer
+	.byte	14                      # DW_FORM_strp
+	.byte	19                      # DW_AT_language
+	.byte	5                       # DW_FORM_data2
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	2                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	14                      # DW_FORM_strp
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	6                       # DW_FORM_data4
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	3                       # Abbreviation Code
+	.byte	52                      # DW_TAG_variable
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	14                      # DW_FORM_strp
+	.byte	2                       # DW_AT_location
+	.byte	24                      # DW_FORM_exprloc
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	4                       # Abbreviation Code
+	.byte	57                      # DW_TAG_namespace
+	.byte	0                       # DW_CHILDREN_no
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	5                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	14                      # DW_FORM_strp
+	.byte	60                      # DW_AT_declaration
+	.byte	25                      # DW_FORM_flag_present
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	6                       # Abbreviation Code
+	.byte	19                      # DW_TAG_structure_type
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	14                      # DW_FORM_strp
+	.byte	11                      # DW_AT_byte_size
+	.byte	11                      # DW_FORM_data1
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	7                       # Abbreviation Code
+	.byte	46                      # DW_TAG_subprogram
+	.byte	0                       # DW_CHILDREN_no
+	.byte	3                       # DW_AT_name
+	.byte	8                       # DW_FORM_string
+	.byte	17                      # DW_AT_low_pc
+	.byte	1                       # DW_FORM_addr
+	.byte	18                      # DW_AT_high_pc
+	.byte	6                       # DW_FORM_data4
+	.byte	0                       # EOM(1)
+	.byte	0                       # EOM(2)
+	.byte	0                       # EOM(3)
+
+	.section	.debug_info,"",@progbits
+.Lcu_begin0:
+	.long	.Lcu_end0-.Lcu_start0   # Length of Unit
+.Lcu_start0:
+	.short	4                       # DWARF version number
+	.long	.Lsection_abbrev        # Offset Into Abbrev. Section
+	.byte	8                       # Address Size (in bytes)
+	.byte	1                       # Abbrev [1] DW_TAG_compile_unit
+	.long	.Lstring_producer       # DW_AT_producer
+	.short	12                      # DW_AT_language
+	.byte	2                       # Abbrev [2] DW_TAG_subprogram
+	.long	.Lstring_foo            # DW_AT_name
+	.quad	foo                     # DW_AT_low_pc
+	.long	.Lfoo_end-foo           # DW_AT_high_pc
+	.byte	3                       # Abbrev [3] DW_TAG_variable
+	.long	.Lstring_var            # DW_AT_name
+	.byte	9                       # DW_AT_location
+	.byte	3                       # DW_OP_addr
+	.quad	var
+	.byte	4                       # Abbrev [4] DW_TAG_namespace
+	.byte	5                       # Abbrev [5] DW_TAG_subprogram
+	.long	.Lstring_decl           # DW_AT_name
+                                        # DW_AT_declaration
+.ifdef STRING
+	.byte	7                       # Abbrev [7] DW_TAG_subprogram
+	.asciz	"bar"                   # DW_AT_name
+	.quad	bar                     # DW_AT_low_pc
+	.long	.Lbar_end-bar           # DW_AT_high_pc
+.endif
+	.byte	0                       # End Of Children Mark
+.Lcu_end0:
+
+.Lcu_begin1:
+	.long	.Lcu_end1-.Lcu_start1   # Length of Unit
+.Lcu_start1:
+	.short	4                       # DWARF version number
+	.long	.Lsection_abbrev        # Offset Into Abbrev. Section
+	.byte	8                       # Address Size (in bytes)
+	.byte	1                       # Abbrev [1] DW_TAG_compile_unit
+	.long	.Lstring_producer       # DW_AT_producer
+	.short	12                      # DW_AT_language
+	.byte	2                       # Abbrev [2] DW_TAG_subprogram
+	.long	.Lstring_foo            # DW_AT_name
+	.quad	foo                     # DW_AT_low_pc
+	.long	.Lfoo_end-foo           # DW_AT_high_pc
+	.byte	6                       # Abbrev [6] DW_TAG_structure_type
+	.long	.Lstring_S              # DW_AT_name
+	.byte	4                       # DW_AT_byte_size
+	.byte	0                       # End Of Children Mark
+.Lcu_end1:
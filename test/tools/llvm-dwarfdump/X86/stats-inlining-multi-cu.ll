@@ -1,5 +1,7 @@
 ; RUN: llc -O0 %s -o - -filetype=obj \
 ; RUN:   | llvm-dwarfdump -statistics - | FileCheck %s
+; RUN: llc -O0 %s -o - -filetype=obj \
+; RUN:   | llvm-dwarfdump -statistics -num-threads=2 - | FileCheck %s
 
 ; Test that abstract origins in multiple CUs are uniqued.
 
@@ -1,6 +1,9 @@
 # RUN: llvm-mc %s -filetype obj -triple x86_64-apple-darwin -o - \
 # RUN: | not llvm-dwarfdump -verify - \
 # RUN: | FileCheck %s
+# RUN: llvm-mc %s -filetype obj -triple x86_64-apple-darwin -o - \
+# RUN: | not llvm-dwarfdump -verify -num-threads=2 - \
+# RUN: | FileCheck %s
 
 # CHECK: Verifying .debug_info Unit Header Chain...
 # CHECK-NEXT: error: Invalid address range [0x0000000000000007, 0x0000000000000006)
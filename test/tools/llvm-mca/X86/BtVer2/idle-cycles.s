@@ -0,0 +1,73 @@
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=50 -all-stats -instruction-info=false -resource-pressure=false < %s | FileCheck %s
+
+# Long latency instructions leave the pipeline idle for most cycles. Skipping
+# those cycles must not change the statistics collected on each of them.
+
+divl %ecx
+addl %eax, %ebx
+sqrtsd %xmm0, %xmm0
+
+# CHECK:      Iterations:        50
+# CHECK-NEXT: Instructions:      150
+# CHECK-NEXT: Total Cycles:      1354
+# CHECK-NEXT: Total uOps:        200
+
+# CHECK:      Dispatch Width:    2
+# CHECK-NEXT: uOps Per Cycle:    0.15
+# CHECK-NEXT: IPC:               0.11
+# CHECK-NEXT: Block RThroughput: 27.0
+
+# CHECK:      Dynamic Dispatch Stall Cycles:
+# CHECK-NEXT: RAT     - Register unavailable:                      156  (11.5%)
+# CHECK-NEXT: RCU     - Retire tokens unavailable:                 0
+# CHECK-NEXT: SCHEDQ  - Scheduler full:                            747  (55.2%)
+# CHECK-NEXT: LQ      - Load queue full:                           0
+# CHECK-NEXT: SQ      - Store queue full:                          0
+# CHECK-NEXT: GROUP   - Static restrictions on the dispatch group: 0
+
+# CHECK:      Dispatch Logic - number of cycles where we saw N micro opcodes dispatched:
+# CHECK-NEXT: [# dispatched], [# cycles]
+# CHECK-NEXT:  0,              1254  (92.6%)
+# CHECK-NEXT:  2,              100  (7.4%)
+
+# CHECK:      Schedulers - number of cycles where we saw N instructions issued:
+# CHECK-NEXT: [# issued], [# cycles]
+# CHECK-NEXT:  0,          1255  (92.7%)
+# CHECK-NEXT:  1,          50  (3.7%)
+# CHECK-NEXT:  2,          47  (3.5%)
+# CHECK-NEXT:  3,          2  (0.1%)
+
+# CHECK:      Scheduler's queue usage:
+# CHECK-NEXT: [1] Resource name.
+# CHECK-NEXT: [2] Average number of used buffer entries.
+# CHECK-NEXT: [3] Maximum number of used buffer entries.
+# CHECK-NEXT: [4] Total number of buffer entries.
+
+# CHECK:       [1]            [2]        [3]        [4]
+# CHECK-NEXT: JALU01           16         20         20
+# CHECK-NEXT: JFPU01           9          12         18
+# CHECK-NEXT: JLSAGU           0          0          12
+
+# CHECK:      Retire Control Unit - number of cycles where we saw N instructions retired:
+# CHECK-NEXT: [# retired], [# cycles]
+# CHECK-NEXT:  0,           1242  (91.7%)
+# CHECK-NEXT:  1,           74  (5.5%)
+# CHECK-NEXT:  2,           38  (2.8%)
+
+# CHECK:      Total ROB Entries:                64
+# CHECK-NEXT: Max Used ROB Entries:             51  ( 79.7% )
+# CHECK-NEXT: Average Used ROB Entries per cy:  39  ( 60.9% )
+
+# CHECK:      Register File statistics:
+# CHECK-NEXT: Total number of mappings created:    300
+# CHECK-NEXT: Max number of mappings used:         76
+
+# CHECK:      *  Register File #1 -- JFpuPRF:
+# CHECK-NEXT:    Number of physical registers:     72
+# CHECK-NEXT:    Total number of mappings created: 50
+# CHECK-NEXT:    Max number of mappings used:      13
+
+# CHECK:      *  Register File #2 -- JIntegerPRF:
+# CHECK-NEXT:    Number of physical registers:     64
+# CHECK-NEXT:    Total number of mappings created: 250
+# CHECK-NEXT:    Max number of mappings used:      63
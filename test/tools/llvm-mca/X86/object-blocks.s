@@ -0,0 +1,37 @@
+# RUN: llvm-mc -filetype=obj -triple=x86_64-unknown-unknown %s -o %t.o
+# RUN: llvm-mca -mcpu=btver2 -iterations=100 -object -block=0-7:1000,9-0xd:10 -json %t.o 2>&1 | FileCheck %s --check-prefix=JSON
+# RUN: echo "2" > %t.prof
+# RUN: echo "0-7:1000" >> %t.prof
+# RUN: echo "9-d:10" >> %t.prof
+# RUN: echo "1" >> %t.prof
+# RUN: echo "7->0:990" >> %t.prof
+# RUN: llvm-mca -mcpu=btver2 -iterations=100 -object -block-profile=%t.prof -resource-pressure=false -instruction-info=false %t.o 2>&1 | FileCheck %s --check-prefix=PROFILE
+# RUN: not llvm-mca -mcpu=btver2 -object -block=20-30 %t.o 2>&1 | FileCheck %s --check-prefix=NOSECTION
+# RUN: not llvm-mca -mcpu=btver2 -object -block=7-0 %t.o 2>&1 | FileCheck %s --check-prefix=BADRANGE
+# RUN: not llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -block=0-7 %s 2>&1 | FileCheck %s --check-prefix=NOOBJECT
+
+loop:
+  addl %esi, %edi
+  imull %edi, %eax
+  decl %ecx
+  jne loop
+  divl %ecx
+  addl %eax, %ebx
+  retq
+
+# JSON:      {"count":1000,"end":"0x7","name":"0x0-0x7","region":0,"start":"0x0","summary":{"block_rthroughput":2.5,"cycles":305,"cycles_per_iteration":{{3\.0(49+[0-9]*|5)}},"dispatch_width":2,"instructions":400,"ipc":{{1\.31147[0-9]*}},"iterations":100,"uops":500,"uops_per_cycle":{{1\.63934[0-9]*}}},"weighted_cycles":3050}
+# JSON-NEXT: {"count":10,"end":"0xd","name":"0x9-0xd","region":1,"start":"0x9","summary":{"block_rthroughput":25,"cycles":2549,"cycles_per_iteration":{{25\.4(89+[0-9]*|9)}},"dispatch_width":2,"instructions":300,"ipc":{{0\.11769[0-9]*}},"iterations":100,"uops":400,"uops_per_cycle":{{0\.15692[0-9]*}}},"weighted_cycles":{{254\.(89+[0-9]*|9)}}}
+
+# PROFILE:      [0] Code Region - 0x0-0x7
+# PROFILE:      Iterations:        100
+# PROFILE-NEXT: Instructions:      400
+# PROFILE-NEXT: Total Cycles:      305
+
+# PROFILE:      [1] Code Region - 0x9-0xd
+# PROFILE:      Iterations:        100
+# PROFILE-NEXT: Instructions:      300
+# PROFILE-NEXT: Total Cycles:      2549
+
+# NOSECTION: error: block 0x20-0x30 is not in a text section of the input file
+# BADRANGE:  error: invalid block range '7-0'
+# NOOBJECT:  error: -block and -block-profile require -object.
@@ -0,0 +1,41 @@
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=1000 -steady-state -resource-pressure=false -instruction-info=false < %s | FileCheck %s --check-prefix=STEADY
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=1000 -steady-state -timeline -timeline-max-iterations=40 -resource-pressure=false -instruction-info=false < %s | FileCheck %s --check-prefix=TIMELINE
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=1000 -num-threads=1 < %s > %t.serial
+# RUN: llvm-mca -mtriple=x86_64-unknown-unknown -mcpu=btver2 -iterations=1000 -num-threads=3 < %s > %t.parallel
+# RUN: cmp %t.serial %t.parallel
+
+# LLVM-MCA-BEGIN div
+idivl %ecx
+# LLVM-MCA-END
+
+# LLVM-MCA-BEGIN chain
+addl %eax, %ebx
+imull %ebx, %ebx
+# LLVM-MCA-END
+
+# LLVM-MCA-BEGIN parallel
+addl %eax, %ebx
+addl %ecx, %edx
+addl %esi, %edi
+# LLVM-MCA-END
+
+# STEADY:      [0] Code Region - div
+# STEADY:      Iterations:        38
+# STEADY-NEXT: Instructions:      38
+# STEADY-NEXT: Total Cycles:      953
+
+# STEADY:      [1] Code Region - chain
+# STEADY:      Iterations:        61
+# STEADY-NEXT: Instructions:      122
+# STEADY-NEXT: Total Cycles:      247
+
+# STEADY:      [2] Code Region - parallel
+# STEADY:      Iterations:        136
+# STEADY-NEXT: Instructions:      408
+# STEADY-NEXT: Total Cycles:      207
+
+# The timeline view needs at least as many iterations as it prints.
+# TIMELINE:      [2] Code Region - parallel
+# TIMELINE:      Iterations:        136
+# TIMELINE:      Timeline view:
+# TIMELINE:      [39,2]
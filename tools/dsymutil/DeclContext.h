@@ -32,7 +32,7 @@ class CachedPathResolver {
 public:
   /// Resolve a path by calling realpath and cache its result. The returned
   /// StringRef is interned in the given \p StringPool.
-  StringRef resolve(std::string Path, NonRelocatableStringpool &StringPool) {
+  StringRef resolve(std::string Path, UniquingStringPool &StringPool) {
     StringRef FileName = sys::path::filename(Path);
     SmallString<256> ParentPath = sys::path::parent_path(Path);
 
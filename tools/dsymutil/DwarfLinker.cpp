@@ -2374,6 +2374,24 @@ bool DwarfLinker::link(const DebugMap &Map) {
       updateAccelKind(*LC.DwarfContext);
   }
 
+  // Parsing the debug info of an object file doesn't depend on any other
+  // object, so when we have threads to spare, extract the DIEs of all object
+  // files in the background while the loop below registers module references
+  // in debug map order. Everything that depends on the order of the objects
+  // (ODR uniquing, DIE selection and cloning) still happens in that order, so
+  // the output is the same as with a single thread. The pool is done before
+  // analysis and cloning start, so its threads don't add to theirs.
+  Optional<ThreadPool> ExtractionPool;
+  std::vector<std::shared_future<void>> DIEsExtracted(NumObjects);
+  if (Options.ParseThreads > 1) {
+    ExtractionPool.emplace(
+        std::min<unsigned>(Options.ParseThreads, NumObjects));
+    for (unsigned i = 0; i != NumObjects; ++i)
+      if (DWARFContext *DwarfContext = ObjectContexts[i].DwarfContext.get())
+        DIEsExtracted[i] = ExtractionPool->async(
+            [DwarfContext] { DwarfContext->extractNormalUnitDIEs(1); });
+  }
+
   // This Dwarf string pool which is only used for uniquing. This one should
   // never be used for offsets as its not thread-safe or predictable.
   UniquingStringPool UniquingStringPool;
@@ -2399,7 +2417,8 @@ bool DwarfLinker::link(const DebugMap &Map) {
       Options.TheAccelTableKind = AccelTableKind::Apple;
   }
 
-  for (LinkContext &LinkContext : ObjectContexts) {
+  for (unsigned i = 0; i != NumObjects; ++i) {
+    LinkContext &LinkContext = ObjectContexts[i];
     if (Options.Verbose)
       outs() << "DEBUG MAP OBJECT: " << LinkContext.DMO.getObjectFilename()
              << "\n";
@@ -2466,6 +2485,9 @@ bool DwarfLinker::link(const DebugMap &Map) {
 
     startDebugObject(LinkContext);
 
+    if (DIEsExtracted[i].valid())
+      DIEsExtracted[i].wait();
+
     // In a first phase, just read in the debug info and load all clang modules.
     LinkContext.CompileUnits.reserve(
         LinkContext.DwarfContext->getNumCompileUnits());
@@ -2487,6 +2509,10 @@ bool DwarfLinker::link(const DebugMap &Map) {
     }
   }
 
+  // Objects skipped above may still be in flight.
+  if (ExtractionPool)
+    ExtractionPool->wait();
+
   // If we haven't seen any CUs, pick an arbitrary valid Dwarf version anyway.
   if (MaxDwarfVersion == 0)
     MaxDwarfVersion = 3;
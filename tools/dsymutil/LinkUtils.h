@@ -54,6 +54,10 @@ struct LinkOptions {
   /// Number of threads.
   unsigned Threads = 1;
 
+  /// Number of threads used to parse the object files of one link. Links of
+  /// different architectures run at the same time and share them.
+  unsigned ParseThreads = 1;
+
   // Output file type.
   OutputFileType FileType = OutputFileType::Object;
 
@@ -16,6 +16,7 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/CodeGen/DwarfStringPoolEntry.h"
 #include "llvm/Support/Allocator.h"
+#include "llvm/Support/ShardedStringPool.h"
 #include <cstdint>
 #include <vector>
 
@@ -79,11 +80,21 @@ public:
 /// It's very easy to introduce bugs by passing the wrong string pool in the
 /// dwarf linker. By using strong types the interface enforces that the right
 /// kind of pool is used.
-struct UniqueTag {};
 struct OffsetsTag {};
-using UniquingStringPool = StrongType<NonRelocatableStringpool, UniqueTag>;
 using OffsetsStringPool = StrongType<NonRelocatableStringpool, OffsetsTag>;
 
+/// A string pool that is only used for uniquing the names used by ODR
+/// uniquing. It never hands out offsets, so it is backed by a sharded pool
+/// that can be used from several threads.
+class UniquingStringPool {
+public:
+  /// Get permanent storage for \p S.
+  StringRef internString(StringRef S) { return Pool.intern(S); }
+
+private:
+  ShardedStringPool Pool;
+};
+
 } // end namespace dsymutil
 } // end namespace llvm
 
@@ -118,7 +118,7 @@ static cl::opt<AccelTableKind> AcceleratorTable(
 static opt<unsigned> NumThreads(
     "num-threads",
     desc("Specifies the maximum number (n) of simultaneous threads to use\n"
-         "when linking multiple architectures."),
+         "when linking multiple architectures and parsing object files."),
     value_desc("n"), init(0), cat(DsymCategory));
 static alias NumThreadsA("j", desc("Alias for --num-threads"),
                          aliasopt(NumThreads));
@@ -517,6 +517,12 @@ int main(int argc, char **argv) {
     NumThreads =
         std::min<unsigned>(OptionsOrErr->Threads, DebugMapPtrsOrErr->size());
     llvm::ThreadPool Threads(NumThreads);
+    // The links share the thread budget for parsing object files, so that
+    // the parsing threads don't multiply with the number of architectures.
+    // Each link keeps its own thread count, which only decides whether it
+    // overlaps analysis and cloning on two threads.
+    OptionsOrErr->ParseThreads =
+        std::max(1U, OptionsOrErr->Threads / NumThreads);
 
     // If there is more than one link to execute, we need to generate
     // temporary files.
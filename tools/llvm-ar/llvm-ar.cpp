@@ -32,6 +32,7 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
@@ -76,6 +77,8 @@ OPTIONS:
     =gnu                -   gnu
     =darwin             -   darwin
     =bsd                -   bsd
+  --num-threads=<n>     - Number of threads used to write the archive
+                          (0 = number of cores, the default)
   --plugin=<string>     - Ignored for compatibility
   --help                - Display available options
   --version             - Display the version of this program
@@ -153,6 +156,8 @@ enum Format { Default, GNU, BSD, DARWIN, Unknown };
 
 static Format FormatType = Default;
 
+static unsigned NumThreads = 0;
+
 static std::string Options;
 
 // This enumeration delineates the kinds of operations on an archive
@@ -784,9 +789,11 @@ static void performWriteOperation(ArchiveOperation Operation,
     llvm_unreachable("");
   }
 
+  unsigned Threads = NumThreads ? NumThreads : hardware_concurrency();
   Error E =
       writeArchive(ArchiveName, NewMembersP ? *NewMembersP : NewMembers, Symtab,
-                   Kind, Deterministic, Thin, std::move(OldArchiveBuf));
+                   Kind, Deterministic, Thin, std::move(OldArchiveBuf),
+                   Threads);
   failIfError(std::move(E), ArchiveName);
 }
 
@@ -994,6 +1001,9 @@ static int ar_main(int argc, char **argv) {
                          .Default(Unknown);
         if (FormatType == Unknown)
           fail(std::string("Invalid format ") + match);
+      } else if (MatchFlagWithArg("num-threads")) {
+        if (StringRef(match).getAsInteger(10, NumThreads))
+          fail(std::string("Invalid number of threads ") + match);
       } else if (MatchFlagWithArg("plugin")) {
         // Ignored.
       } else {
@@ -146,6 +146,9 @@ private:
   /// The architecture the coverage mapping data targets.
   std::vector<StringRef> CoverageArches;
 
+  /// The directory in which decoded coverage mapping data is cached.
+  std::string MappingCacheDir;
+
   /// A cache for demangled symbols.
   DemangleCache DC;
 
@@ -353,7 +356,8 @@ std::unique_ptr<CoverageMapping> CodeCoverageTool::load() {
       warning("profile data may be out of date - object is newer",
               ObjectFilename);
   auto CoverageOrErr =
-      CoverageMapping::load(ObjectFilenames, PGOFilename, CoverageArches);
+      CoverageMapping::load(ObjectFilenames, PGOFilename, CoverageArches,
+                            ViewOpts.NumThreads, MappingCacheDir);
   if (Error E = CoverageOrErr.takeError()) {
     error("Failed to load coverage: " + toString(std::move(E)),
           join(ObjectFilenames.begin(), ObjectFilenames.end(), ", "));
@@ -652,6 +656,11 @@ int CodeCoverageTool::run(Command Cmd, int argc, const char **argv) {
   cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
                         cl::aliasopt(NumThreads));
 
+  cl::opt<std::string, true> MappingCacheDirOpt(
+      "mapping-cache-dir", cl::Optional,
+      cl::desc("Cache decoded coverage mappings in this directory"),
+      cl::location(this->MappingCacheDir));
+
   auto commandLineParser = [&, this](int argc, const char **argv) -> int {
     cl::ParseCommandLineOptions(argc, argv, "LLVM code coverage tool\n");
     ViewOpts.Debug = DebugDump;
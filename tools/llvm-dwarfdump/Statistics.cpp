@@ -5,6 +5,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugLoc.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/ThreadPool.h"
 
 #define DEBUG_TYPE "dwarfdump"
 using namespace llvm;
@@ -43,6 +44,12 @@ struct GlobalStats {
   uint64_t InlineFunctionSize = 0;
 };
 
+/// Statistics gathered from a single compile unit.
+struct UnitStats {
+  StringMap<PerFunctionStats> Statistics;
+  GlobalStats Globals;
+};
+
 /// Extract the low pc from a Die.
 static uint64_t getLowPC(DWARFDie Die) {
   auto RangesOrError = Die.getAddressRanges();
@@ -225,6 +232,29 @@ static void collectStatsRecursive(DWARFDie Die, std::string FnPrefix,
   }
 }
 
+/// Fold the statistics of one compile unit into the totals. Every field is
+/// either a sum or a set union, so the result does not depend on how the
+/// units were grouped.
+static void mergeStats(UnitStats &From, StringMap<PerFunctionStats> &Statistics,
+                       GlobalStats &Globals) {
+  for (auto &Entry : From.Statistics) {
+    PerFunctionStats &Src = Entry.getValue();
+    PerFunctionStats &Dst = Statistics[Entry.getKey()];
+    Dst.NumFnInlined += Src.NumFnInlined;
+    Dst.TotalVarWithLoc += Src.TotalVarWithLoc;
+    Dst.ConstantMembers += Src.ConstantMembers;
+    for (auto &V : Src.VarsInFunction)
+      Dst.VarsInFunction.insert(V.getKey());
+    Dst.IsFunction |= Src.IsFunction;
+  }
+  Globals.ScopeBytesCovered += From.Globals.ScopeBytesCovered;
+  Globals.ScopeBytesFromFirstDefinition +=
+      From.Globals.ScopeBytesFromFirstDefinition;
+  Globals.CallSiteEntries += From.Globals.CallSiteEntries;
+  Globals.FunctionSize += From.Globals.FunctionSize;
+  Globals.InlineFunctionSize += From.Globals.InlineFunctionSize;
+}
+
 /// Print machine-readable output.
 /// The machine-readable format is single-line JSON output.
 /// \{
@@ -247,13 +277,37 @@ static void printDatum(raw_ostream &OS, const char *Key, uint64_t Value) {
 /// useful, only the delta between compiling the same program with different
 /// compilers is.
 bool collectStatsForObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
-                               Twine Filename, raw_ostream &OS) {
+                               Twine Filename, raw_ostream &OS,
+                               unsigned NumThreads) {
   StringRef FormatName = Obj.getFileFormatName();
   GlobalStats GlobalStats;
   StringMap<PerFunctionStats> Statistics;
-  for (const auto &CU : static_cast<DWARFContext *>(&DICtx)->compile_units())
-    if (DWARFDie CUDie = CU->getUnitDIE(false))
-      collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, Statistics, GlobalStats);
+  if (NumThreads <= 1) {
+    for (const auto &CU : DICtx.compile_units())
+      if (DWARFDie CUDie = CU->getUnitDIE(false))
+        collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, Statistics,
+                              GlobalStats);
+  } else {
+    // Everything the walk below reads lazily from the context has to be
+    // materialized before the units are handed out to the workers.
+    DICtx.getDebugLoc();
+    DICtx.extractNormalUnitDIEs(NumThreads);
+    std::vector<UnitStats> PerUnit(DICtx.getNumCompileUnits());
+    ThreadPool Pool(NumThreads);
+    unsigned Idx = 0;
+    for (const auto &CU : DICtx.compile_units()) {
+      DWARFUnit *Unit = CU.get();
+      UnitStats *Stats = &PerUnit[Idx++];
+      Pool.async([Unit, Stats] {
+        if (DWARFDie CUDie = Unit->getUnitDIE(false))
+          collectStatsRecursive(CUDie, "/", "g", 0, 0, 0, Stats->Statistics,
+                                Stats->Globals);
+      });
+    }
+    Pool.wait();
+    for (UnitStats &Stats : PerUnit)
+      mergeStats(Stats, Statistics, GlobalStats);
+  }
 
   /// The version number should be increased every time the algorithm is changed
   /// (including bug fixes). New metrics may be added without increasing the
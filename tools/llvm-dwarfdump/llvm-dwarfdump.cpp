@@ -16,6 +16,7 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugNamesBuilder.h"
 #include "llvm/Object/Archive.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
@@ -27,6 +28,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
@@ -209,6 +211,17 @@ static cl::opt<bool>
                cat(DwarfDumpCategory));
 static opt<bool> Verify("verify", desc("Verify the DWARF debug info."),
                         cat(DwarfDumpCategory));
+static opt<bool> GenerateDebugNames(
+    "generate-debug-names",
+    desc("Build a DWARF v5 .debug_names section for the compile units and "
+         "write its raw contents to the output."),
+    cat(DwarfDumpCategory));
+static opt<unsigned>
+    NumThreads("num-threads",
+               desc("Number of threads used to extract and process units with "
+                    "-verify, -statistics and -generate-debug-names "
+                    "(0 = number of cores)."),
+               cat(DwarfDumpCategory), init(1), value_desc("N"));
 static opt<bool> Quiet("quiet", desc("Use with -verify to not emit to STDOUT."),
                        cat(DwarfDumpCategory));
 static opt<bool> DumpUUID("uuid", desc("Show the UUID for each architecture."),
@@ -240,6 +253,7 @@ static DIDumpOptions getDumpOpts() {
   DumpOpts.ShowForm = ShowForm;
   DumpOpts.SummarizeTypes = SummarizeTypes;
   DumpOpts.Verbose = Verbose;
+  DumpOpts.NumThreads = NumThreads;
   // In -verify mode, print DIEs without children in error messages.
   if (Verify)
     return DumpOpts.noImplicitRecursion();
@@ -322,57 +336,12 @@ static void filterByName(const StringSet<> &Names,
     }
 }
 
-static void getDies(DWARFContext &DICtx, const AppleAcceleratorTable &Accel,
-                    StringRef Name, SmallVectorImpl<DWARFDie> &Dies) {
-  for (const auto &Entry : Accel.equal_range(Name)) {
-    if (llvm::Optional<uint64_t> Off = Entry.getDIESectionOffset()) {
-      if (DWARFDie Die = DICtx.getDIEForOffset(*Off))
-        Dies.push_back(Die);
-    }
-  }
-}
-
-static DWARFDie toDie(const DWARFDebugNames::Entry &Entry,
-                      DWARFContext &DICtx) {
-  llvm::Optional<uint64_t> CUOff = Entry.getCUOffset();
-  llvm::Optional<uint64_t> Off = Entry.getDIEUnitOffset();
-  if (!CUOff || !Off)
-    return DWARFDie();
-
-  DWARFCompileUnit *CU = DICtx.getCompileUnitForOffset(*CUOff);
-  if (!CU)
-    return DWARFDie();
-
-  if (llvm::Optional<uint64_t> DWOId = CU->getDWOId()) {
-    // This is a skeleton unit. Look up the DIE in the DWO unit.
-    CU = DICtx.getDWOCompileUnitForHash(*DWOId);
-    if (!CU)
-      return DWARFDie();
-  }
-
-  return CU->getDIEForOffset(CU->getOffset() + *Off);
-}
-
-static void getDies(DWARFContext &DICtx, const DWARFDebugNames &Accel,
-                    StringRef Name, SmallVectorImpl<DWARFDie> &Dies) {
-  for (const auto &Entry : Accel.equal_range(Name)) {
-    if (DWARFDie Die = toDie(Entry, DICtx))
-      Dies.push_back(Die);
-  }
-}
-
 /// Print only DIEs that have a certain name.
 static void filterByAccelName(ArrayRef<std::string> Names, DWARFContext &DICtx,
                               raw_ostream &OS) {
   SmallVector<DWARFDie, 4> Dies;
-  for (const auto &Name : Names) {
-    getDies(DICtx, DICtx.getAppleNames(), Name, Dies);
-    getDies(DICtx, DICtx.getAppleTypes(), Name, Dies);
-    getDies(DICtx, DICtx.getAppleNamespaces(), Name, Dies);
-    getDies(DICtx, DICtx.getDebugNames(), Name, Dies);
-  }
-  llvm::sort(Dies);
-  Dies.erase(std::unique(Dies.begin(), Dies.end()), Dies.end());
+  for (const auto &Name : Names)
+    DICtx.getDIEsForName(Name, Dies);
 
   for (DWARFDie Die : Dies)
     Die.dump(OS, 0, getDumpOpts());
@@ -402,7 +371,8 @@ static bool lookup(DWARFContext &DICtx, uint64_t Address, raw_ostream &OS) {
 }
 
 bool collectStatsForObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
-                               Twine Filename, raw_ostream &OS);
+                               Twine Filename, raw_ostream &OS,
+                               unsigned NumThreads);
 
 static bool dumpObjectFile(ObjectFile &Obj, DWARFContext &DICtx, Twine Filename,
                            raw_ostream &OS) {
@@ -453,6 +423,21 @@ static bool verifyObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
   return Result;
 }
 
+static bool generateDebugNames(ObjectFile &Obj, DWARFContext &DICtx,
+                               Twine Filename, raw_ostream &OS) {
+  unsigned NumSkipped = 0;
+  if (Error E = writeDebugNames(DICtx, OS, NumThreads, NumSkipped)) {
+    logAllUnhandledErrors(std::move(E), WithColor::error(),
+                          Filename.str() + ": ");
+    return false;
+  }
+  if (NumSkipped)
+    WithColor::warning() << Filename << ": " << NumSkipped
+                         << " name(s) not in .debug_str were left out of the "
+                            "index\n";
+  return true;
+}
+
 static bool handleBuffer(StringRef Filename, MemoryBufferRef Buffer,
                          HandlerFn HandleObj, raw_ostream &OS);
 
@@ -630,16 +615,32 @@ int main(int argc, char **argv) {
     Objects.insert(Objects.end(), Objs.begin(), Objs.end());
   }
 
-  if (Verify) {
+  if (NumThreads == 0)
+    NumThreads = llvm::hardware_concurrency();
+
+  if (GenerateDebugNames) {
+    // The section contents of several objects can't be told apart.
+    if (Objects.size() != 1) {
+      WithColor::error() << "-generate-debug-names requires a single input "
+                            "object\n";
+      return EXIT_FAILURE;
+    }
+    if (!handleFile(Objects.front(), generateDebugNames, OS))
+      return EXIT_FAILURE;
+  } else if (Verify) {
     // If we encountered errors during verify, exit with a non-zero exit status.
     if (!all_of(Objects, [&](std::string Object) {
           return handleFile(Object, verifyObjectFile, OS);
         }))
       exit(1);
-  } else if (Statistics)
+  } else if (Statistics) {
+    auto CollectStats = [](ObjectFile &Obj, DWARFContext &DICtx,
+                           Twine Filename, raw_ostream &OS) {
+      return collectStatsForObjectFile(Obj, DICtx, Filename, OS, NumThreads);
+    };
     for (auto Object : Objects)
-      handleFile(Object, collectStatsForObjectFile, OS);
-  else
+      handleFile(Object, CollectStats, OS);
+  } else
     for (auto Object : Objects)
       handleFile(Object, dumpObjectFile, OS);
 
@@ -1,54 +1,52 @@
 #ifndef TOOLS_LLVM_DWP_DWPSTRINGPOOL
 #define TOOLS_LLVM_DWP_DWPSTRINGPOOL
 
-#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCStreamer.h"
+#include "llvm/Support/ShardedStringPool.h"
 #include <cassert>
+#include <vector>
 
 namespace llvm {
 class DWPStringPool {
-
-  struct CStrDenseMapInfo {
-    static inline const char *getEmptyKey() {
-      return reinterpret_cast<const char *>(~static_cast<uintptr_t>(0));
-    }
-    static inline const char *getTombstoneKey() {
-      return reinterpret_cast<const char *>(~static_cast<uintptr_t>(1));
-    }
-    static unsigned getHashValue(const char *Val) {
-      assert(Val != getEmptyKey() && "Cannot hash the empty key!");
-      assert(Val != getTombstoneKey() && "Cannot hash the tombstone key!");
-      return (unsigned)hash_value(StringRef(Val));
-    }
-    static bool isEqual(const char *LHS, const char *RHS) {
-      if (RHS == getEmptyKey())
-        return LHS == getEmptyKey();
-      if (RHS == getTombstoneKey())
-        return LHS == getTombstoneKey();
-      return strcmp(LHS, RHS) == 0;
-    }
-  };
-
   MCStreamer &Out;
-  MCSection *Sec;
-  DenseMap<const char *, uint32_t, CStrDenseMapInfo> Pool;
-  uint32_t Offset = 0;
+  MCSection *StrSec;
+  MCSection *StrOffsetSec;
+  /// Owns a copy of every string, so that the input the string came from can
+  /// be released as soon as it has been merged.
+  ShardedStringPool Pool;
+  /// The entries of .debug_str_offsets.dwo in output order. Offsets in the
+  /// pool are only known once all strings are in, so the entries are kept as
+  /// pooled strings until then. A null entry did not refer to the start of a
+  /// string in its input and is written as 0.
+  std::vector<StringRef> StrOffsets;
 
 public:
-  DWPStringPool(MCStreamer &Out, MCSection *Sec) : Out(Out), Sec(Sec) {}
+  DWPStringPool(MCStreamer &Out, MCSection *StrSec, MCSection *StrOffsetSec)
+      : Out(Out), StrSec(StrSec), StrOffsetSec(StrOffsetSec) {}
 
-  uint32_t getOffset(const char *Str, unsigned Length) {
+  StringRef intern(const char *Str, unsigned Length) {
     assert(strlen(Str) + 1 == Length && "Ensure length hint is correct");
+    return Pool.intern(StringRef(Str, Length - 1));
+  }
 
-    auto Pair = Pool.insert(std::make_pair(Str, Offset));
-    if (Pair.second) {
-      Out.SwitchSection(Sec);
-      Out.EmitBytes(StringRef(Str, Length));
-      Offset += Length;
+  /// Appends an entry for \p Pooled, which was returned by intern(), or for
+  /// no string if it is null, to .debug_str_offsets.dwo.
+  void addOffset(StringRef Pooled) { StrOffsets.push_back(Pooled); }
+
+  /// Emits .debug_str.dwo and .debug_str_offsets.dwo once all inputs have
+  /// been merged.
+  void emit() {
+    Pool.finalize();
+    Out.SwitchSection(StrSec);
+    for (StringRef S : Pool.getStrings()) {
+      Out.EmitBytes(S);
+      Out.EmitBytes(StringRef("\0", 1));
     }
-
-    return Pair.first->second;
+    Out.SwitchSection(StrOffsetSec);
+    for (StringRef S : StrOffsets)
+      Out.EmitIntValue(S.data() ? Pool.getOffset(S) : 0, 4);
   }
 };
 }
@@ -13,8 +13,10 @@
 //===----------------------------------------------------------------------===//
 #include "DWPError.h"
 #include "DWPStringPool.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFFormValue.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
@@ -39,6 +41,8 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -59,8 +63,15 @@ static cl::opt<std::string> OutputFilename(cl::Required, "o",
                                            cl::value_desc("filename"),
                                            cl::cat(DwpCategory));
 
-static void writeStringsAndOffsets(MCStreamer &Out, DWPStringPool &Strings,
-                                   MCSection *StrOffsetSection,
+static cl::opt<unsigned> NumThreads(
+    "num-threads",
+    cl::desc("Number of threads used to read and decompress input files "
+             "ahead of merging them (0 = number of cores)."),
+    cl::value_desc("n"), cl::init(0), cl::cat(DwpCategory));
+static cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                             cl::aliasopt(NumThreads));
+
+static void writeStringsAndOffsets(DWPStringPool &Strings,
                                    StringRef CurStrSection,
                                    StringRef CurStrOffsetSection) {
   // Could possibly produce an error or warning if one of these was non-null but
@@ -68,27 +79,23 @@ static void writeStringsAndOffsets(MCStreamer &Out, DWPStringPool &Strings,
   if (CurStrSection.empty() || CurStrOffsetSection.empty())
     return;
 
-  DenseMap<uint32_t, uint32_t> OffsetRemapping;
+  DenseMap<uint32_t, StringRef> OffsetRemapping;
 
   DataExtractor Data(CurStrSection, true, 0);
   uint32_t LocalOffset = 0;
   uint32_t PrevOffset = 0;
   while (const char *s = Data.getCStr(&LocalOffset)) {
-    OffsetRemapping[PrevOffset] =
-        Strings.getOffset(s, LocalOffset - PrevOffset);
+    OffsetRemapping[PrevOffset] = Strings.intern(s, LocalOffset - PrevOffset);
     PrevOffset = LocalOffset;
   }
 
   Data = DataExtractor(CurStrOffsetSection, true, 0);
 
-  Out.SwitchSection(StrOffsetSection);
-
   uint32_t Offset = 0;
   uint64_t Size = CurStrOffsetSection.size();
   while (Offset < Size) {
     auto OldOffset = Data.getU32(&Offset);
-    auto NewOffset = OffsetRemapping[OldOffset];
-    Out.EmitIntValue(NewOffset, 4);
+    Strings.addOffset(OffsetRemapping.lookup(OldOffset));
   }
 }
 
@@ -383,36 +390,60 @@ handleCompressedSection(std::deque<SmallString<32>> &UncompressedSections,
   return Error::success();
 }
 
-static Error handleSection(
-    const StringMap<std::pair<MCSection *, DWARFSectionKind>> &KnownSections,
-    const MCSection *StrSection, const MCSection *StrOffsetSection,
-    const MCSection *TypesSection, const MCSection *CUIndexSection,
-    const MCSection *TUIndexSection, const SectionRef &Section, MCStreamer &Out,
-    std::deque<SmallString<32>> &UncompressedSections,
-    uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
-    StringRef &CurStrSection, StringRef &CurStrOffsetSection,
-    std::vector<StringRef> &CurTypesSection, StringRef &InfoSection,
-    StringRef &AbbrevSection, StringRef &CurCUIndexSection,
-    StringRef &CurTUIndexSection) {
-  if (Section.isBSS())
-    return Error::success();
+namespace {
+/// An input file whose sections have been read, and decompressed if needed,
+/// ahead of being merged into the output.
+struct LoadedInput {
+  OwningBinary<object::ObjectFile> Obj;
+  std::deque<SmallString<32>> UncompressedSections;
+  /// Names (without the leading "._" characters) and contents of the
+  /// non-empty sections, in section order.
+  std::vector<std::pair<StringRef, StringRef>> Sections;
+};
+} // end anonymous namespace
 
-  if (Section.isVirtual())
-    return Error::success();
+static Expected<std::unique_ptr<LoadedInput>> loadInput(StringRef Input) {
+  auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
+  if (!ErrOrObj)
+    return ErrOrObj.takeError();
 
-  StringRef Name;
-  if (std::error_code Err = Section.getName(Name))
-    return errorCodeToError(Err);
+  auto Loaded = llvm::make_unique<LoadedInput>();
+  Loaded->Obj = std::move(*ErrOrObj);
+  for (const auto &Section : Loaded->Obj.getBinary()->sections()) {
+    if (Section.isBSS())
+      continue;
+
+    if (Section.isVirtual())
+      continue;
 
-  StringRef Contents;
-  if (auto Err = Section.getContents(Contents))
-    return errorCodeToError(Err);
+    StringRef Name;
+    if (std::error_code Err = Section.getName(Name))
+      return errorCodeToError(Err);
 
-  if (auto Err = handleCompressedSection(UncompressedSections, Name, Contents))
-    return Err;
+    StringRef Contents;
+    if (auto Err = Section.getContents(Contents))
+      return errorCodeToError(Err);
 
-  Name = Name.substr(Name.find_first_not_of("._"));
+    if (auto Err = handleCompressedSection(Loaded->UncompressedSections, Name,
+                                           Contents))
+      return std::move(Err);
 
+    Name = Name.substr(Name.find_first_not_of("._"));
+    Loaded->Sections.emplace_back(Name, Contents);
+  }
+  return std::move(Loaded);
+}
+
+static Error handleSection(
+    const StringMap<std::pair<MCSection *, DWARFSectionKind>> &KnownSections,
+    const MCSection *StrSection, const MCSection *StrOffsetSection,
+    const MCSection *TypesSection, const MCSection *CUIndexSection,
+    const MCSection *TUIndexSection, StringRef Name, StringRef Contents,
+    MCStreamer &Out, uint32_t (&ContributionOffsets)[8],
+    UnitIndexEntry &CurEntry, StringRef &CurStrSection,
+    StringRef &CurStrOffsetSection, std::vector<StringRef> &CurTypesSection,
+    StringRef &InfoSection, StringRef &AbbrevSection,
+    StringRef &CurCUIndexSection, StringRef &CurTUIndexSection) {
   auto SectionPair = KnownSections.find(Name);
   if (SectionPair == KnownSections.end())
     return Error::success();
@@ -517,20 +548,45 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
 
   uint32_t ContributionOffsets[8] = {};
 
-  DWPStringPool Strings(Out, StrSection);
-
-  SmallVector<OwningBinary<object::ObjectFile>, 128> Objects;
-  Objects.reserve(Inputs.size());
-
-  std::deque<SmallString<32>> UncompressedSections;
-
-  for (const auto &Input : Inputs) {
-    auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
-    if (!ErrOrObj)
-      return ErrOrObj.takeError();
-
-    auto &Obj = *ErrOrObj->getBinary();
-    Objects.push_back(std::move(*ErrOrObj));
+  DWPStringPool Strings(Out, StrSection, StrOffsetSection);
+
+  // Inputs are read and decompressed on a thread pool, a bounded number of
+  // files ahead of the one being merged, and are released once merged. The
+  // merge itself runs in input order, so the output does not depend on the
+  // number of threads, and the inputs held in memory at any time are bounded
+  // by the size of the window.
+  unsigned Threads = std::max(1U, std::min<unsigned>(NumThreads, Inputs.size()));
+  ThreadPool Pool(Threads);
+  const size_t Window = 2 * Threads;
+  std::vector<Optional<Expected<std::unique_ptr<LoadedInput>>>> Loaded(
+      Inputs.size());
+  std::vector<std::shared_future<void>> LoadDone(Inputs.size());
+  auto StartLoad = [&](size_t I) {
+    if (I < Inputs.size())
+      LoadDone[I] = Pool.async([&, I] { Loaded[I] = loadInput(Inputs[I]); });
+  };
+  for (size_t I = 0; I != Window; ++I)
+    StartLoad(I);
+  // If merging fails, the inputs that are still loading must be waited for
+  // and their errors discarded.
+  auto DiscardPending = make_scope_exit([&] {
+    Pool.wait();
+    for (auto &L : Loaded)
+      if (L && !*L)
+        consumeError(L->takeError());
+  });
+
+  for (size_t InputIdx = 0; InputIdx != Inputs.size(); ++InputIdx) {
+    const std::string &Input = Inputs[InputIdx];
+    LoadDone[InputIdx].wait();
+    StartLoad(InputIdx + Window);
+    Expected<std::unique_ptr<LoadedInput>> ErrOrLoaded =
+        std::move(*Loaded[InputIdx]);
+    Loaded[InputIdx].reset();
+    if (!ErrOrLoaded)
+      return ErrOrLoaded.takeError();
+    std::unique_ptr<LoadedInput> CurInput = std::move(*ErrOrLoaded);
+    auto &Obj = *CurInput->Obj.getBinary();
 
     UnitIndexEntry CurEntry = {};
 
@@ -542,20 +598,19 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
     StringRef CurCUIndexSection;
     StringRef CurTUIndexSection;
 
-    for (const auto &Section : Obj.sections())
+    for (const auto &Section : CurInput->Sections)
       if (auto Err = handleSection(
               KnownSections, StrSection, StrOffsetSection, TypesSection,
-              CUIndexSection, TUIndexSection, Section, Out,
-              UncompressedSections, ContributionOffsets, CurEntry,
-              CurStrSection, CurStrOffsetSection, CurTypesSection, InfoSection,
-              AbbrevSection, CurCUIndexSection, CurTUIndexSection))
+              CUIndexSection, TUIndexSection, Section.first, Section.second,
+              Out, ContributionOffsets, CurEntry, CurStrSection,
+              CurStrOffsetSection, CurTypesSection, InfoSection, AbbrevSection,
+              CurCUIndexSection, CurTUIndexSection))
         return Err;
 
     if (InfoSection.empty())
       continue;
 
-    writeStringsAndOffsets(Out, Strings, StrOffsetSection, CurStrSection,
-                           CurStrOffsetSection);
+    writeStringsAndOffsets(Strings, CurStrSection, CurStrOffsetSection);
 
     if (CurCUIndexSection.empty()) {
       Expected<CompileUnitIdentifiers> EID = getCUIdentifiers(
@@ -618,6 +673,8 @@ static Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
     }
   }
 
+  Strings.emit();
+
   // Lie about there being no info contributions so the TU index only includes
   // the type unit contribution
   ContributionOffsets[0] = 0;
@@ -729,6 +786,9 @@ int main(int argc, char **argv) {
                         std::make_move_iterator(DWOs->end()));
   }
 
+  if (NumThreads == 0)
+    NumThreads = llvm::hardware_concurrency();
+
   if (auto Err = write(*MS, DWOFilenames)) {
     logAllUnhandledErrors(std::move(Err), errs(), "error: ");
     return 1;
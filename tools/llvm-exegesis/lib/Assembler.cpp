@@ -249,8 +249,8 @@ namespace {
 // single function will be loaded into memory.
 class TrackingSectionMemoryManager : public llvm::SectionMemoryManager {
 public:
-  explicit TrackingSectionMemoryManager(uintptr_t *CodeSize)
-      : CodeSize(CodeSize) {}
+  TrackingSectionMemoryManager(uintptr_t *CodeSize, ExecutableMemoryPool *Pool)
+      : llvm::SectionMemoryManager(Pool), CodeSize(CodeSize) {}
 
   uint8_t *allocateCodeSection(uintptr_t Size, unsigned Alignment,
                                unsigned SectionID,
@@ -266,9 +266,52 @@ private:
 
 } // namespace
 
+ExecutableMemoryPool::~ExecutableMemoryPool() {
+  for (llvm::sys::MemoryBlock &Block : FreeBlocks)
+    llvm::sys::Memory::releaseMappedMemory(Block);
+}
+
+llvm::sys::MemoryBlock ExecutableMemoryPool::allocateMappedMemory(
+    llvm::SectionMemoryManager::AllocationPurpose Purpose, size_t NumBytes,
+    const llvm::sys::MemoryBlock *const NearBlock, unsigned Flags,
+    std::error_code &EC) {
+  // Reuse the smallest free block that is large enough.
+  auto Best = FreeBlocks.end();
+  for (auto I = FreeBlocks.begin(), E = FreeBlocks.end(); I != E; ++I)
+    if (I->size() >= NumBytes &&
+        (Best == FreeBlocks.end() || I->size() < Best->size()))
+      Best = I;
+  if (Best == FreeBlocks.end())
+    return llvm::sys::Memory::allocateMappedMemory(NumBytes, NearBlock, Flags,
+                                                   EC);
+  llvm::sys::MemoryBlock Block = *Best;
+  FreeBlocks.erase(Best);
+  // The block was left read-only or executable by its previous user.
+  EC = llvm::sys::Memory::protectMappedMemory(Block, Flags);
+  if (EC) {
+    llvm::sys::Memory::releaseMappedMemory(Block);
+    return llvm::sys::MemoryBlock();
+  }
+  return Block;
+}
+
+std::error_code
+ExecutableMemoryPool::protectMappedMemory(const llvm::sys::MemoryBlock &Block,
+                                          unsigned Flags) {
+  return llvm::sys::Memory::protectMappedMemory(Block, Flags);
+}
+
+std::error_code
+ExecutableMemoryPool::releaseMappedMemory(llvm::sys::MemoryBlock &Block) {
+  FreeBlocks.push_back(Block);
+  Block = llvm::sys::MemoryBlock();
+  return std::error_code();
+}
+
 ExecutableFunction::ExecutableFunction(
     std::unique_ptr<llvm::LLVMTargetMachine> TM,
-    llvm::object::OwningBinary<llvm::object::ObjectFile> &&ObjectFileHolder)
+    llvm::object::OwningBinary<llvm::object::ObjectFile> &&ObjectFileHolder,
+    ExecutableMemoryPool *Pool)
     : Context(llvm::make_unique<llvm::LLVMContext>()) {
   assert(ObjectFileHolder.getBinary() && "cannot create object file");
   // Initializing the execution engine.
@@ -282,7 +325,7 @@ ExecutableFunction::ExecutableFunction(
           .setMCPU(TM->getTargetCPU())
           .setEngineKind(llvm::EngineKind::JIT)
           .setMCJITMemoryManager(
-              llvm::make_unique<TrackingSectionMemoryManager>(&CodeSize))
+              llvm::make_unique<TrackingSectionMemoryManager>(&CodeSize, Pool))
           .create(TM.release()));
   if (!ExecEngine)
     llvm::report_fatal_error(Error);
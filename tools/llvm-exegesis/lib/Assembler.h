@@ -24,6 +24,7 @@
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/MC/MCInst.h"
@@ -31,6 +32,7 @@
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
+#include <vector>
 
 namespace llvm {
 namespace exegesis {
@@ -62,12 +64,39 @@ getObjectFromBuffer(llvm::StringRef Buffer);
 llvm::object::OwningBinary<llvm::object::ObjectFile>
 getObjectFromFile(llvm::StringRef Filename);
 
+// Hands out pages for ExecutableFunction, and keeps the pages that are released
+// to hand them out again, so that loading many functions one after the other
+// does not map and unmap memory for each of them. This is not thread safe: use
+// one pool per thread.
+class ExecutableMemoryPool : public llvm::SectionMemoryManager::MemoryMapper {
+public:
+  ExecutableMemoryPool() = default;
+  ExecutableMemoryPool(const ExecutableMemoryPool &) = delete;
+  ~ExecutableMemoryPool() override;
+
+  llvm::sys::MemoryBlock
+  allocateMappedMemory(llvm::SectionMemoryManager::AllocationPurpose Purpose,
+                       size_t NumBytes,
+                       const llvm::sys::MemoryBlock *const NearBlock,
+                       unsigned Flags, std::error_code &EC) override;
+
+  std::error_code protectMappedMemory(const llvm::sys::MemoryBlock &Block,
+                                      unsigned Flags) override;
+
+  std::error_code releaseMappedMemory(llvm::sys::MemoryBlock &Block) override;
+
+private:
+  std::vector<llvm::sys::MemoryBlock> FreeBlocks;
+};
+
 // Consumes an ObjectFile containing a `void foo(char*)` function and make it
-// executable.
+// executable. If Pool is not null, the function is loaded into pages from the
+// pool, which must outlive the ExecutableFunction.
 struct ExecutableFunction {
   explicit ExecutableFunction(
       std::unique_ptr<llvm::LLVMTargetMachine> TM,
-      llvm::object::OwningBinary<llvm::object::ObjectFile> &&ObjectFileHolder);
+      llvm::object::OwningBinary<llvm::object::ObjectFile> &&ObjectFileHolder,
+      ExecutableMemoryPool *Pool = nullptr);
 
   // Retrieves the function as an array of bytes.
   llvm::StringRef getFunctionBytes() const { return FunctionBytes; }
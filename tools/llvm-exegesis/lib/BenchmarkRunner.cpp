@@ -8,7 +8,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "Assembler.h"
 #include "BenchmarkRunner.h"
@@ -22,6 +26,10 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Program.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 namespace llvm {
 namespace exegesis {
 
@@ -30,7 +38,7 @@ BenchmarkFailure::BenchmarkFailure(const llvm::Twine &S)
 
 BenchmarkRunner::BenchmarkRunner(const LLVMState &State,
                                  InstructionBenchmark::ModeE Mode)
-    : State(State), Mode(Mode), Scratch(llvm::make_unique<ScratchSpace>()) {}
+    : State(State), Mode(Mode), MainWorker(llvm::make_unique<Worker>()) {}
 
 BenchmarkRunner::~BenchmarkRunner() = default;
 
@@ -51,9 +59,9 @@ class FunctionExecutorImpl : public BenchmarkRunner::FunctionExecutor {
 public:
   FunctionExecutorImpl(const LLVMState &State,
                        llvm::object::OwningBinary<llvm::object::ObjectFile> Obj,
-                       BenchmarkRunner::ScratchSpace *Scratch)
-      : Function(State.createTargetMachine(), std::move(Obj)),
-        Scratch(Scratch) {}
+                       BenchmarkRunner::Worker *W)
+      : Function(State.createTargetMachine(), std::move(Obj), &W->CodeMemory),
+        W(W) {}
 
 private:
   llvm::Expected<int64_t> runAndMeasure(const char *Counters) const override {
@@ -62,42 +70,143 @@ private:
     int64_t CounterValue = 0;
     llvm::SmallVector<llvm::StringRef, 2> CounterNames;
     llvm::StringRef(Counters).split(CounterNames, '+');
-    char *const ScratchPtr = Scratch->ptr();
+    char *const ScratchPtr = W->Scratch.ptr();
     for (auto &CounterName : CounterNames) {
       CounterName = CounterName.trim();
-      pfm::PerfEvent PerfEvent(CounterName);
-      if (!PerfEvent.valid())
+      pfm::Counter *const Counter = W->Counters.getCounter(CounterName);
+      if (!Counter)
         llvm::report_fatal_error(
             llvm::Twine("invalid perf event '").concat(CounterName).concat("'"));
-      pfm::Counter Counter(PerfEvent);
-      Scratch->clear();
+      W->Scratch.clear();
       {
+        // Crash recovery is enabled by the callers of runConfiguration.
         llvm::CrashRecoveryContext CRC;
-        llvm::CrashRecoveryContext::Enable();
-        const bool Crashed = !CRC.RunSafely([this, &Counter, ScratchPtr]() {
-          Counter.start();
+        const bool Crashed = !CRC.RunSafely([this, Counter, ScratchPtr]() {
+          Counter->start();
           this->Function(ScratchPtr);
-          Counter.stop();
+          Counter->stop();
         });
-        llvm::CrashRecoveryContext::Disable();
         // FIXME: Better diagnosis.
         if (Crashed)
           return llvm::make_error<BenchmarkFailure>(
               "snippet crashed while running");
       }
-      CounterValue += Counter.read();
+      CounterValue += Counter->read();
     }
     return CounterValue;
   }
 
   const ExecutableFunction Function;
-  BenchmarkRunner::ScratchSpace *const Scratch;
+  BenchmarkRunner::Worker *const W;
 };
 } // namespace
 
 InstructionBenchmark
 BenchmarkRunner::runConfiguration(const BenchmarkCode &BC,
                                   unsigned NumRepetitions) const {
+  llvm::CrashRecoveryContext::Enable();
+  InstructionBenchmark Result =
+      runConfiguration(BC, NumRepetitions, *MainWorker, nullptr);
+  llvm::CrashRecoveryContext::Disable();
+  return Result;
+}
+
+// Checks that the process may run on `Cpu`.
+static llvm::Error checkCpuIsAvailable(unsigned Cpu) {
+#if defined(__linux__)
+  cpu_set_t Allowed;
+  CPU_ZERO(&Allowed);
+  if (Cpu < CPU_SETSIZE &&
+      sched_getaffinity(0, sizeof(Allowed), &Allowed) == 0 &&
+      CPU_ISSET(Cpu, &Allowed))
+    return llvm::Error::success();
+  return llvm::make_error<BenchmarkFailure>(
+      llvm::Twine("cpu ").concat(llvm::Twine(Cpu)).concat(" is not available"));
+#else
+  return llvm::make_error<BenchmarkFailure>(
+      "running benchmarks on given cpus is only supported on Linux");
+#endif
+}
+
+static void pinCurrentThread(unsigned Cpu) {
+#if defined(__linux__)
+  cpu_set_t Set;
+  CPU_ZERO(&Set);
+  CPU_SET(Cpu, &Set);
+  if (sched_setaffinity(0, sizeof(Set), &Set) != 0)
+    llvm::report_fatal_error(
+        llvm::Twine("cannot pin benchmark worker to cpu ")
+            .concat(llvm::Twine(Cpu)));
+#endif
+}
+
+llvm::Error BenchmarkRunner::runConfigurations(
+    llvm::ArrayRef<BenchmarkCode> Configurations, unsigned NumRepetitions,
+    llvm::ArrayRef<unsigned> Cpus,
+    llvm::function_ref<llvm::Error(InstructionBenchmark &)> Consumer) const {
+  for (const unsigned Cpu : Cpus)
+    if (llvm::Error E = checkCpuIsAvailable(Cpu))
+      return E;
+
+  struct Slot {
+    InstructionBenchmark Result;
+    std::string ObjectFilePath;
+    bool Done = false;
+  };
+  std::vector<Slot> Slots(Configurations.size());
+  std::atomic<size_t> NextSlot(0);
+  std::mutex SlotsMutex;
+  std::condition_variable SlotDone;
+
+  // Each worker takes the next configuration that nobody is running yet.
+  llvm::CrashRecoveryContext::Enable();
+  std::vector<std::thread> Threads;
+  for (const unsigned Cpu : Cpus)
+    Threads.emplace_back([&, Cpu]() {
+      pinCurrentThread(Cpu);
+      Worker W;
+      for (size_t I = NextSlot++; I < Slots.size(); I = NextSlot++) {
+        std::string ObjectFilePath;
+        InstructionBenchmark Result = runConfiguration(
+            Configurations[I], NumRepetitions, W, &ObjectFilePath);
+        std::lock_guard<std::mutex> Lock(SlotsMutex);
+        Slots[I].Result = std::move(Result);
+        Slots[I].ObjectFilePath = std::move(ObjectFilePath);
+        Slots[I].Done = true;
+        SlotDone.notify_all();
+      }
+    });
+  const auto Join = [&Threads]() {
+    for (std::thread &T : Threads)
+      T.join();
+    llvm::CrashRecoveryContext::Disable();
+  };
+
+  for (Slot &S : Slots) {
+    std::unique_lock<std::mutex> Lock(SlotsMutex);
+    SlotDone.wait(Lock, [&S]() { return S.Done; });
+    InstructionBenchmark Result = std::move(S.Result);
+    Lock.unlock();
+    // Printed here rather than by the worker so that it does not interleave
+    // with what the consumer writes to the same stream.
+    if (!S.ObjectFilePath.empty())
+      llvm::outs() << "Check generated assembly with: /usr/bin/objdump -d "
+                   << S.ObjectFilePath << "\n";
+    if (llvm::Error E = Consumer(Result)) {
+      // Let the workers finish the configurations they are running.
+      NextSlot = Slots.size();
+      Join();
+      return E;
+    }
+  }
+  Join();
+  return llvm::Error::success();
+}
+
+InstructionBenchmark
+BenchmarkRunner::runConfiguration(const BenchmarkCode &BC,
+                                  unsigned NumRepetitions, Worker &W,
+                                  std::string *ObjectFilePathOut) const {
   InstructionBenchmark InstrBenchmark;
   InstrBenchmark.Mode = Mode;
   InstrBenchmark.CpuName = State.getTargetMachine().getTargetCPU();
@@ -123,7 +232,8 @@ BenchmarkRunner::runConfiguration(const BenchmarkCode &BC,
       return InstrBenchmark;
     }
     const ExecutableFunction EF(State.createTargetMachine(),
-                                getObjectFromFile(*ObjectFilePath));
+                                getObjectFromFile(*ObjectFilePath),
+                                &W.CodeMemory);
     const auto FnBytes = EF.getFunctionBytes();
     InstrBenchmark.AssembledSnippet.assign(FnBytes.begin(), FnBytes.end());
   }
@@ -136,10 +246,13 @@ BenchmarkRunner::runConfiguration(const BenchmarkCode &BC,
     InstrBenchmark.Error = llvm::toString(std::move(E));
     return InstrBenchmark;
   }
-  llvm::outs() << "Check generated assembly with: /usr/bin/objdump -d "
-               << *ObjectFilePath << "\n";
+  if (ObjectFilePathOut)
+    *ObjectFilePathOut = *ObjectFilePath;
+  else
+    llvm::outs() << "Check generated assembly with: /usr/bin/objdump -d "
+                 << *ObjectFilePath << "\n";
   const FunctionExecutorImpl Executor(State, getObjectFromFile(*ObjectFilePath),
-                                      Scratch.get());
+                                      &W);
   auto Measurements = runMeasurements(Executor);
   if (llvm::Error E = Measurements.takeError()) {
     InstrBenchmark.Error = llvm::toString(std::move(E));
@@ -21,6 +21,8 @@
 #include "BenchmarkResult.h"
 #include "LlvmState.h"
 #include "MCInstrDescView.h"
+#include "PerfHelper.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/MC/MCInst.h"
 #include "llvm/Support/Error.h"
 #include <cstdlib>
@@ -48,6 +50,17 @@ public:
   InstructionBenchmark runConfiguration(const BenchmarkCode &Configuration,
                                         unsigned NumRepetitions) const;
 
+  // Runs the configurations concurrently on worker threads, one pinned to each
+  // of `Cpus`, and passes the results to `Consumer` on the calling thread, in
+  // the order of the configurations. Each worker keeps its perf counters and
+  // code pages for all the configurations it runs. The cpus should be isolated
+  // (e.g. with `isolcpus=`), and not share a core with each other, for the
+  // measurements to be as stable as when running one configuration at a time.
+  llvm::Error runConfigurations(
+      llvm::ArrayRef<BenchmarkCode> Configurations, unsigned NumRepetitions,
+      llvm::ArrayRef<unsigned> Cpus,
+      llvm::function_ref<llvm::Error(InstructionBenchmark &)> Consumer) const;
+
   // Scratch space to run instructions that touch memory.
   struct ScratchSpace {
     static constexpr const size_t kAlignment = 1024;
@@ -65,6 +78,14 @@ public:
     char *const AlignedPtr;
   };
 
+  // The state of a thread that runs benchmarks, which is reused from one
+  // configuration to the next.
+  struct Worker {
+    ScratchSpace Scratch;
+    pfm::CounterCache Counters;
+    ExecutableMemoryPool CodeMemory;
+  };
+
   // A helper to measure counters while executing a function in a sandboxed
   // context.
   class FunctionExecutor {
@@ -81,13 +102,20 @@ private:
   virtual llvm::Expected<std::vector<BenchmarkMeasure>>
   runMeasurements(const FunctionExecutor &Executor) const = 0;
 
+  // Prints the path of the object file that is measured, or, when
+  // `ObjectFilePathOut` is set, returns it there for the caller to print.
+  InstructionBenchmark runConfiguration(const BenchmarkCode &Configuration,
+                                        unsigned NumRepetitions, Worker &W,
+                                        std::string *ObjectFilePathOut) const;
+
   llvm::Expected<std::string>
   writeObjectFile(const BenchmarkCode &Configuration,
                   llvm::ArrayRef<llvm::MCInst> Code) const;
 
   const InstructionBenchmark::ModeE Mode;
 
-  const std::unique_ptr<ScratchSpace> Scratch;
+  // The state used by runConfiguration on the calling thread.
+  const std::unique_ptr<Worker> MainWorker;
 };
 
 } // namespace exegesis
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "PerfHelper.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/raw_ostream.h"
 #ifdef HAVE_LIBPFM
@@ -107,7 +108,10 @@ Counter::Counter(const PerfEvent &Event) {
 
 Counter::~Counter() { close(FileDescriptor); }
 
-void Counter::start() { ioctl(FileDescriptor, PERF_EVENT_IOC_RESET, 0); }
+void Counter::start() {
+  ioctl(FileDescriptor, PERF_EVENT_IOC_RESET, 0);
+  ioctl(FileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+}
 
 void Counter::stop() { ioctl(FileDescriptor, PERF_EVENT_IOC_DISABLE, 0); }
 
@@ -135,6 +139,16 @@ int64_t Counter::read() const { return 42; }
 
 #endif
 
+Counter *CounterCache::getCounter(llvm::StringRef PfmEventString) {
+  std::unique_ptr<Entry> &E = Entries[PfmEventString];
+  if (!E) {
+    E.reset(new Entry{PerfEvent(PfmEventString), nullptr});
+    if (E->Event.valid())
+      E->Cnt = llvm::make_unique<Counter>(E->Event);
+  }
+  return E->Cnt.get();
+}
+
 } // namespace pfm
 } // namespace exegesis
 } // namespace llvm
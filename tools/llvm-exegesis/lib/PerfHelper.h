@@ -16,6 +16,7 @@
 #define LLVM_TOOLS_LLVM_EXEGESIS_PERFHELPER_H
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include <functional>
@@ -73,7 +74,7 @@ struct Counter {
 
   ~Counter();
 
-  void start();         // Starts the measurement of the event.
+  void start();         // Resets the counter and starts the measurement.
   void stop();          // Stops the measurement of the event.
   int64_t read() const; // Return the current value of the counter.
 
@@ -83,6 +84,23 @@ private:
 #endif
 };
 
+// Keeps the counters of a thread open between measurements, so that they are
+// not reopened for every run. The counters measure the thread that first asks
+// for them, so each thread needs its own cache.
+class CounterCache {
+public:
+  // Returns the counter for the event named PfmEventString, opening it the
+  // first time, or nullptr if the event is not valid.
+  Counter *getCounter(llvm::StringRef PfmEventString);
+
+private:
+  struct Entry {
+    PerfEvent Event;
+    std::unique_ptr<Counter> Cnt;
+  };
+  llvm::StringMap<std::unique_ptr<Entry>> Entries;
+};
+
 // Helper to measure a list of PerfEvent for a particular function.
 // callback is called for each successful measure (PerfEvent needs to be valid).
 template <typename Function>
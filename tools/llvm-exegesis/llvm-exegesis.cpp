@@ -73,6 +73,12 @@ static cl::opt<unsigned>
                    cl::desc("number of time to repeat the asm snippet"),
                    cl::init(10000));
 
+static cl::list<unsigned> BenchmarkCpus(
+    "benchmark-cpus",
+    cl::desc("comma-separated list of cpus to run benchmarks on concurrently, "
+             "one worker per cpu; they should be isolated"),
+    cl::CommaSeparated);
+
 static cl::opt<bool> IgnoreInvalidSchedClass(
     "ignore-invalid-sched-class",
     cl::desc("ignore instructions that do not define a sched class"),
@@ -369,10 +375,19 @@ void benchmarkMain() {
   if (BenchmarkFile.empty())
     BenchmarkFile = "-";
 
-  for (const BenchmarkCode &Conf : Configurations) {
-    InstructionBenchmark Result =
-        Runner->runConfiguration(Conf, NumRepetitions);
-    ExitOnErr(Result.writeYaml(State, BenchmarkFile));
+  if (BenchmarkCpus.empty()) {
+    for (const BenchmarkCode &Conf : Configurations) {
+      InstructionBenchmark Result =
+          Runner->runConfiguration(Conf, NumRepetitions);
+      ExitOnErr(Result.writeYaml(State, BenchmarkFile));
+    }
+  } else {
+    if (llvm::Error E = Runner->runConfigurations(
+            Configurations, NumRepetitions, BenchmarkCpus,
+            [&State](InstructionBenchmark &Result) {
+              return Result.writeYaml(State, BenchmarkFile);
+            }))
+      llvm::report_fatal_error(std::move(E));
   }
   exegesis::pfm::pfmTerminate();
 }
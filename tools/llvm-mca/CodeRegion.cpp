@@ -52,6 +52,17 @@ void CodeRegions::endRegion(llvm::SMLoc Loc) {
   CurrentRegion.setEndLocation(Loc);
 }
 
+CodeRegion &CodeRegions::addBlock(llvm::StringRef Description) {
+  assert(!Regions.empty() && "Missing Default region");
+  // Blocks replace the default region, which is only used for assembly code
+  // without region markers.
+  const CodeRegion &FirstRegion = *Regions.front();
+  if (!FirstRegion.startLoc().isValid() && !FirstRegion.hasAddressRange())
+    Regions.erase(Regions.begin());
+  addRegion(Description, llvm::SMLoc());
+  return *Regions.back();
+}
+
 void CodeRegions::addInstruction(const llvm::MCInst &Instruction) {
   const llvm::SMLoc &Loc = Instruction.getLoc();
   const auto It =
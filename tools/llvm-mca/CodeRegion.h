@@ -28,6 +28,10 @@
 ///
 /// An instruction (a MCInst) is added to a region R only if its location is in
 /// range [R.RangeStart, R.RangeEnd].
+///
+/// Regions can also be blocks of machine code disassembled from an object
+/// file. Those are identified by an address range instead, and optionally
+/// carry the number of times the block was executed according to a profile.
 //
 //===----------------------------------------------------------------------===//
 
@@ -39,6 +43,7 @@
 #include "llvm/MC/MCInst.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include <cstdint>
 #include <vector>
 
 namespace llvm {
@@ -55,13 +60,20 @@ class CodeRegion {
   // Source location range.
   llvm::SMLoc RangeStart;
   llvm::SMLoc RangeEnd;
+  // Address range and execution count of a block from an object file.
+  bool HasAddressRange;
+  uint64_t StartAddress;
+  uint64_t EndAddress;
+  uint64_t ExecutionCount;
 
   CodeRegion(const CodeRegion &) = delete;
   CodeRegion &operator=(const CodeRegion &) = delete;
 
 public:
   CodeRegion(llvm::StringRef Desc, llvm::SMLoc Start)
-      : Description(Desc), RangeStart(Start), RangeEnd() {}
+      : Description(Desc), RangeStart(Start), RangeEnd(),
+        HasAddressRange(false), StartAddress(0), EndAddress(0),
+        ExecutionCount(0) {}
 
   void addInstruction(const llvm::MCInst &Instruction) {
     Instructions.emplace_back(Instruction);
@@ -71,6 +83,17 @@ public:
   llvm::SMLoc endLoc() const { return RangeEnd; }
 
   void setEndLocation(llvm::SMLoc End) { RangeEnd = End; }
+  void setAddressRange(uint64_t Start, uint64_t End) {
+    HasAddressRange = true;
+    StartAddress = Start;
+    EndAddress = End;
+  }
+  void setExecutionCount(uint64_t Count) { ExecutionCount = Count; }
+
+  bool hasAddressRange() const { return HasAddressRange; }
+  uint64_t getStartAddress() const { return StartAddress; }
+  uint64_t getEndAddress() const { return EndAddress; }
+  uint64_t getExecutionCount() const { return ExecutionCount; }
   bool empty() const { return Instructions.empty(); }
   bool isLocInRange(llvm::SMLoc Loc) const;
 
@@ -105,6 +128,8 @@ public:
 
   void beginRegion(llvm::StringRef Description, llvm::SMLoc Loc);
   void endRegion(llvm::SMLoc Loc);
+  // Add a region for a block of machine code that is not read from assembly.
+  CodeRegion &addBlock(llvm::StringRef Description);
   void addInstruction(const llvm::MCInst &Instruction);
   llvm::SourceMgr &getSourceMgr() const { return SM; }
 
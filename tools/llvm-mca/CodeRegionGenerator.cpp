@@ -16,7 +16,9 @@
 
 #include "CodeRegionGenerator.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCTargetOptions.h"
@@ -133,5 +135,113 @@ Expected<const CodeRegions &> AsmCodeRegionGenerator::parseCodeRegions() {
   return Regions;
 }
 
+static Error createBlockError(const Twine &Message) {
+  return make_error<StringError>(Message, inconvertibleErrorCode());
+}
+
+static bool parseAddress(StringRef Str, uint64_t &Address) {
+  Str = Str.trim();
+  if (!Str.consume_front("0x"))
+    Str.consume_front("0X");
+  return !Str.empty() && !Str.getAsInteger(16, Address);
+}
+
+Expected<BlockRange> parseBlockRange(StringRef Spec) {
+  StringRef Range, Count;
+  std::tie(Range, Count) = Spec.trim().split(':');
+  StringRef Start, End;
+  std::tie(Start, End) = Range.split('-');
+
+  BlockRange Block = {0, 0, 0};
+  if (!parseAddress(Start, Block.StartAddress) ||
+      !parseAddress(End, Block.EndAddress) ||
+      Block.EndAddress < Block.StartAddress ||
+      (!Count.empty() && Count.trim().getAsInteger(10, Block.ExecutionCount)))
+    return createBlockError("invalid block range '" + Spec.trim() + "'");
+  return Block;
+}
+
+Error parseBlockProfile(StringRef Buffer, std::vector<BlockRange> &Blocks) {
+  SmallVector<StringRef, 0> Lines;
+  Buffer.split(Lines, '\n');
+  for (unsigned I = 0, E = Lines.size(); I != E; ++I) {
+    StringRef Line = Lines[I].trim();
+    if (Line.empty() || Line.startswith("#") || Line.contains("->"))
+      continue;
+
+    if (!Line.contains('-')) {
+      // The number of entries that follow, or the count of an address.
+      StringRef Address, Count;
+      std::tie(Address, Count) = Line.split(':');
+      uint64_t Value;
+      if (Count.empty() ? !Address.getAsInteger(10, Value)
+                        : parseAddress(Address, Value) &&
+                              !Count.trim().getAsInteger(10, Value))
+        continue;
+      return createBlockError("line " + Twine(I + 1) +
+                              ": invalid profile entry '" + Line + "'");
+    }
+
+    Expected<BlockRange> Block = parseBlockRange(Line);
+    if (!Block)
+      return createBlockError("line " + Twine(I + 1) + ": " +
+                              toString(Block.takeError()));
+    Blocks.push_back(*Block);
+  }
+  return Error::success();
+}
+
+Error ObjectCodeRegionGenerator::addBlock(const BlockRange &Block) {
+  std::string Name = "0x" + utohexstr(Block.StartAddress, /*LowerCase=*/true) +
+                     "-0x" + utohexstr(Block.EndAddress, /*LowerCase=*/true);
+
+  for (const object::SectionRef &Section : Obj.sections()) {
+    uint64_t SectionStart = Section.getAddress();
+    uint64_t SectionEnd = SectionStart + Section.getSize();
+    if (!Section.isText() || Block.StartAddress < SectionStart ||
+        Block.StartAddress >= SectionEnd)
+      continue;
+
+    StringRef Contents;
+    if (std::error_code EC = Section.getContents(Contents))
+      return errorCodeToError(EC);
+    ArrayRef<uint8_t> Bytes(reinterpret_cast<const uint8_t *>(Contents.data()),
+                            Contents.size());
+
+    CodeRegion &Region = Regions.addBlock(Saver.save(Name));
+    Region.setAddressRange(Block.StartAddress, Block.EndAddress);
+    Region.setExecutionCount(Block.ExecutionCount);
+
+    // The end address is that of the last instruction in the block.
+    uint64_t Address = Block.StartAddress;
+    while (Address <= Block.EndAddress) {
+      if (Address >= SectionEnd)
+        return createBlockError("block " + Name +
+                                " extends past the end of its section");
+      MCInst Inst;
+      uint64_t Size;
+      if (DisAsm.getInstruction(Inst, Size, Bytes.slice(Address - SectionStart),
+                                Address, nulls(),
+                                nulls()) != MCDisassembler::Success)
+        return createBlockError("invalid instruction encoding at address 0x" +
+                                utohexstr(Address, /*LowerCase=*/true) +
+                                " in block " + Name);
+      Region.addInstruction(Inst);
+      Address += Size;
+    }
+    return Error::success();
+  }
+
+  return createBlockError("block " + Name +
+                          " is not in a text section of the input file");
+}
+
+Expected<const CodeRegions &> ObjectCodeRegionGenerator::parseCodeRegions() {
+  for (const BlockRange &Block : Blocks)
+    if (Error Err = addBlock(Block))
+      return std::move(Err);
+  return Regions;
+}
+
 } // namespace mca
 } // namespace llvm
@@ -20,11 +20,15 @@
 #include "CodeRegion.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetRegistry.h"
 #include <memory>
+#include <vector>
 
 namespace llvm {
 namespace mca {
@@ -41,6 +45,9 @@ public:
   CodeRegionGenerator(SourceMgr &SM) : Regions(SM) {}
   virtual ~CodeRegionGenerator();
   virtual Expected<const CodeRegions &> parseCodeRegions() = 0;
+
+  /// The assembly dialect to use by default when printing instructions.
+  virtual unsigned getAssemblerDialect() const { return 0; }
 };
 
 /// This class is responsible for parsing input ASM and generating
@@ -60,7 +67,52 @@ public:
       : CodeRegionGenerator(SM), TheTarget(T), Ctx(C), MAI(A), STI(S), MCII(I),
         AssemblerDialect(0) {}
 
-  unsigned getAssemblerDialect() const { return AssemblerDialect; }
+  unsigned getAssemblerDialect() const override { return AssemblerDialect; }
+  Expected<const CodeRegions &> parseCodeRegions() override;
+};
+
+/// A block of machine code in an object file, and the number of times it was
+/// executed. Both ends of the address range are inclusive: EndAddress is the
+/// address of the last instruction of the block, as in the range counts
+/// collected by perf and AutoFDO.
+struct BlockRange {
+  uint64_t StartAddress;
+  uint64_t EndAddress;
+  uint64_t ExecutionCount;
+};
+
+/// Parses a block range of the form "<start>-<end>[:<count>]", where the
+/// addresses are hexadecimal (with or without a 0x prefix) and the count is
+/// decimal.
+Expected<BlockRange> parseBlockRange(StringRef Spec);
+
+/// Parses a profile of block ranges: one "<start>-<end>:<count>" entry per
+/// line. This is the format of the range counts in the text profiles written
+/// by AutoFDO. Entry counts, branch counts ("<from>-><to>:<count>") and
+/// address counts ("<address>:<count>") in the same file are skipped, as are
+/// empty lines and lines that start with '#'.
+Error parseBlockProfile(StringRef Buffer, std::vector<BlockRange> &Blocks);
+
+/// This class is responsible for disassembling blocks of machine code from an
+/// object file, and generating a CodeRegions instance with one region per
+/// block.
+class ObjectCodeRegionGenerator final : public CodeRegionGenerator {
+  const object::ObjectFile &Obj;
+  const MCDisassembler &DisAsm;
+  ArrayRef<BlockRange> Blocks;
+  // Owns the descriptions of the regions.
+  BumpPtrAllocator Alloc;
+  StringSaver Saver;
+
+  Error addBlock(const BlockRange &Block);
+
+public:
+  ObjectCodeRegionGenerator(SourceMgr &SM, const object::ObjectFile &O,
+                            const MCDisassembler &D,
+                            ArrayRef<BlockRange> BlockRanges)
+      : CodeRegionGenerator(SM), Obj(O), DisAsm(D), Blocks(BlockRanges),
+        Saver(Alloc) {}
+
   Expected<const CodeRegions &> parseCodeRegions() override;
 };
 
@@ -0,0 +1,70 @@
+//===--------------------- SteadyStateDetector.cpp --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file implements the SteadyStateDetector interface.
+///
+//===----------------------------------------------------------------------===//
+
+#include "SteadyStateDetector.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace llvm {
+namespace mca {
+
+bool SteadyStateDetector::hasConverged() const {
+  if (IterationCycles.size() < 2 * WindowSize)
+    return false;
+
+  // Compare the sums rather than the individual iterations: a loop whose
+  // throughput is not a whole number of cycles per iteration alternates
+  // between two different iteration latencies forever.
+  unsigned Previous = 0;
+  unsigned Latest = 0;
+  auto It = IterationCycles.end() - 2 * WindowSize;
+  for (unsigned I = 0; I < WindowSize; ++I)
+    Previous += *It++;
+  for (unsigned I = 0; I < WindowSize; ++I)
+    Latest += *It++;
+  if (std::max(Latest, Previous) - std::min(Latest, Previous) > 1)
+    return false;
+
+  // The views report averages over all the simulated cycles, which include
+  // the time it took to fill the pipeline. Keep going until that start-up
+  // cost is amortized to within 1% of the steady-state cycles.
+  uint64_t SteadyCycles = uint64_t(RetiredIterations) * Latest;
+  uint64_t ElapsedCycles = uint64_t(LastRetireCycle) * WindowSize;
+  return ElapsedCycles <= SteadyCycles ||
+         100 * (ElapsedCycles - SteadyCycles) <= SteadyCycles;
+}
+
+void SteadyStateDetector::onEvent(const HWInstructionEvent &Event) {
+  if (Converged || Event.Type != HWInstructionEvent::Retired)
+    return;
+
+  // Instructions retire in program order, so the last instruction of an
+  // iteration retiring means that the whole iteration has retired.
+  if ((Event.IR.getSourceIndex() + 1) % SM.size())
+    return;
+
+  // The first iteration includes the time it takes to fill the pipeline.
+  if (RetiredIterations++)
+    IterationCycles.push_back(CurrentCycle - LastRetireCycle);
+  LastRetireCycle = CurrentCycle;
+
+  if (RetiredIterations < MinIterations || !hasConverged())
+    return;
+
+  Converged = true;
+  SM.stopAfterCurrentIteration();
+}
+
+} // namespace mca
+} // namespace llvm
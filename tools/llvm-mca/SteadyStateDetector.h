@@ -0,0 +1,63 @@
+//===--------------------- SteadyStateDetector.h ----------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+/// \file
+///
+/// This file defines class SteadyStateDetector, an event listener that stops
+/// the simulation once the throughput of the code region has converged.
+///
+/// The detector records how many cycles each iteration of the code region
+/// adds to the simulation, measured between the retirement of the last
+/// instruction of consecutive iterations. Once the cycles taken by the most
+/// recent window of iterations match those taken by the window before it, the
+/// pipeline is considered to be in a steady state. The simulation then goes on
+/// until the cycles spent filling the pipeline no longer skew the averages
+/// that the views report. The source manager is told to stop at the end of
+/// the iteration being fetched, so that the views report a whole number of
+/// iterations.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_LLVM_MCA_STEADYSTATEDETECTOR_H
+#define LLVM_TOOLS_LLVM_MCA_STEADYSTATEDETECTOR_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/MCA/HWEventListener.h"
+#include "llvm/MCA/SourceMgr.h"
+
+namespace llvm {
+namespace mca {
+
+class SteadyStateDetector : public HWEventListener {
+  SourceMgr &SM;
+  // Never stop before this many iterations have retired.
+  unsigned MinIterations;
+  unsigned CurrentCycle;
+  unsigned LastRetireCycle;
+  unsigned RetiredIterations;
+  bool Converged;
+  // Cycles taken by each retired iteration.
+  SmallVector<unsigned, 64> IterationCycles;
+
+  // Number of iterations in each of the two windows that are compared.
+  static const unsigned WindowSize = 8;
+
+  bool hasConverged() const;
+
+public:
+  SteadyStateDetector(SourceMgr &S, unsigned MinIters)
+      : SM(S), MinIterations(MinIters), CurrentCycle(0), LastRetireCycle(0),
+        RetiredIterations(0), Converged(false) {}
+
+  void onCycleEnd() override { ++CurrentCycle; }
+  void onEvent(const HWInstructionEvent &Event) override;
+};
+} // namespace mca
+} // namespace llvm
+
+#endif // LLVM_TOOLS_LLVM_MCA_STEADYSTATEDETECTOR_H
@@ -87,5 +87,25 @@ void SummaryView::printView(raw_ostream &OS) const {
   TempStream.flush();
   OS << Buffer;
 }
+
+json::Value SummaryView::toJSON() const {
+  unsigned Instructions = Source.size();
+  unsigned Iterations = (LastInstructionIdx / Instructions) + 1;
+  unsigned TotalInstructions = Instructions * Iterations;
+  unsigned TotalUOps = NumMicroOps * Iterations;
+  double BlockRThroughput = computeBlockRThroughput(
+      SM, DispatchWidth, NumMicroOps, ProcResourceUsage);
+
+  return json::Object{
+      {"iterations", Iterations},
+      {"instructions", TotalInstructions},
+      {"cycles", TotalCycles},
+      {"uops", TotalUOps},
+      {"dispatch_width", DispatchWidth},
+      {"uops_per_cycle", (double)TotalUOps / TotalCycles},
+      {"ipc", (double)TotalInstructions / TotalCycles},
+      {"block_rthroughput", BlockRThroughput},
+      {"cycles_per_iteration", (double)TotalCycles / Iterations}};
+}
 } // namespace mca.
 } // namespace llvm
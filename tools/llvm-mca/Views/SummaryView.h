@@ -70,6 +70,7 @@ public:
   void onEvent(const HWInstructionEvent &Event) override;
 
   void printView(llvm::raw_ostream &OS) const override;
+  json::Value toJSON() const override;
 };
 } // namespace mca
 } // namespace llvm
@@ -17,6 +17,7 @@
 #define LLVM_TOOLS_LLVM_MCA_VIEW_H
 
 #include "llvm/MCA/HWEventListener.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/raw_ostream.h"
 
 namespace llvm {
@@ -25,6 +26,9 @@ namespace mca {
 class View : public HWEventListener {
 public:
   virtual void printView(llvm::raw_ostream &OS) const = 0;
+  /// Returns the content of this view in a machine readable form, or null if
+  /// the view has no such form.
+  virtual json::Value toJSON() const { return nullptr; }
   virtual ~View() = default;
   void anchor() override;
 };
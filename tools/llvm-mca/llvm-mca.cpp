@@ -24,6 +24,7 @@
 #include "CodeRegion.h"
 #include "CodeRegionGenerator.h"
 #include "PipelinePrinter.h"
+#include "SteadyStateDetector.h"
 #include "Views/DispatchStatistics.h"
 #include "Views/InstructionInfoView.h"
 #include "Views/RegisterFileStatistics.h"
@@ -32,8 +33,10 @@
 #include "Views/SchedulerStatistics.h"
 #include "Views/SummaryView.h"
 #include "Views/TimelineView.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include "llvm/MC/MCObjectFileInfo.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MCA/Context.h"
@@ -41,16 +44,20 @@
 #include "llvm/MCA/Stages/EntryStage.h"
 #include "llvm/MCA/Stages/InstructionTables.h"
 #include "llvm/MCA/Support.h"
+#include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 
@@ -91,6 +98,18 @@ static cl::opt<unsigned> Iterations("iterations",
                                     cl::desc("Number of iterations to run"),
                                     cl::cat(ToolOptions), cl::init(0));
 
+static cl::opt<bool> SteadyState(
+    "steady-state",
+    cl::desc("Stop simulating a code region once its throughput has "
+             "converged, instead of after the requested number of iterations"),
+    cl::cat(ToolOptions), cl::init(false));
+
+static cl::opt<unsigned>
+    NumThreads("num-threads",
+               cl::desc("Number of threads used to simulate code regions "
+                        "(0 = one per hardware thread)"),
+               cl::cat(ToolOptions), cl::init(0));
+
 static cl::opt<unsigned>
     DispatchWidth("dispatch", cl::desc("Override the processor dispatch width"),
                   cl::cat(ToolOptions), cl::init(0));
@@ -176,6 +195,33 @@ static cl::opt<bool>
                    cl::desc("Print all views including hardware statistics"),
                    cl::cat(ViewOptions), cl::init(false));
 
+static cl::opt<bool>
+    InputIsObject("object",
+                  cl::desc("The input is an object file to disassemble the "
+                           "blocks selected with -block and -block-profile "
+                           "from"),
+                  cl::cat(ToolOptions), cl::init(false));
+
+static cl::list<std::string>
+    BlockRanges("block",
+                cl::desc("Analyze the block of machine code from <start> to "
+                         "the instruction at <end>, executed <count> times "
+                         "(requires -object)"),
+                cl::value_desc("<start>-<end>[:<count>]"), cl::CommaSeparated,
+                cl::cat(ToolOptions));
+
+static cl::opt<std::string>
+    BlockProfile("block-profile",
+                 cl::desc("Analyze the blocks listed in a profile of address "
+                          "range counts (requires -object)"),
+                 cl::value_desc("filename"), cl::cat(ToolOptions));
+
+static cl::opt<bool>
+    PrintJSON("json",
+              cl::desc("Print the summary of each code region as a line of "
+                       "JSON instead of printing the views"),
+              cl::cat(ViewOptions), cl::init(false));
+
 namespace {
 
 const Target *getTarget(const char *ProgName) {
@@ -214,6 +260,19 @@ static void processOptionImpl(cl::opt<bool> &O, const cl::opt<bool> &Default) {
 }
 
 static void processViewOptions() {
+  // Only the summary of each region is printed as JSON.
+  if (PrintJSON) {
+    PrintSummaryView = true;
+    PrintInstructionInfoView = false;
+    PrintDispatchStats = false;
+    PrintSchedulerStats = false;
+    PrintRetireStats = false;
+    PrintRegisterFileStats = false;
+    PrintResourcePressureView = false;
+    PrintTimelineView = false;
+    return;
+  }
+
   if (!EnableAllViews.getNumOccurrences() &&
       !EnableAllStats.getNumOccurrences())
     return;
@@ -235,15 +294,87 @@ static void processViewOptions() {
   processOptionImpl(PrintRetireStats, Default);
 }
 
-// Returns true on success.
-static bool runPipeline(mca::Pipeline &P) {
-  // Handle pipeline errors here.
+static Error runPipeline(mca::Pipeline &P) {
   Expected<unsigned> Cycles = P.run();
-  if (!Cycles) {
-    WithColor::error() << toString(Cycles.takeError());
-    return false;
+  if (!Cycles)
+    return Cycles.takeError();
+  return Error::success();
+}
+
+namespace {
+
+// The state of the analysis of one code region.
+struct RegionSimulation {
+  const mca::CodeRegion &Region;
+  mca::InstrBuilder IB;
+  // Controls the ownership of the pipeline hardware.
+  mca::Context MCA;
+  std::vector<std::unique_ptr<mca::Instruction>> LoweredSequence;
+  std::unique_ptr<mca::SourceMgr> S;
+  std::unique_ptr<mca::Pipeline> P;
+  std::unique_ptr<mca::PipelinePrinter> Printer;
+  std::unique_ptr<mca::SteadyStateDetector> Detector;
+  // The summary view of the region, if any.
+  const mca::SummaryView *Summary = nullptr;
+  // Set once the region has been simulated.
+  Optional<Error> Err;
+
+  RegionSimulation(const mca::CodeRegion &R, const MCSubtargetInfo &STI,
+                   const MCInstrInfo &MCII, const MCRegisterInfo &MRI,
+                   const MCInstrAnalysis *MCIA)
+      : Region(R), IB(STI, MCII, MRI, MCIA), MCA(MRI, STI) {}
+};
+
+} // end of anonymous namespace
+
+// Lower the MCInst sequence of a region into an mca::Instruction sequence.
+static Error lowerRegion(RegionSimulation &R) {
+  for (const MCInst &MCI : R.Region.getInstructions()) {
+    Expected<std::unique_ptr<mca::Instruction>> Inst =
+        R.IB.createInstruction(MCI);
+    if (!Inst)
+      return Inst.takeError();
+    R.LoweredSequence.emplace_back(std::move(Inst.get()));
+  }
+  return Error::success();
+}
+
+// Print the summary of a region as a single line of JSON.
+static void printJSON(raw_ostream &OS, unsigned RegionIdx,
+                      const RegionSimulation &R) {
+  json::Object Result{{"region", RegionIdx},
+                      {"name", R.Region.getDescription()}};
+  json::Value Summary = R.Summary->toJSON();
+  if (R.Region.hasAddressRange()) {
+    Result["start"] =
+        "0x" + utohexstr(R.Region.getStartAddress(), /*LowerCase=*/true);
+    Result["end"] =
+        "0x" + utohexstr(R.Region.getEndAddress(), /*LowerCase=*/true);
+    if (uint64_t Count = R.Region.getExecutionCount()) {
+      Result["count"] = int64_t(Count);
+      Result["weighted_cycles"] =
+          Count * *Summary.getAsObject()->getNumber("cycles_per_iteration");
+    }
+  }
+  Result["summary"] = std::move(Summary);
+  OS << json::Value(std::move(Result)) << '\n';
+}
+
+static void reportError(Error Err, MCInstPrinter &IP,
+                        const MCSubtargetInfo &STI) {
+  if (auto NewE = handleErrors(
+          std::move(Err),
+          [&IP, &STI](const mca::InstructionError<MCInst> &IE) {
+            std::string InstructionStr;
+            raw_string_ostream SS(InstructionStr);
+            WithColor::error() << IE.Message << '\n';
+            IP.printInst(&IE.Inst, SS, "", STI);
+            SS.flush();
+            WithColor::note() << "instruction: " << InstructionStr << '\n';
+          })) {
+    // Default case.
+    WithColor::error() << toString(std::move(NewE));
   }
-  return true;
 }
 
 int main(int argc, char **argv) {
@@ -253,6 +384,7 @@ int main(int argc, char **argv) {
   InitializeAllTargetInfos();
   InitializeAllTargetMCs();
   InitializeAllAsmParsers();
+  InitializeAllDisassemblers();
 
   // Enable printing of available targets when flag --version is specified.
   cl::AddExtraVersionPrinter(TargetRegistry::printRegisteredTargetsForVersion);
@@ -263,17 +395,15 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv,
                               "llvm machine code performance analyzer.\n");
 
-  // Get the target from the triple. If a triple is not specified, then select
-  // the default triple for the host. If the triple doesn't correspond to any
-  // registered target, then exit with an error message.
-  const char *ProgName = argv[0];
-  const Target *TheTarget = getTarget(ProgName);
-  if (!TheTarget)
+  if (!InputIsObject && (!BlockRanges.empty() || !BlockProfile.empty())) {
+    WithColor::error() << "-block and -block-profile require -object.\n";
     return 1;
+  }
 
-  // GetTarget() may replaced TripleName with a default triple.
-  // For safety, reconstruct the Triple object.
-  Triple TheTriple(TripleName);
+  if (PrintJSON && PrintInstructionTables) {
+    WithColor::error() << "-json can't be used with -instruction-tables.\n";
+    return 1;
+  }
 
   ErrorOr<std::unique_ptr<MemoryBuffer>> BufferPtr =
       MemoryBuffer::getFileOrSTDIN(InputFilename);
@@ -282,14 +412,67 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  // Apply overrides to llvm-mca specific options.
-  processViewOptions();
-
   SourceMgr SrcMgr;
 
   // Tell SrcMgr about this buffer, which is what the parser will pick up.
   SrcMgr.AddNewSourceBuffer(std::move(*BufferPtr), SMLoc());
 
+  std::unique_ptr<object::ObjectFile> Obj;
+  std::vector<mca::BlockRange> Blocks;
+  if (InputIsObject) {
+    MemoryBufferRef ObjBuffer =
+        SrcMgr.getMemoryBuffer(SrcMgr.getMainFileID())->getMemBufferRef();
+    Expected<std::unique_ptr<object::ObjectFile>> ObjOrErr =
+        object::ObjectFile::createObjectFile(ObjBuffer);
+    if (!ObjOrErr) {
+      WithColor::error() << InputFilename << ": "
+                         << toString(ObjOrErr.takeError()) << '\n';
+      return 1;
+    }
+    Obj = std::move(*ObjOrErr);
+    if (TripleName.empty())
+      TripleName = Obj->makeTriple().getTriple();
+
+    for (StringRef Spec : BlockRanges) {
+      Expected<mca::BlockRange> Block = mca::parseBlockRange(Spec);
+      if (!Block) {
+        WithColor::error() << toString(Block.takeError()) << '\n';
+        return 1;
+      }
+      Blocks.push_back(*Block);
+    }
+
+    if (!BlockProfile.empty()) {
+      ErrorOr<std::unique_ptr<MemoryBuffer>> ProfileOrErr =
+          MemoryBuffer::getFile(BlockProfile);
+      if (std::error_code EC = ProfileOrErr.getError()) {
+        WithColor::error() << BlockProfile << ": " << EC.message() << '\n';
+        return 1;
+      }
+      if (Error Err = mca::parseBlockProfile((*ProfileOrErr)->getBuffer(),
+                                             Blocks)) {
+        WithColor::error() << BlockProfile << ": " << toString(std::move(Err))
+                           << '\n';
+        return 1;
+      }
+    }
+  }
+
+  // Get the target from the triple. If a triple is not specified, then select
+  // the default triple for the host. If the triple doesn't correspond to any
+  // registered target, then exit with an error message.
+  const char *ProgName = argv[0];
+  const Target *TheTarget = getTarget(ProgName);
+  if (!TheTarget)
+    return 1;
+
+  // GetTarget() may replaced TripleName with a default triple.
+  // For safety, reconstruct the Triple object.
+  Triple TheTriple(TripleName);
+
+  // Apply overrides to llvm-mca specific options.
+  processViewOptions();
+
   std::unique_ptr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
   assert(MRI && "Unable to create target register info!");
 
@@ -335,8 +518,23 @@ int main(int argc, char **argv) {
   }
 
   // Parse the input and create CodeRegions that llvm-mca can analyze.
-  mca::AsmCodeRegionGenerator CRG(*TheTarget, SrcMgr, Ctx, *MAI, *STI, *MCII);
-  Expected<const mca::CodeRegions &> RegionsOrErr = CRG.parseCodeRegions();
+  std::unique_ptr<MCDisassembler> DisAsm;
+  std::unique_ptr<mca::CodeRegionGenerator> CRG;
+  if (InputIsObject) {
+    DisAsm.reset(TheTarget->createMCDisassembler(*STI, Ctx));
+    if (!DisAsm) {
+      WithColor::error()
+          << "unable to create a disassembler for target triple '"
+          << TheTriple.normalize() << "'.\n";
+      return 1;
+    }
+    CRG = llvm::make_unique<mca::ObjectCodeRegionGenerator>(SrcMgr, *Obj,
+                                                            *DisAsm, Blocks);
+  } else {
+    CRG = llvm::make_unique<mca::AsmCodeRegionGenerator>(
+        *TheTarget, SrcMgr, Ctx, *MAI, *STI, *MCII);
+  }
+  Expected<const mca::CodeRegions &> RegionsOrErr = CRG->parseCodeRegions();
   if (!RegionsOrErr) {
     if (auto Err =
             handleErrors(RegionsOrErr.takeError(), [](const StringError &E) {
@@ -349,7 +547,8 @@ int main(int argc, char **argv) {
   }
   const mca::CodeRegions &Regions = *RegionsOrErr;
   if (Regions.empty()) {
-    WithColor::error() << "no assembly instructions found.\n";
+    WithColor::error() << (InputIsObject ? "no blocks to analyze.\n"
+                                         : "no assembly instructions found.\n");
     return 1;
   }
 
@@ -360,7 +559,7 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  unsigned AssemblerDialect = CRG.getAssemblerDialect();
+  unsigned AssemblerDialect = CRG->getAssemblerDialect();
   if (OutputAsmVariant >= 0)
     AssemblerDialect = static_cast<unsigned>(OutputAsmVariant);
   std::unique_ptr<MCInstPrinter> IP(TheTarget->createMCInstPrinter(
@@ -381,90 +580,53 @@ int main(int argc, char **argv) {
   if (DispatchWidth)
     Width = DispatchWidth;
 
-  // Create an instruction builder.
-  mca::InstrBuilder IB(*STI, *MCII, *MRI, MCIA.get());
-
-  // Create a context to control ownership of the pipeline hardware.
-  mca::Context MCA(*MRI, *STI);
-
   mca::PipelineOptions PO(Width, RegisterFileSize, LoadQueueSize,
                           StoreQueueSize, AssumeNoAlias);
 
-  // Number each region in the sequence.
-  unsigned RegionIdx = 0;
-
-  for (const std::unique_ptr<mca::CodeRegion> &Region : Regions) {
-    // Skip empty code regions.
-    if (Region->empty())
-      continue;
-
-    // Don't print the header of this region if it is the default region, and
-    // it doesn't have an end location.
-    if (Region->startLoc().isValid() || Region->endLoc().isValid()) {
-      TOF->os() << "\n[" << RegionIdx++ << "] Code Region";
-      StringRef Desc = Region->getDescription();
-      if (!Desc.empty())
-        TOF->os() << " - " << Desc;
-      TOF->os() << "\n\n";
+  // Code regions are independent of each other. Each one is lowered and
+  // simulated with its own instruction builder and hardware units, so that
+  // they can run on a thread pool; the reports are then printed in order.
+  auto Simulate = [&](RegionSimulation &R) {
+    ArrayRef<MCInst> Insts = R.Region.getInstructions();
+    if (Error Err = lowerRegion(R)) {
+      R.Err.emplace(std::move(Err));
+      return;
     }
 
-    // Lower the MCInst sequence into an mca::Instruction sequence.
-    ArrayRef<MCInst> Insts = Region->getInstructions();
-    std::vector<std::unique_ptr<mca::Instruction>> LoweredSequence;
-    for (const MCInst &MCI : Insts) {
-      Expected<std::unique_ptr<mca::Instruction>> Inst =
-          IB.createInstruction(MCI);
-      if (!Inst) {
-        if (auto NewE = handleErrors(
-                Inst.takeError(),
-                [&IP, &STI](const mca::InstructionError<MCInst> &IE) {
-                  std::string InstructionStr;
-                  raw_string_ostream SS(InstructionStr);
-                  WithColor::error() << IE.Message << '\n';
-                  IP->printInst(&IE.Inst, SS, "", *STI);
-                  SS.flush();
-                  WithColor::note() << "instruction: " << InstructionStr
-                                    << '\n';
-                })) {
-          // Default case.
-          WithColor::error() << toString(std::move(NewE));
-        }
-        return 1;
-      }
-
-      LoweredSequence.emplace_back(std::move(Inst.get()));
-    }
-
-    mca::SourceMgr S(LoweredSequence, PrintInstructionTables ? 1 : Iterations);
+    R.S = llvm::make_unique<mca::SourceMgr>(
+        R.LoweredSequence, PrintInstructionTables ? 1 : Iterations);
 
     if (PrintInstructionTables) {
       //  Create a pipeline, stages, and a printer.
-      auto P = llvm::make_unique<mca::Pipeline>();
-      P->appendStage(llvm::make_unique<mca::EntryStage>(S));
-      P->appendStage(llvm::make_unique<mca::InstructionTables>(SM));
-      mca::PipelinePrinter Printer(*P);
+      R.P = llvm::make_unique<mca::Pipeline>();
+      R.P->appendStage(llvm::make_unique<mca::EntryStage>(*R.S));
+      R.P->appendStage(llvm::make_unique<mca::InstructionTables>(SM));
+      R.Printer = llvm::make_unique<mca::PipelinePrinter>(*R.P);
 
       // Create the views for this pipeline, execute, and emit a report.
       if (PrintInstructionInfoView) {
-        Printer.addView(llvm::make_unique<mca::InstructionInfoView>(
+        R.Printer->addView(llvm::make_unique<mca::InstructionInfoView>(
             *STI, *MCII, Insts, *IP));
       }
-      Printer.addView(
+      R.Printer->addView(
           llvm::make_unique<mca::ResourcePressureView>(*STI, *IP, Insts));
 
-      if (!runPipeline(*P))
-        return 1;
-
-      Printer.printReport(TOF->os());
-      continue;
+      R.Err.emplace(runPipeline(*R.P));
+      return;
     }
 
     // Create a basic pipeline simulating an out-of-order backend.
-    auto P = MCA.createDefaultPipeline(PO, IB, S);
-    mca::PipelinePrinter Printer(*P);
-
-    if (PrintSummaryView)
-      Printer.addView(llvm::make_unique<mca::SummaryView>(SM, Insts, Width));
+    R.P = R.MCA.createDefaultPipeline(PO, R.IB, *R.S);
+    R.Printer = llvm::make_unique<mca::PipelinePrinter>(*R.P);
+    mca::PipelinePrinter &Printer = *R.Printer;
+
+    // Only the views that are printed are attached to the pipeline, since
+    // every listener is notified of every event of every cycle.
+    if (PrintSummaryView) {
+      auto Summary = llvm::make_unique<mca::SummaryView>(SM, Insts, Width);
+      R.Summary = Summary.get();
+      Printer.addView(std::move(Summary));
+    }
 
     if (PrintInstructionInfoView)
       Printer.addView(
@@ -486,21 +648,85 @@ int main(int argc, char **argv) {
       Printer.addView(
           llvm::make_unique<mca::ResourcePressureView>(*STI, *IP, Insts));
 
+    unsigned TimelineIterations = 0;
     if (PrintTimelineView) {
-      unsigned TimelineIterations =
-          TimelineMaxIterations ? TimelineMaxIterations : 10;
+      TimelineIterations = TimelineMaxIterations ? TimelineMaxIterations : 10;
+      TimelineIterations =
+          std::min(TimelineIterations, R.S->getNumIterations());
       Printer.addView(llvm::make_unique<mca::TimelineView>(
-          *STI, *IP, Insts, std::min(TimelineIterations, S.getNumIterations()),
-          TimelineMaxCycles));
+          *STI, *IP, Insts, TimelineIterations, TimelineMaxCycles));
     }
 
-    if (!runPipeline(*P))
+    // The timeline view expects all of its iterations to be simulated.
+    if (SteadyState) {
+      R.Detector =
+          llvm::make_unique<mca::SteadyStateDetector>(*R.S, TimelineIterations);
+      R.P->addEventListener(R.Detector.get());
+    }
+
+    R.Err.emplace(runPipeline(*R.P));
+  };
+
+  std::vector<std::unique_ptr<RegionSimulation>> Simulations;
+  for (const std::unique_ptr<mca::CodeRegion> &Region : Regions) {
+    // Skip empty code regions.
+    if (!Region->empty())
+      Simulations.emplace_back(
+          llvm::make_unique<RegionSimulation>(*Region, *STI, *MCII, *MRI,
+                                              MCIA.get()));
+  }
+
+  unsigned Threads = NumThreads ? NumThreads : hardware_concurrency();
+  Threads = std::min<size_t>(Threads, Simulations.size());
+  Optional<ThreadPool> Pool;
+  std::vector<std::shared_future<void>> Pending;
+  if (Threads > 1) {
+    Pool.emplace(Threads);
+    for (std::unique_ptr<RegionSimulation> &R : Simulations)
+      Pending.push_back(Pool->async(Simulate, std::ref(*R)));
+  }
+
+  // Number each region in the sequence.
+  unsigned RegionIdx = 0;
+
+  for (unsigned I = 0, E = Simulations.size(); I != E; ++I) {
+    RegionSimulation &R = *Simulations[I];
+    if (Pool)
+      Pending[I].wait();
+    else
+      Simulate(R);
+
+    // Don't print the header of this region if it is the default region, and
+    // it doesn't have an end location.
+    bool HasHeader = R.Region.startLoc().isValid() ||
+                     R.Region.endLoc().isValid() || R.Region.hasAddressRange();
+    if (HasHeader && !PrintJSON) {
+      TOF->os() << "\n[" << RegionIdx++ << "] Code Region";
+      StringRef Desc = R.Region.getDescription();
+      if (!Desc.empty())
+        TOF->os() << " - " << Desc;
+      TOF->os() << "\n\n";
+    }
+
+    if (*R.Err) {
+      reportError(std::move(*R.Err), *IP, *STI);
+      // Wait for the regions that are still being simulated, and drop the
+      // results of the regions that follow.
+      if (Pool)
+        Pool->wait();
+      for (unsigned J = I + 1; J != E; ++J)
+        if (Simulations[J]->Err)
+          consumeError(std::move(*Simulations[J]->Err));
       return 1;
+    }
 
-    Printer.printReport(TOF->os());
+    if (PrintJSON)
+      printJSON(TOF->os(), I, R);
+    else
+      R.Printer->printReport(TOF->os());
 
-    // Clear the InstrBuilder internal state in preparation for another round.
-    IB.clear();
+    // Release the hardware units and the views of this region.
+    Simulations[I].reset();
   }
 
   TOF->keep();
@@ -22,6 +22,7 @@
 #include "llvm/IR/Function.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/ArchiveMemberCache.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/COFFImportFile.h"
 #include "llvm/Object/ELFObjectFile.h"
@@ -1768,9 +1769,14 @@ static void dumpSymbolNamesFromFile(std::string &Filename) {
     }
 
     {
+      ArchiveMemberCache Members(*A, &Context);
+      Members.preload(/*NumThreads=*/0,
+                      ArchiveMemberCache::DefaultPreloadWindow);
       Error Err = Error::success();
       for (auto &C : A->children(Err)) {
-        Expected<std::unique_ptr<Binary>> ChildOrErr = C.getAsBinary(&Context);
+        Expected<std::shared_ptr<Binary>> ChildOrErr = Members.getMember(C);
+        // ChildOrErr keeps the member alive until it has been printed.
+        Members.release(C);
         if (!ChildOrErr) {
           if (auto E = isNotObjectErrorInvalidFileType(ChildOrErr.takeError()))
             error(std::move(E), Filename, C);
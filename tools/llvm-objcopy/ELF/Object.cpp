@@ -141,6 +141,10 @@ void SectionWriter::visit(const Section &Sec) {
 
 void Section::accept(SectionVisitor &Visitor) const { Visitor.visit(*this); }
 
+bool Section::isUnchangedIn(ArrayRef<uint8_t> Image) const {
+  return Type == SHT_NOBITS || Contents.data() == Image.data() + Offset;
+}
+
 void Section::accept(MutableSectionVisitor &Visitor) { Visitor.visit(*this); }
 
 void SectionWriter::visit(const OwnedDataSection &Sec) {
@@ -1169,6 +1173,7 @@ template <class ELFT> void ELFBuilder<ELFT>::build() {
   Obj.Version = Ehdr.e_version;
   Obj.Entry = Ehdr.e_entry;
   Obj.Flags = Ehdr.e_flags;
+  Obj.OriginalData = makeArrayRef(ElfFile.base(), ElfFile.getBufSize());
 
   readSectionHeaders();
   readProgramHeaders();
@@ -1314,8 +1319,16 @@ template <class ELFT> void ELFWriter<ELFT>::writeShdrs() {
 }
 
 template <class ELFT> void ELFWriter<ELFT>::writeSectionData() {
-  for (auto &Sec : Obj.sections())
+  for (auto &Sec : Obj.sections()) {
+    if (PatchInPlace) {
+      if (Sec.isUnchangedIn(Obj.OriginalData))
+        continue;
+      // The section writers expect to write into zeroed memory.
+      if (Sec.Type != SHT_NOBITS)
+        std::fill_n(Buf.getBufferStart() + Sec.Offset, Sec.Size, 0);
+    }
     Sec.accept(*SecWriter);
+  }
 }
 
 void Object::removeSections(std::function<bool(const SectionBase &)> ToRemove) {
@@ -1489,7 +1502,40 @@ template <class ELFT> size_t ELFWriter<ELFT>::totalSize() const {
          NullSectionSize;
 }
 
+// The output can be patched into a copy of the input if every header, segment
+// and section has the offset and size it had in the input. That holds for edits
+// to headers and symbols, not for ones that add, remove or resize sections.
+template <class ELFT> bool ELFWriter<ELFT>::canPatchInPlace() const {
+  ArrayRef<uint8_t> Input = Obj.OriginalData;
+  if (!WriteSectionHeaders || Input.size() != totalSize())
+    return false;
+  const Elf_Ehdr &Ehdr = *reinterpret_cast<const Elf_Ehdr *>(Input.data());
+  if (Ehdr.e_ident[EI_CLASS] != (ELFT::Is64Bits ? ELFCLASS64 : ELFCLASS32) ||
+      Ehdr.e_ident[EI_DATA] != (ELFT::TargetEndianness == support::big
+                                    ? ELFDATA2MSB
+                                    : ELFDATA2LSB))
+    return false;
+  if (Ehdr.e_shoff != Obj.SHOffset || Ehdr.e_shnum == 0 ||
+      Ehdr.e_shnum != llvm::size(Obj.sections()) + 1 ||
+      Ehdr.e_phnum != llvm::size(Obj.segments()))
+    return false;
+  if (Ehdr.e_phnum != 0 &&
+      Obj.ProgramHdrSegment.Offset != Obj.ProgramHdrSegment.OriginalOffset)
+    return false;
+  for (const Segment &Seg : Obj.segments())
+    if (Seg.Offset != Seg.OriginalOffset)
+      return false;
+  // A section that shrank would leave some of its old contents behind.
+  for (const SectionBase &Sec : Obj.sections())
+    if (Sec.Offset != Sec.OriginalOffset ||
+        (Sec.Type == SHT_NOBITS ? 0 : Sec.Size) != Sec.OriginalData.size())
+      return false;
+  return true;
+}
+
 template <class ELFT> void ELFWriter<ELFT>::write() {
+  if (PatchInPlace)
+    llvm::copy(Obj.OriginalData, Buf.getBufferStart());
   writeEhdr();
   writePhdrs();
   writeSectionData();
@@ -1584,6 +1630,7 @@ template <class ELFT> void ELFWriter<ELFT>::finalize() {
   }
 
   Buf.allocate(totalSize());
+  PatchInPlace = canPatchInPlace();
   SecWriter = llvm::make_unique<ELFSectionWriter<ELFT>>(Buf);
 }
 
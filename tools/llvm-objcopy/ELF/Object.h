@@ -218,8 +218,12 @@ private:
   void writeSectionData();
 
   void assignOffsets();
+  bool canPatchInPlace() const;
 
   std::unique_ptr<ELFSectionWriter<ELFT>> SecWriter;
+  // Whether the output is written as a copy of the input file with only the
+  // headers and the regenerated sections written over it.
+  bool PatchInPlace = false;
 
   size_t totalSize() const;
 
@@ -279,6 +283,8 @@ public:
   virtual void accept(SectionVisitor &Visitor) const = 0;
   virtual void accept(MutableSectionVisitor &Visitor) = 0;
   virtual void markSymbols();
+  // Whether the contents to write are already at Offset in Image.
+  virtual bool isUnchangedIn(ArrayRef<uint8_t> Image) const { return false; }
 };
 
 class Segment {
@@ -338,6 +344,7 @@ public:
   void removeSectionReferences(const SectionBase *Sec) override;
   void initialize(SectionTableRef SecTable) override;
   void finalize() override;
+  bool isUnchangedIn(ArrayRef<uint8_t> Image) const override;
 };
 
 class OwnedDataSection : public SectionBase {
@@ -791,6 +798,8 @@ public:
   uint32_t Machine;
   uint32_t Version;
   uint32_t Flags;
+  // The bytes of the input file, if the object was read from an ELF file.
+  ArrayRef<uint8_t> OriginalData;
 
   StringTableSection *SectionNames = nullptr;
   SymbolTableSection *SymbolTable = nullptr;
@@ -38,6 +38,7 @@
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/ArchiveMemberCache.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/COFFImportFile.h"
 #include "llvm/Object/ELFObjectFile.h"
@@ -2416,9 +2417,13 @@ static void dumpObject(const COFFImportFile *I, const Archive *A,
 
 /// Dump each object file in \a a;
 static void dumpArchive(const Archive *A) {
+  ArchiveMemberCache Members(*A);
+  Members.preload(/*NumThreads=*/0, ArchiveMemberCache::DefaultPreloadWindow);
   Error Err = Error::success();
   for (auto &C : A->children(Err)) {
-    Expected<std::unique_ptr<Binary>> ChildOrErr = C.getAsBinary();
+    Expected<std::shared_ptr<Binary>> ChildOrErr = Members.getMember(C);
+    // ChildOrErr keeps the member alive until it has been printed.
+    Members.release(C);
     if (!ChildOrErr) {
       if (auto E = isNotObjectErrorInvalidFileType(ChildOrErr.takeError()))
         report_error(A->getFileName(), C, std::move(E));
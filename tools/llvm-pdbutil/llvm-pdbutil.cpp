@@ -40,9 +40,11 @@
 #include "llvm/DebugInfo/CodeView/DebugChecksumsSubsection.h"
 #include "llvm/DebugInfo/CodeView/DebugInlineeLinesSubsection.h"
 #include "llvm/DebugInfo/CodeView/DebugLinesSubsection.h"
+#include "llvm/DebugInfo/CodeView/GlobalTypeTableBuilder.h"
 #include "llvm/DebugInfo/CodeView/LazyRandomTypeCollection.h"
 #include "llvm/DebugInfo/CodeView/MergingTypeTableBuilder.h"
 #include "llvm/DebugInfo/CodeView/StringsAndChecksums.h"
+#include "llvm/DebugInfo/CodeView/TypeHashing.h"
 #include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
 #include "llvm/DebugInfo/MSF/MSFBuilder.h"
 #include "llvm/DebugInfo/PDB/IPDBEnumChildren.h"
@@ -90,6 +92,7 @@
 #include "llvm/Support/Regex.h"
 #include "llvm/Support/ScopedPrinter.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -1286,22 +1289,48 @@ static void dumpPretty(StringRef Path) {
 
 static void mergePdbs() {
   BumpPtrAllocator Allocator;
-  MergingTypeTableBuilder MergedTpi(Allocator);
+  GlobalTypeTableBuilder MergedTpi(Allocator);
   MergingTypeTableBuilder MergedIpi(Allocator);
 
-  // Create a Tpi and Ipi type table with all types from all input files.
+  std::vector<std::unique_ptr<IPDBSession>> Sessions;
+  std::vector<PDBFile *> Files;
   for (const auto &Path : opts::merge::InputFilenames) {
-    std::unique_ptr<IPDBSession> Session;
-    auto &File = loadPDB(Path, Session);
-    SmallVector<TypeIndex, 128> TypeMap;
-    SmallVector<TypeIndex, 128> IdMap;
-    if (File.hasPDBTpiStream()) {
-      auto &Tpi = ExitOnErr(File.getPDBTpiStream());
-      ExitOnErr(
-          codeview::mergeTypeRecords(MergedTpi, TypeMap, Tpi.typeArray()));
+    Sessions.emplace_back();
+    Files.push_back(&loadPDB(Path, Sessions.back()));
+  }
+
+  // Create a Tpi type table with all types from all input files. The type
+  // streams are independent of each other, so they are merged in parallel.
+  std::vector<CVTypeArray> TypeArrays;
+  for (PDBFile *File : Files)
+    if (File->hasPDBTpiStream())
+      TypeArrays.push_back(ExitOnErr(File->getPDBTpiStream()).typeArray());
+  std::vector<SmallVector<TypeIndex, 0>> TypeMaps;
+  if (Error E = codeview::mergeTypeRecordsInParallel(
+          MergedTpi, TypeMaps, TypeArrays, hardware_concurrency())) {
+    // Type servers, precompiled headers and forward references need the
+    // serial merger, which also reports the errors of corrupt streams.
+    consumeError(std::move(E));
+    TypeMaps.assign(TypeArrays.size(), {});
+    for (size_t I = 0; I != TypeArrays.size(); ++I) {
+      std::vector<GloballyHashedType> Hashes =
+          GloballyHashedType::hashTypes(TypeArrays[I]);
+      Optional<uint32_t> PCHSignature;
+      ExitOnErr(codeview::mergeTypeRecords(MergedTpi, TypeMaps[I],
+                                           TypeArrays[I], Hashes,
+                                           PCHSignature));
     }
-    if (File.hasPDBIpiStream()) {
-      auto &Ipi = ExitOnErr(File.getPDBIpiStream());
+  }
+
+  // Then create the Ipi type table, which refers to the merged types.
+  size_t NextTypeMap = 0;
+  for (PDBFile *File : Files) {
+    ArrayRef<TypeIndex> TypeMap;
+    if (File->hasPDBTpiStream())
+      TypeMap = TypeMaps[NextTypeMap++];
+    SmallVector<TypeIndex, 128> IdMap;
+    if (File->hasPDBIpiStream()) {
+      auto &Ipi = ExitOnErr(File->getPDBIpiStream());
       ExitOnErr(codeview::mergeIdRecords(MergedIpi, TypeMap, IdMap,
                                          Ipi.typeArray()));
     }
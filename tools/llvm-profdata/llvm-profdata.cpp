@@ -279,6 +279,160 @@ static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
   });
 }
 
+namespace {
+/// A function of one input to a key-ordered merge of indexed profiles.
+struct IndexedMergeKey {
+  /// The name of the function after remapping.
+  StringRef Name;
+  /// The name of the function in the input.
+  StringRef InputName;
+  unsigned Input;
+};
+} // end anonymous namespace
+
+/// Merge indexed profiles into \p WC by walking the functions of all the
+/// inputs in name order. All the records of a function are decoded and merged
+/// on one of \p NumThreads threads before they are handed to the writer, so
+/// there are no per-thread writers to merge afterwards.
+///
+/// \returns false, without merging anything, if some input is not an indexed
+/// profile.
+static bool mergeIndexedInstrProfiles(const WeightedFileVector &Inputs,
+                                      SymbolRemapper *Remapper,
+                                      WriterContext *WC, unsigned NumThreads) {
+  // Only read the magic of each input before committing to this path, so that
+  // the fallback does not read whole inputs a second time. Standard input
+  // cannot be probed without consuming it, so it always takes the fallback.
+  // Leave reporting errors to loadInput.
+  for (const auto &Input : Inputs) {
+    if (Input.Filename == "-")
+      return false;
+    auto MagicOrErr =
+        MemoryBuffer::getFileSlice(Input.Filename, sizeof(uint64_t), 0);
+    if (!MagicOrErr || !IndexedInstrProfReader::hasFormat(*MagicOrErr.get()))
+      return false;
+  }
+
+  std::vector<std::unique_ptr<IndexedInstrProfReader>> Readers;
+  for (const auto &Input : Inputs) {
+    auto ReaderOrErr = IndexedInstrProfReader::create(Input.Filename);
+    if (Error E = ReaderOrErr.takeError()) {
+      WC->Err = std::move(E);
+      WC->ErrWhence = Input.Filename;
+      return true;
+    }
+    Readers.push_back(std::move(ReaderOrErr.get()));
+  }
+
+  std::vector<IndexedMergeKey> Keys;
+  std::vector<StringRef> Names;
+  for (unsigned I = 0; I < Readers.size(); ++I) {
+    if (WC->Writer.setIsIRLevelProfile(Readers[I]->isIRLevelProfile())) {
+      WC->Err = make_error<StringError>(
+          "Merge IR generated profile with Clang generated profile.",
+          std::error_code());
+      WC->ErrWhence = Inputs[I].Filename;
+      return true;
+    }
+    Names.clear();
+    Readers[I]->getFunctionNames(Names);
+    for (StringRef Name : Names)
+      Keys.push_back({Remapper ? (*Remapper)(Name) : Name, Name, I});
+  }
+  std::sort(Keys.begin(), Keys.end(),
+            [](const IndexedMergeKey &L, const IndexedMergeKey &R) {
+              return std::tie(L.Name, L.Input) < std::tie(R.Name, R.Input);
+            });
+
+  // Each function is the range of keys which share a name.
+  std::vector<size_t> FunctionBegins;
+  for (size_t I = 0; I < Keys.size(); ++I)
+    if (I == 0 || Keys[I].Name != Keys[I - 1].Name)
+      FunctionBegins.push_back(I);
+  FunctionBegins.push_back(Keys.size());
+  size_t NumFunctions = FunctionBegins.size() - 1;
+
+  auto mergeFunction = [&](size_t F, std::vector<NamedInstrProfRecord> &Out) {
+    Out.clear();
+    std::vector<NamedInstrProfRecord> Records;
+    for (size_t K = FunctionBegins[F]; K < FunctionBegins[F + 1]; ++K) {
+      const IndexedMergeKey &Key = Keys[K];
+      const WeightedFile &Input = Inputs[Key.Input];
+      if (Error E =
+              Readers[Key.Input]->getFunctionRecords(Key.InputName, Records)) {
+        std::unique_lock<std::mutex> CtxGuard{WC->Lock};
+        if (WC->Err) {
+          consumeError(std::move(E));
+        } else {
+          WC->Err = std::move(E);
+          WC->ErrWhence = Input.Filename;
+        }
+        return;
+      }
+
+      for (NamedInstrProfRecord &Record : Records) {
+        Record.Name = Key.Name;
+        bool Reported = false;
+        auto Warn = [&](instrprof_error IPE) {
+          if (Reported)
+            return;
+          Reported = true;
+          // Only show hint the first time an error occurs.
+          std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
+          bool FirstTime = WC->WriterErrorCodes.insert(IPE).second;
+          handleMergeWriterError(make_error<InstrProfError>(IPE),
+                                 Input.Filename, Key.Name, FirstTime);
+        };
+        auto Dest = llvm::find_if(Out, [&](const NamedInstrProfRecord &R) {
+          return R.Hash == Record.Hash;
+        });
+        if (Dest == Out.end()) {
+          Out.push_back(std::move(Record));
+          if (Input.Weight > 1)
+            Out.back().scale(Input.Weight, Warn);
+        } else {
+          Dest->merge(Record, Input.Weight, Warn);
+        }
+      }
+    }
+    for (NamedInstrProfRecord &Record : Out)
+      Record.sortValueData();
+  };
+
+  // Merge the functions in batches, so that only one batch of merged records
+  // is held outside of the writer at a time.
+  const size_t BatchSize = 4096;
+  std::vector<std::vector<NamedInstrProfRecord>> Merged(
+      std::min(BatchSize, NumFunctions));
+  std::unique_ptr<ThreadPool> Pool;
+  if (NumThreads > 1)
+    Pool = llvm::make_unique<ThreadPool>(NumThreads);
+  for (size_t Begin = 0; Begin < NumFunctions; Begin += BatchSize) {
+    size_t End = std::min(Begin + BatchSize, NumFunctions);
+    if (Pool) {
+      size_t ChunkSize = (End - Begin + NumThreads - 1) / NumThreads;
+      for (size_t Chunk = Begin; Chunk < End; Chunk += ChunkSize)
+        Pool->async([&, Chunk] {
+          for (size_t F = Chunk; F < std::min(Chunk + ChunkSize, End); ++F)
+            mergeFunction(F, Merged[F - Begin]);
+        });
+      Pool->wait();
+    } else {
+      for (size_t F = Begin; F < End; ++F)
+        mergeFunction(F, Merged[F - Begin]);
+    }
+    if (WC->Err)
+      return true;
+
+    // Every function is new to the writer, so adding it cannot warn.
+    for (size_t F = Begin; F < End; ++F)
+      for (NamedInstrProfRecord &Record : Merged[F - Begin])
+        WC->Writer.addRecord(std::move(Record), 1,
+                             [](Error E) { consumeError(std::move(E)); });
+  }
+  return true;
+}
+
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
                               SymbolRemapper *Remapper,
                               StringRef OutputFilename,
@@ -299,48 +453,57 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   std::mutex ErrorLock;
   SmallSet<instrprof_error, 4> WriterErrorCodes;
 
-  // If NumThreads is not specified, auto-detect a good default.
-  if (NumThreads == 0)
-    NumThreads =
-        std::min(hardware_concurrency(), unsigned((Inputs.size() + 1) / 2));
-
-  // Initialize the writer contexts.
   SmallVector<std::unique_ptr<WriterContext>, 4> Contexts;
-  for (unsigned I = 0; I < NumThreads; ++I)
-    Contexts.emplace_back(llvm::make_unique<WriterContext>(
-        OutputSparse, ErrorLock, WriterErrorCodes));
-
-  if (NumThreads == 1) {
-    for (const auto &Input : Inputs)
-      loadInput(Input, Remapper, Contexts[0].get());
-  } else {
-    ThreadPool Pool(NumThreads);
-
-    // Load the inputs in parallel (N/NumThreads serial steps).
-    unsigned Ctx = 0;
-    for (const auto &Input : Inputs) {
-      Pool.async(loadInput, Input, Remapper, Contexts[Ctx].get());
-      Ctx = (Ctx + 1) % NumThreads;
-    }
-    Pool.wait();
-
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
+  Contexts.emplace_back(llvm::make_unique<WriterContext>(
+      OutputSparse, ErrorLock, WriterErrorCodes));
+
+  // Indexed profiles are merged function by function, which spreads the work
+  // across threads even for a few large inputs.
+  if (!mergeIndexedInstrProfiles(Inputs, Remapper, Contexts[0].get(),
+                                 NumThreads ? NumThreads
+                                            : hardware_concurrency())) {
+    // If NumThreads is not specified, auto-detect a good default.
+    if (NumThreads == 0)
+      NumThreads =
+          std::min(hardware_concurrency(), unsigned((Inputs.size() + 1) / 2));
+
+    // Initialize the remaining writer contexts.
+    for (unsigned I = 1; I < NumThreads; ++I)
+      Contexts.emplace_back(llvm::make_unique<WriterContext>(
+          OutputSparse, ErrorLock, WriterErrorCodes));
+
+    if (NumThreads == 1) {
+      for (const auto &Input : Inputs)
+        loadInput(Input, Remapper, Contexts[0].get());
+    } else {
+      ThreadPool Pool(NumThreads);
+
+      // Load the inputs in parallel (N/NumThreads serial steps).
+      unsigned Ctx = 0;
+      for (const auto &Input : Inputs) {
+        Pool.async(loadInput, Input, Remapper, Contexts[Ctx].get());
+        Ctx = (Ctx + 1) % NumThreads;
+      }
       Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
+
+      // Merge the writer contexts together (~ lg(NumThreads) serial steps).
+      unsigned Mid = Contexts.size() / 2;
+      unsigned End = Contexts.size();
+      assert(Mid > 0 && "Expected more than one context");
+      do {
+        for (unsigned I = 0; I < Mid; ++I)
+          Pool.async(mergeWriterContexts, Contexts[I].get(),
+                     Contexts[I + Mid].get());
         Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
+        if (End & 1) {
+          Pool.async(mergeWriterContexts, Contexts[0].get(),
+                     Contexts[End - 1].get());
+          Pool.wait();
+        }
+        End = Mid;
+        Mid /= 2;
+      } while (Mid > 0);
+    }
   }
 
   // Handle deferred hard errors encountered during merging.
@@ -683,6 +846,9 @@ static int showInstrProfile(const std::string &Filename, bool ShowCounts,
     exitWithError(std::move(E), Filename);
 
   auto Reader = std::move(ReaderOrErr.get());
+  // Value profile data is only needed to print it.
+  Reader->setReadValueProfile(TextFormat || ShowIndirectCallTargets ||
+                              ShowMemOPSizes);
   bool IsIRInstr = Reader->isIRLevelProfile();
   size_t ShownFunctions = 0;
   size_t BelowCutoffFunctions = 0;
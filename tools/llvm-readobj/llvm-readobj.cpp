@@ -25,6 +25,7 @@
 #include "WindowsResourceDumper.h"
 #include "llvm/DebugInfo/CodeView/MergingTypeTableBuilder.h"
 #include "llvm/Object/Archive.h"
+#include "llvm/Object/ArchiveMemberCache.h"
 #include "llvm/Object/COFFImportFile.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
@@ -547,9 +548,13 @@ static void dumpObject(const ObjectFile *Obj, ScopedPrinter &Writer) {
 
 /// Dumps each object file in \a Arc;
 static void dumpArchive(const Archive *Arc, ScopedPrinter &Writer) {
+  ArchiveMemberCache Members(*Arc);
+  Members.preload(/*NumThreads=*/0, ArchiveMemberCache::DefaultPreloadWindow);
   Error Err = Error::success();
   for (auto &Child : Arc->children(Err)) {
-    Expected<std::unique_ptr<Binary>> ChildOrErr = Child.getAsBinary();
+    Expected<std::shared_ptr<Binary>> ChildOrErr = Members.getMember(Child);
+    // ChildOrErr keeps the member alive until it has been printed.
+    Members.release(Child);
     if (!ChildOrErr) {
       if (auto E = isNotObjectErrorInvalidFileType(ChildOrErr.takeError())) {
         reportError(Arc->getFileName(), ChildOrErr.takeError());
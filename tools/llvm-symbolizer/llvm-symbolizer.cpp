@@ -15,6 +15,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/DebugInfo/Symbolize/DIPrinter.h"
 #include "llvm/DebugInfo/Symbolize/Symbolize.h"
@@ -24,10 +26,13 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -110,6 +115,26 @@ static cl::opt<int> ClPrintSourceContextLines(
 static cl::opt<bool> ClVerbose("verbose", cl::init(false),
                                cl::desc("Print verbose line info"));
 
+static cl::opt<std::string>
+    ClCacheDir("cache-dir", cl::init(""),
+               cl::desc("Directory used to cache address-to-line tables of "
+                        "binaries with a build ID"));
+
+static cl::opt<bool>
+    ClPrintCacheStats("print-cache-stats", cl::init(false),
+                      cl::desc("Print -cache-dir statistics to stderr on exit"));
+
+static cl::opt<bool>
+    ClBatch("batch", cl::init(false),
+            cl::desc("Read all input before symbolizing. The addresses of each "
+                     "binary are deduplicated and resolved together in "
+                     "address order; output stays in input order"));
+
+static cl::opt<unsigned>
+    ClNumThreads("num-threads", cl::init(0),
+                 cl::desc("Number of threads used to resolve addresses in "
+                          "-batch mode (0 = number of hardware threads)"));
+
 static cl::list<std::string> ClInputAddresses(cl::Positional,
                                               cl::desc("<input addresses>..."),
                                               cl::ZeroOrMore);
@@ -161,6 +186,15 @@ static bool parseCommand(StringRef InputString, bool &IsData,
   return !StringRef(pos, offset_length).getAsInteger(0, ModuleOffset);
 }
 
+static void printAddress(uint64_t ModuleOffset) {
+  if (ClPrintAddress) {
+    outs() << "0x";
+    outs().write_hex(ModuleOffset);
+    StringRef Delimiter = ClPrettyPrint ? ": " : "\n";
+    outs() << Delimiter;
+  }
+}
+
 static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
                            DIPrinter &Printer) {
   bool IsData = false;
@@ -171,12 +205,7 @@ static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
     return;
   }
 
-  if (ClPrintAddress) {
-    outs() << "0x";
-    outs().write_hex(ModuleOffset);
-    StringRef Delimiter = ClPrettyPrint ? ": " : "\n";
-    outs() << Delimiter;
-  }
+  printAddress(ModuleOffset);
   if (IsData) {
     auto ResOrErr = Symbolizer.symbolizeData(ModuleName, ModuleOffset);
     Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
@@ -193,6 +222,75 @@ static void symbolizeInput(StringRef InputString, LLVMSymbolizer &Symbolizer,
   outs().flush();
 }
 
+// Symbolizes all of Inputs, producing the same output as calling
+// symbolizeInput() on each of them.
+static void symbolizeBatch(ArrayRef<std::string> Inputs,
+                           LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
+  struct Query {
+    bool Valid;
+    bool IsData;
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+    // Index of the result in the results of ModuleName.
+    size_t Index;
+  };
+  std::vector<Query> Queries;
+  MapVector<std::string, std::vector<uint64_t>,
+            std::map<std::string, unsigned>>
+      CodeOffsets;
+  for (StringRef Input : Inputs) {
+    Query Q = {false, false, "", 0, 0};
+    Q.Valid = parseCommand(Input, Q.IsData, Q.ModuleName, Q.ModuleOffset);
+    if (Q.Valid && !Q.IsData) {
+      std::vector<uint64_t> &Offsets = CodeOffsets[Q.ModuleName];
+      Q.Index = Offsets.size();
+      Offsets.push_back(Q.ModuleOffset);
+    }
+    Queries.push_back(std::move(Q));
+  }
+
+  unsigned NumThreads =
+      ClNumThreads ? ClNumThreads : llvm::hardware_concurrency();
+  StringMap<std::vector<DILineInfo>> LineInfos;
+  StringMap<std::vector<DIInliningInfo>> InlinedInfos;
+  for (const auto &Entry : CodeOffsets) {
+    const std::string &ModuleName = Entry.first;
+    const std::vector<uint64_t> &Offsets = Entry.second;
+    if (ClPrintInlining) {
+      auto ResOrErr = Symbolizer.symbolizeInlinedCodeBatch(
+          ModuleName, Offsets, ClDwpName, NumThreads);
+      InlinedInfos[ModuleName] =
+          error(ResOrErr) ? std::vector<DIInliningInfo>(Offsets.size())
+                          : std::move(ResOrErr.get());
+    } else {
+      auto ResOrErr = Symbolizer.symbolizeCodeBatch(ModuleName, Offsets,
+                                                    ClDwpName, NumThreads);
+      LineInfos[ModuleName] = error(ResOrErr)
+                                  ? std::vector<DILineInfo>(Offsets.size())
+                                  : std::move(ResOrErr.get());
+    }
+  }
+
+  for (size_t I = 0, E = Queries.size(); I != E; ++I) {
+    const Query &Q = Queries[I];
+    if (!Q.Valid) {
+      outs() << Inputs[I];
+      continue;
+    }
+    printAddress(Q.ModuleOffset);
+    if (Q.IsData) {
+      auto ResOrErr = Symbolizer.symbolizeData(Q.ModuleName, Q.ModuleOffset);
+      Printer << (error(ResOrErr) ? DIGlobal() : ResOrErr.get());
+    } else if (ClPrintInlining) {
+      Printer << InlinedInfos[Q.ModuleName][Q.Index];
+    } else {
+      Printer << LineInfos[Q.ModuleName][Q.Index];
+    }
+    outs() << "\n";
+  }
+  outs().flush();
+}
+
 int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
 
@@ -201,6 +299,7 @@ int main(int argc, char **argv) {
   cl::ParseCommandLineOptions(argc, argv, "llvm-symbolizer\n");
   LLVMSymbolizer::Options Opts(ClPrintFunctions, ClUseSymbolTable, ClDemangle,
                                ClUseRelativeAddress, ClDefaultArch);
+  Opts.CacheDirectory = ClCacheDir;
 
   for (const auto &hint : ClDsymHint) {
     if (sys::path::extension(hint) == ".dSYM") {
@@ -215,7 +314,19 @@ int main(int argc, char **argv) {
   DIPrinter Printer(outs(), ClPrintFunctions != FunctionNameKind::None,
                     ClPrettyPrint, ClPrintSourceContextLines, ClVerbose);
 
-  if (ClInputAddresses.empty()) {
+  if (ClBatch) {
+    std::vector<std::string> Inputs;
+    if (ClInputAddresses.empty()) {
+      const int kMaxInputStringLength = 1024;
+      char InputString[kMaxInputStringLength];
+
+      while (fgets(InputString, sizeof(InputString), stdin))
+        Inputs.push_back(InputString);
+    } else {
+      Inputs.assign(ClInputAddresses.begin(), ClInputAddresses.end());
+    }
+    symbolizeBatch(Inputs, Symbolizer, Printer);
+  } else if (ClInputAddresses.empty()) {
     const int kMaxInputStringLength = 1024;
     char InputString[kMaxInputStringLength];
 
@@ -226,5 +337,15 @@ int main(int argc, char **argv) {
       symbolizeInput(Address, Symbolizer, Printer);
   }
 
+  // Writes the caches that compile units were added to.
+  Symbolizer.flush();
+  if (ClPrintCacheStats) {
+    const LLVMSymbolizer::CacheStats &Stats = Symbolizer.getCacheStats();
+    errs() << "cache hits: " << Stats.Hits << "\n"
+           << "cache misses: " << Stats.Misses << "\n"
+           << "cache writes: " << Stats.Writes << "\n"
+           << "cache errors: " << Stats.Errors << "\n";
+  }
+
   return 0;
 }
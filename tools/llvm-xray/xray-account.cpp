@@ -434,48 +434,55 @@ static CommandRegistration Unused(&Account, []() -> Error {
   llvm::xray::FuncIdConversionHelper FuncIdHelper(AccountInstrMap, Symbolizer,
                                                   FunctionAddresses);
   xray::LatencyAccountant FCA(FuncIdHelper, AccountDeduceSiblingCalls);
-  auto TraceOrErr = loadTraceFile(AccountInput);
-  if (!TraceOrErr)
+  // Account for the records as they are read, rather than loading the whole
+  // trace first.
+  bool AccountingFailed = false;
+  auto HeaderOrErr = streamTraceFile(
+      AccountInput, [&](const XRayRecord &Record) -> Error {
+        if (FCA.accountRecord(Record))
+          return Error::success();
+        errs()
+            << "Error processing record: "
+            << llvm::formatv(
+                   R"({{type: {0}; cpu: {1}; record-type: {2}; function-id: {3}; tsc: {4}; thread-id: {5}; process-id: {6}}})",
+                   Record.RecordType, Record.CPU, Record.Type, Record.FuncId,
+                   Record.TSC, Record.TId, Record.PId)
+            << '\n';
+        for (const auto &ThreadStack : FCA.getPerThreadFunctionStack()) {
+          errs() << "Thread ID: " << ThreadStack.first << "\n";
+          if (ThreadStack.second.empty()) {
+            errs() << "  (empty stack)\n";
+            continue;
+          }
+          auto Level = ThreadStack.second.size();
+          for (const auto &Entry : llvm::reverse(ThreadStack.second))
+            errs() << "  #" << Level-- << "\t"
+                   << FuncIdHelper.SymbolOrNumber(Entry.first) << '\n';
+        }
+        if (AccountKeepGoing)
+          return Error::success();
+        AccountingFailed = true;
+        return make_error<StringError>(
+            Twine("Failed accounting function calls in file '") +
+                AccountInput + "'.",
+            std::make_error_code(std::errc::executable_format_error));
+      });
+  if (!HeaderOrErr) {
+    if (AccountingFailed)
+      return HeaderOrErr.takeError();
     return joinErrors(
         make_error<StringError>(
             Twine("Failed loading input file '") + AccountInput + "'",
             std::make_error_code(std::errc::executable_format_error)),
-        TraceOrErr.takeError());
-
-  auto &T = *TraceOrErr;
-  for (const auto &Record : T) {
-    if (FCA.accountRecord(Record))
-      continue;
-    errs()
-        << "Error processing record: "
-        << llvm::formatv(
-               R"({{type: {0}; cpu: {1}; record-type: {2}; function-id: {3}; tsc: {4}; thread-id: {5}; process-id: {6}}})",
-               Record.RecordType, Record.CPU, Record.Type, Record.FuncId,
-               Record.TSC, Record.TId, Record.PId)
-        << '\n';
-    for (const auto &ThreadStack : FCA.getPerThreadFunctionStack()) {
-      errs() << "Thread ID: " << ThreadStack.first << "\n";
-      if (ThreadStack.second.empty()) {
-        errs() << "  (empty stack)\n";
-        continue;
-      }
-      auto Level = ThreadStack.second.size();
-      for (const auto &Entry : llvm::reverse(ThreadStack.second))
-        errs() << "  #" << Level-- << "\t"
-               << FuncIdHelper.SymbolOrNumber(Entry.first) << '\n';
-    }
-    if (!AccountKeepGoing)
-      return make_error<StringError>(
-          Twine("Failed accounting function calls in file '") + AccountInput +
-              "'.",
-          std::make_error_code(std::errc::executable_format_error));
+        HeaderOrErr.takeError());
   }
+
   switch (AccountOutputFormat) {
   case AccountOutputFormats::TEXT:
-    FCA.exportStatsAsText(OS, T.getFileHeader());
+    FCA.exportStatsAsText(OS, *HeaderOrErr);
     break;
   case AccountOutputFormats::CSV:
-    FCA.exportStatsAsCSV(OS, T.getFileHeader());
+    FCA.exportStatsAsCSV(OS, *HeaderOrErr);
     break;
   }
 
@@ -432,26 +432,17 @@ static CommandRegistration Unused(&GraphDiff, []() -> Error {
         ifSpecified(GraphDiffDeduceSiblingCalls1, GraphDiffDeduceSiblingCalls1A,
                     GraphDiffDeduceSiblingCalls),
         ifSpecified(GraphDiffInstrMap1, GraphDiffInstrMap1A, GraphDiffInstrMap),
-        Trace()},
+        GraphDiffInput1},
        {ifSpecified(GraphDiffKeepGoing2, GraphDiffKeepGoing2A,
                     GraphDiffKeepGoing),
         ifSpecified(GraphDiffDeduceSiblingCalls2, GraphDiffDeduceSiblingCalls2A,
                     GraphDiffDeduceSiblingCalls),
         ifSpecified(GraphDiffInstrMap2, GraphDiffInstrMap2A, GraphDiffInstrMap),
-        Trace()}}};
-
-  std::array<std::string, 2> Inputs{{GraphDiffInput1, GraphDiffInput2}};
+        GraphDiffInput2}}};
 
   std::array<GraphRenderer::GraphT, 2> Graphs;
 
   for (int i = 0; i < 2; i++) {
-    auto TraceOrErr = loadTraceFile(Inputs[i], true);
-    if (!TraceOrErr)
-      return make_error<StringError>(
-          Twine("Failed Loading Input File '") + Inputs[i] + "'",
-          make_error_code(llvm::errc::invalid_argument));
-    Factories[i].Trace = std::move(*TraceOrErr);
-
     auto GraphRendererOrErr = Factories[i].getGraphRenderer();
 
     if (!GraphRendererOrErr)
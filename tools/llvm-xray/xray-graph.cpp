@@ -440,34 +440,50 @@ Expected<GraphRenderer> GraphRenderer::Factory::getGraphRenderer() {
   symbolize::LLVMSymbolizer::Options Opts(
       symbolize::FunctionNameKind::LinkageName, true, true, false, "");
   symbolize::LLVMSymbolizer Symbolizer(Opts);
-  const auto &Header = Trace.getFileHeader();
 
   llvm::xray::FuncIdConversionHelper FuncIdHelper(InstrMap, Symbolizer,
                                                   FunctionAddresses);
 
   xray::GraphRenderer GR(FuncIdHelper, DeduceSiblingCalls);
-  for (const auto &Record : Trace) {
-    auto E = GR.accountRecord(Record);
-    if (!E)
-      continue;
-
-    for (const auto &ThreadStack : GR.getPerThreadFunctionStack()) {
-      errs() << "Thread ID: " << ThreadStack.first << "\n";
-      auto Level = ThreadStack.second.size();
-      for (const auto &Entry : llvm::reverse(ThreadStack.second))
-        errs() << "#" << Level-- << "\t"
-               << FuncIdHelper.SymbolOrNumber(Entry.FuncId) << '\n';
-    }
-
-    if (!GraphKeepGoing)
-      return joinErrors(make_error<StringError>(
-                            "Error encountered generating the call graph.",
-                            std::make_error_code(std::errc::invalid_argument)),
-                        std::move(E));
-
-    handleAllErrors(std::move(E),
-                    [&](const ErrorInfoBase &E) { E.log(errs()); });
+  bool AccountingFailed = false;
+  auto HeaderOrErr = streamTraceFile(
+      Input,
+      [&](const XRayRecord &Record) -> Error {
+        auto E = GR.accountRecord(Record);
+        if (!E)
+          return Error::success();
+
+        for (const auto &ThreadStack : GR.getPerThreadFunctionStack()) {
+          errs() << "Thread ID: " << ThreadStack.first << "\n";
+          auto Level = ThreadStack.second.size();
+          for (const auto &Entry : llvm::reverse(ThreadStack.second))
+            errs() << "#" << Level-- << "\t"
+                   << FuncIdHelper.SymbolOrNumber(Entry.FuncId) << '\n';
+        }
+
+        if (!KeepGoing) {
+          AccountingFailed = true;
+          return joinErrors(
+              make_error<StringError>(
+                  "Error encountered generating the call graph.",
+                  std::make_error_code(std::errc::invalid_argument)),
+              std::move(E));
+        }
+
+        handleAllErrors(std::move(E),
+                        [&](const ErrorInfoBase &E) { E.log(errs()); });
+        return Error::success();
+      },
+      /*Sort=*/true);
+  if (!HeaderOrErr) {
+    if (AccountingFailed)
+      return HeaderOrErr.takeError();
+    consumeError(HeaderOrErr.takeError());
+    return make_error<StringError>(
+        Twine("Failed loading input file '") + Input + "'",
+        make_error_code(llvm::errc::invalid_argument));
   }
+  const auto &Header = *HeaderOrErr;
 
   GR.G.GraphEdgeMax = {};
   GR.G.GraphVertexMax = {};
@@ -495,14 +511,8 @@ static CommandRegistration Unused(&GraphC, []() -> Error {
   F.DeduceSiblingCalls = GraphDeduceSiblingCalls;
   F.InstrMap = GraphInstrMap;
 
-  auto TraceOrErr = loadTraceFile(GraphInput, true);
-
-  if (!TraceOrErr)
-    return make_error<StringError>(
-        Twine("Failed loading input file '") + GraphInput + "'",
-        make_error_code(llvm::errc::invalid_argument));
+  F.Input = GraphInput;
 
-  F.Trace = std::move(*TraceOrErr);
   auto GROrError = F.getGraphRenderer();
   if (!GROrError)
     return GROrError.takeError();
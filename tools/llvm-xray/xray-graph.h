@@ -149,7 +149,8 @@ public:
     bool KeepGoing;
     bool DeduceSiblingCalls;
     std::string InstrMap;
-    ::llvm::xray::Trace Trace;
+    /// The trace file, which is read one record at a time.
+    std::string Input;
     Expected<GraphRenderer> getGraphRenderer();
   };
 
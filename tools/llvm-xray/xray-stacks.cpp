@@ -729,29 +729,33 @@ static CommandRegistration Unused(&Stack, []() -> Error {
   // TODO: Someday, support output to files instead of just directly to
   // standard output.
   for (const auto &Filename : StackInputs) {
-    auto TraceOrErr = loadTraceFile(Filename);
-    if (!TraceOrErr) {
+    StackTrie::AccountRecordState AccountRecordState =
+        StackTrie::AccountRecordState::CreateInitialState();
+    bool AccountingFailed = false;
+    auto HeaderOrErr = streamTraceFile(
+        Filename, [&](const XRayRecord &Record) -> Error {
+          auto error = ST.accountRecord(Record, &AccountRecordState);
+          if (error == StackTrie::AccountRecordStatus::OK)
+            return Error::success();
+          if (!StackKeepGoing) {
+            AccountingFailed = true;
+            return make_error<StringError>(
+                CreateErrorMessage(error, Record, FuncIdHelper),
+                make_error_code(errc::illegal_byte_sequence));
+          }
+          errs() << CreateErrorMessage(error, Record, FuncIdHelper);
+          return Error::success();
+        });
+    if (!HeaderOrErr) {
+      if (AccountingFailed)
+        return HeaderOrErr.takeError();
       if (!StackKeepGoing)
         return joinErrors(
             make_error<StringError>(
                 Twine("Failed loading input file '") + Filename + "'",
                 std::make_error_code(std::errc::invalid_argument)),
-            TraceOrErr.takeError());
-      logAllUnhandledErrors(TraceOrErr.takeError(), errs());
-      continue;
-    }
-    auto &T = *TraceOrErr;
-    StackTrie::AccountRecordState AccountRecordState =
-        StackTrie::AccountRecordState::CreateInitialState();
-    for (const auto &Record : T) {
-      auto error = ST.accountRecord(Record, &AccountRecordState);
-      if (error != StackTrie::AccountRecordStatus::OK) {
-        if (!StackKeepGoing)
-          return make_error<StringError>(
-              CreateErrorMessage(error, Record, FuncIdHelper),
-              make_error_code(errc::illegal_byte_sequence));
-        errs() << CreateErrorMessage(error, Record, FuncIdHelper);
-      }
+            HeaderOrErr.takeError());
+      logAllUnhandledErrors(HeaderOrErr.takeError(), errs());
     }
   }
   if (ST.isEmpty()) {
@@ -970,6 +970,103 @@ TEST_F(ScalarEvolutionsTest, SCEVExitLimitForgetValue) {
   EXPECT_EQ(cast<SCEVConstant>(NewEC)->getAPInt().getLimitedValue(), 1999u);
 }
 
+TEST_F(ScalarEvolutionsTest, SCEVExitLimitForgetValueMultipleLoops) {
+  /*
+   * Create the following code:
+   * func(i64* %arg)
+   * top:
+   *  %load = load i64* %arg
+   *  br label %L1
+   * L1:
+   *  %phi1 = phi i64 [i64 0, %top], [ %add1, %L1 ]
+   *  %add1 = add i64 %phi1, 1
+   *  %cond1 = icmp slt i64 %add1, %load ; then becomes 2000.
+   *  br i1 %cond1, label %L1, label %L2.ph
+   * L2.ph:
+   *  br label %L2
+   * L2:
+   *  %phi2 = phi i64 [i64 0, %L2.ph], [ %add2, %L2 ]
+   *  %add2 = add i64 %phi2, 1
+   *  %cond2 = icmp slt i64 %add2, %load ; then becomes 3000.
+   *  br i1 %cond2, label %L2, label %post
+   * post:
+   *  ret void
+   *
+   * Both backedge-taken counts refer to %load, so forgetting it must drop
+   * both of them.
+   */
+  Type *T_int64 = Type::getInt64Ty(Context);
+  Type *T_pint64 = T_int64->getPointerTo();
+
+  FunctionType *FTy =
+      FunctionType::get(Type::getVoidTy(Context), {T_pint64}, false);
+  Function *F = cast<Function>(M.getOrInsertFunction("foo", FTy));
+
+  Argument *Arg = &*F->arg_begin();
+
+  BasicBlock *Top = BasicBlock::Create(Context, "top", F);
+  BasicBlock *L1 = BasicBlock::Create(Context, "L1", F);
+  BasicBlock *L2Ph = BasicBlock::Create(Context, "L2.ph", F);
+  BasicBlock *L2 = BasicBlock::Create(Context, "L2", F);
+  BasicBlock *Post = BasicBlock::Create(Context, "post", F);
+
+  IRBuilder<> Builder(Top);
+  auto *Load = cast<Instruction>(Builder.CreateLoad(T_int64, Arg, "load"));
+  Builder.CreateBr(L1);
+
+  auto CreateLoop = [&](BasicBlock *Preheader, BasicBlock *Header,
+                        BasicBlock *Exit, Instruction *&Cond,
+                        Instruction *&Add, Instruction *&Br) {
+    Builder.SetInsertPoint(Header);
+    PHINode *Phi = Builder.CreatePHI(T_int64, 2);
+    Add = cast<Instruction>(
+        Builder.CreateAdd(Phi, ConstantInt::get(T_int64, 1), "add"));
+    Cond = cast<Instruction>(
+        Builder.CreateICmp(ICmpInst::ICMP_SLT, Add, Load, "cond"));
+    Br = cast<Instruction>(Builder.CreateCondBr(Cond, Header, Exit));
+    Phi->addIncoming(ConstantInt::get(T_int64, 0), Preheader);
+    Phi->addIncoming(Add, Header);
+  };
+
+  Instruction *Cond1, *Add1, *Br1, *Cond2, *Add2, *Br2;
+  CreateLoop(Top, L1, L2Ph, Cond1, Add1, Br1);
+  CreateLoop(L2Ph, L2, Post, Cond2, Add2, Br2);
+
+  Builder.SetInsertPoint(L2Ph);
+  Builder.CreateBr(L2);
+
+  Builder.SetInsertPoint(Post);
+  Builder.CreateRetVoid();
+
+  ScalarEvolution SE = buildSE(*F);
+  auto *Loop1 = LI->getLoopFor(L1);
+  auto *Loop2 = LI->getLoopFor(L2);
+  EXPECT_FALSE(isa<SCEVConstant>(SE.getBackedgeTakenCount(Loop1)));
+  EXPECT_FALSE(isa<SCEVConstant>(SE.getBackedgeTakenCount(Loop2)));
+
+  SE.forgetValue(Load);
+  auto ReplaceExit = [&](BasicBlock *Header, BasicBlock *Exit,
+                         Instruction *Cond, Instruction *Add, Instruction *Br,
+                         uint64_t Limit) {
+    Br->eraseFromParent();
+    Cond->eraseFromParent();
+    Builder.SetInsertPoint(Header);
+    auto *NewCond = Builder.CreateICmp(
+        ICmpInst::ICMP_SLT, Add, ConstantInt::get(T_int64, Limit), "new.cond");
+    Builder.CreateCondBr(NewCond, Header, Exit);
+  };
+  ReplaceExit(L1, L2Ph, Cond1, Add1, Br1, 2000);
+  ReplaceExit(L2, Post, Cond2, Add2, Br2, 3000);
+  Load->eraseFromParent();
+
+  const SCEV *NewEC1 = SE.getBackedgeTakenCount(Loop1);
+  ASSERT_TRUE(isa<SCEVConstant>(NewEC1));
+  EXPECT_EQ(cast<SCEVConstant>(NewEC1)->getAPInt().getLimitedValue(), 1999u);
+  const SCEV *NewEC2 = SE.getBackedgeTakenCount(Loop2);
+  ASSERT_TRUE(isa<SCEVConstant>(NewEC2));
+  EXPECT_EQ(cast<SCEVConstant>(NewEC2)->getAPInt().getLimitedValue(), 2999u);
+}
+
 TEST_F(ScalarEvolutionsTest, SCEVAddRecFromPHIwithLargeConstants) {
   // Reference: https://reviews.llvm.org/D37265
   // Make sure that SCEV does not blow up when constructing an AddRec
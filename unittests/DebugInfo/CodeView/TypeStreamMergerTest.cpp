@@ -0,0 +1,136 @@
+//===- llvm/unittest/DebugInfo/CodeView/TypeStreamMergerTest.cpp ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/CodeView/TypeStreamMerger.h"
+#include "llvm/DebugInfo/CodeView/AppendingTypeTableBuilder.h"
+#include "llvm/DebugInfo/CodeView/GlobalTypeTableBuilder.h"
+#include "llvm/DebugInfo/CodeView/TypeHashing.h"
+#include "llvm/Support/BinaryStreamReader.h"
+#include "llvm/Testing/Support/Error.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::codeview;
+
+namespace {
+
+/// The type stream of one "object file".
+struct Source {
+  std::vector<uint8_t> Bytes;
+  CVTypeArray Types;
+};
+
+static TypeIndex createPointerRecord(AppendingTypeTableBuilder &Builder,
+                                     TypeIndex TI) {
+  PointerRecord PR(TypeRecordKind::Pointer);
+  PR.setAttrs(PointerKind::Near64, PointerMode::Pointer, PointerOptions::None,
+              8);
+  PR.ReferentType = TI;
+  return Builder.writeLeafType(PR);
+}
+
+static TypeIndex createArgListRecord(AppendingTypeTableBuilder &Builder,
+                                     TypeIndex Q, TypeIndex R) {
+  ArgListRecord AR(TypeRecordKind::ArgList);
+  AR.ArgIndices.push_back(Q);
+  AR.ArgIndices.push_back(R);
+  return Builder.writeLeafType(AR);
+}
+
+// Each source shares some records with the others, in a different order, and
+// adds some of its own.
+static void createSource(unsigned Id, Source &S) {
+  BumpPtrAllocator Alloc;
+  AppendingTypeTableBuilder Builder(Alloc);
+  TypeIndex Int(SimpleTypeKind::Int32);
+  TypeIndex Char(SimpleTypeKind::SignedCharacter);
+  TypeIndex IntP, CharP;
+  if (Id % 2) {
+    IntP = createPointerRecord(Builder, Int);
+    CharP = createPointerRecord(Builder, Char);
+  } else {
+    CharP = createPointerRecord(Builder, Char);
+    IntP = createPointerRecord(Builder, Int);
+  }
+  createArgListRecord(Builder, IntP, CharP);
+  TypeIndex Own = createPointerRecord(
+      Builder, TypeIndex(SimpleTypeKind::Int32, SimpleTypeMode::NearPointer));
+  for (unsigned I = 0; I <= Id % 3; ++I)
+    Own = createPointerRecord(Builder, Own);
+  createArgListRecord(Builder, Own, IntP);
+
+  for (ArrayRef<uint8_t> Record : Builder.records())
+    S.Bytes.insert(S.Bytes.end(), Record.begin(), Record.end());
+  BinaryStreamReader Reader(S.Bytes, support::little);
+  cantFail(Reader.readArray(S.Types, S.Bytes.size()));
+}
+
+TEST(TypeStreamMergerTest, ParallelMergeMatchesSerial) {
+  const unsigned NumSources = 12;
+  std::vector<Source> Sources(NumSources);
+  std::vector<CVTypeArray> Arrays;
+  for (unsigned I = 0; I != NumSources; ++I) {
+    createSource(I, Sources[I]);
+    Arrays.push_back(Sources[I].Types);
+  }
+
+  BumpPtrAllocator SerialAlloc;
+  GlobalTypeTableBuilder Serial(SerialAlloc);
+  std::vector<SmallVector<TypeIndex, 0>> SerialMaps(NumSources);
+  for (unsigned I = 0; I != NumSources; ++I) {
+    std::vector<GloballyHashedType> Hashes =
+        GloballyHashedType::hashTypes(Arrays[I]);
+    Optional<uint32_t> PCHSignature;
+    ASSERT_THAT_ERROR(mergeTypeRecords(Serial, SerialMaps[I], Arrays[I],
+                                       Hashes, PCHSignature),
+                      Succeeded());
+  }
+
+  for (unsigned NumThreads : {1U, 4U}) {
+    BumpPtrAllocator Alloc;
+    GlobalTypeTableBuilder Parallel(Alloc);
+    std::vector<SmallVector<TypeIndex, 0>> Maps;
+    ASSERT_THAT_ERROR(
+        mergeTypeRecordsInParallel(Parallel, Maps, Arrays, NumThreads),
+        Succeeded());
+
+    ASSERT_EQ(Serial.records().size(), Parallel.records().size());
+    for (size_t I = 0; I != Serial.records().size(); ++I) {
+      EXPECT_EQ(Serial.records()[I], Parallel.records()[I]);
+      EXPECT_EQ(Serial.hashes()[I].Hash, Parallel.hashes()[I].Hash);
+    }
+    ASSERT_EQ(SerialMaps.size(), Maps.size());
+    for (unsigned I = 0; I != NumSources; ++I)
+      EXPECT_EQ(SerialMaps[I], Maps[I]);
+  }
+}
+
+TEST(TypeStreamMergerTest, ParallelMergeRejectsForwardReferences) {
+  BumpPtrAllocator Alloc;
+  AppendingTypeTableBuilder Builder(Alloc);
+  // A pointer to the record after it.
+  createPointerRecord(Builder, TypeIndex(TypeIndex::FirstNonSimpleIndex + 1));
+  createPointerRecord(Builder, TypeIndex(SimpleTypeKind::Int32));
+
+  Source S;
+  for (ArrayRef<uint8_t> Record : Builder.records())
+    S.Bytes.insert(S.Bytes.end(), Record.begin(), Record.end());
+  BinaryStreamReader Reader(S.Bytes, support::little);
+  cantFail(Reader.readArray(S.Types, S.Bytes.size()));
+
+  BumpPtrAllocator DestAlloc;
+  GlobalTypeTableBuilder Dest(DestAlloc);
+  std::vector<SmallVector<TypeIndex, 0>> Maps;
+  EXPECT_THAT_ERROR(mergeTypeRecordsInParallel(Dest, Maps, S.Types, 2),
+                    Failed());
+  EXPECT_EQ(0u, Dest.records().size());
+}
+
+} // end anonymous namespace
@@ -220,6 +220,31 @@ TEST(MappedBlockStreamTest, UnalignedOverlappingRead) {
   EXPECT_EQ(7U, F.Allocator.getBytesAllocated());
 }
 
+// Tests that a read is served from an earlier cached request which contains
+// it, even if other cached requests start between the two.
+TEST(MappedBlockStreamTest, OverlappingReadSkipsNonContainingEntries) {
+  DiscontiguousStream F(BlocksAry, DataAry);
+  auto S = MappedBlockStream::createStream(F.block_size(), F.layout(), F,
+                                           F.Allocator);
+  BinaryStreamReader R(*S);
+  StringRef Str1;
+  StringRef Str2;
+  StringRef Str3;
+  R.setOffset(2);
+  EXPECT_THAT_ERROR(R.readFixedString(Str1, 2), Succeeded());
+  EXPECT_EQ(Str1, StringRef("CD"));
+  R.setOffset(0);
+  EXPECT_THAT_ERROR(R.readFixedString(Str2, 7), Succeeded());
+  EXPECT_EQ(Str2, StringRef("ABCDEFG"));
+  EXPECT_EQ(9U, F.Allocator.getBytesAllocated());
+
+  R.setOffset(3);
+  EXPECT_THAT_ERROR(R.readFixedString(Str3, 3), Succeeded());
+  EXPECT_EQ(Str3, StringRef("DEF"));
+  EXPECT_EQ(Str2.data() + 3, Str3.data());
+  EXPECT_EQ(9U, F.Allocator.getBytesAllocated());
+}
+
 // Tests that a read which is not aligned on the same boundary as a previous
 // cached request, but which only partially overlaps a previous cached request,
 // still works correctly and allocates again from the shared pool.
@@ -0,0 +1,166 @@
+//===- TpiStreamTest.cpp - Tests for TPI hash lookups ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/PDB/Native/TpiStream.h"
+#include "llvm/DebugInfo/CodeView/AppendingTypeTableBuilder.h"
+#include "llvm/DebugInfo/CodeView/TypeRecord.h"
+#include "llvm/DebugInfo/MSF/MSFBuilder.h"
+#include "llvm/DebugInfo/MSF/MappedBlockStream.h"
+#include "llvm/DebugInfo/PDB/Native/Hash.h"
+#include "llvm/DebugInfo/PDB/Native/PDBFile.h"
+#include "llvm/DebugInfo/PDB/Native/RawConstants.h"
+#include "llvm/DebugInfo/PDB/Native/TpiHashing.h"
+#include "llvm/DebugInfo/PDB/Native/TpiStreamBuilder.h"
+#include "llvm/Support/BinaryByteStream.h"
+#include "llvm/Support/BinaryStreamWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Testing/Support/Error.h"
+
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace llvm::codeview;
+using namespace llvm::msf;
+using namespace llvm::pdb;
+
+namespace {
+
+TypeIndex addClass(AppendingTypeTableBuilder &Types, TypeRecordKind Kind,
+                   StringRef Name, bool ForwardRef) {
+  ClassOptions Options =
+      ForwardRef ? ClassOptions::ForwardReference : ClassOptions::None;
+  ClassRecord R(Kind, 0, Options, TypeIndex(), TypeIndex(), TypeIndex(),
+                ForwardRef ? 0 : 4, Name, "");
+  return Types.writeLeafType(R);
+}
+
+uint32_t getBucket(StringRef Name) {
+  return hashStringV1(Name) % MinTpiHashBuckets;
+}
+
+class TpiStreamTest : public testing::Test {
+protected:
+  void SetUp() override {
+    ASSERT_FALSE(
+        sys::fs::createTemporaryFile("TpiStreamTest", "pdb", PdbPath));
+    Remover.setFile(PdbPath);
+  }
+
+  /// Writes a PDB that holds only a TPI stream with \p Types. Unless
+  /// \p OutOfRange is none, its hash value is replaced with one that is not a
+  /// bucket.
+  void writePdb(AppendingTypeTableBuilder &Types, TypeIndex OutOfRange) {
+    auto ExpectedMsf = MSFBuilder::create(Allocator, 4096);
+    ASSERT_THAT_EXPECTED(ExpectedMsf, Succeeded());
+    MSFBuilder &Msf = *ExpectedMsf;
+    for (uint32_t I = 0; I <= StreamTPI; ++I) {
+      Expected<uint32_t> Index = Msf.addStream(0);
+      ASSERT_THAT_EXPECTED(Index, Succeeded());
+    }
+
+    TpiStreamBuilder Tpi(Msf, StreamTPI);
+    for (TypeIndex TI = TypeIndex::fromArrayIndex(0);
+         TI.toArrayIndex() < Types.size(); ++TI) {
+      Expected<uint32_t> Hash = hashTypeRecord(Types.getType(TI));
+      ASSERT_THAT_EXPECTED(Hash, Succeeded());
+      Tpi.addTypeRecord(Types.records()[TI.toArrayIndex()], *Hash);
+    }
+    ASSERT_THAT_ERROR(Tpi.finalizeMsfLayout(), Succeeded());
+
+    MSFLayout Layout;
+    auto ExpectedBuffer = Msf.commit(PdbPath, Layout);
+    ASSERT_THAT_EXPECTED(ExpectedBuffer, Succeeded());
+    FileBufferByteStream Buffer = std::move(*ExpectedBuffer);
+    ASSERT_THAT_ERROR(Tpi.commit(Layout, Buffer), Succeeded());
+
+    if (!OutOfRange.isNoneType()) {
+      // The hash values are at the start of the last stream.
+      auto HashStream = WritableMappedBlockStream::createIndexedStream(
+          Layout, Buffer, Layout.StreamSizes.size() - 1, Allocator);
+      BinaryStreamWriter Writer(*HashStream);
+      Writer.setOffset(OutOfRange.toArrayIndex() * sizeof(uint32_t));
+      ASSERT_THAT_ERROR(Writer.writeInteger<uint32_t>(MinTpiHashBuckets + 1),
+                        Succeeded());
+    }
+    ASSERT_THAT_ERROR(Buffer.commit(), Succeeded());
+  }
+
+  TpiStream &loadTpi() {
+    auto MB = MemoryBuffer::getFile(PdbPath);
+    EXPECT_TRUE(bool(MB));
+    auto Stream = llvm::make_unique<MemoryBufferByteStream>(std::move(*MB),
+                                                            support::little);
+    File = llvm::make_unique<PDBFile>(PdbPath, std::move(Stream), Allocator);
+    EXPECT_THAT_ERROR(File->parseFileHeaders(), Succeeded());
+    EXPECT_THAT_ERROR(File->parseStreamData(), Succeeded());
+    return cantFail(File->getPDBTpiStream());
+  }
+
+  BumpPtrAllocator Allocator;
+  SmallString<128> PdbPath;
+  FileRemover Remover;
+  std::unique_ptr<PDBFile> File;
+};
+
+TEST_F(TpiStreamTest, Lookups) {
+  AppendingTypeTableBuilder Types(Allocator);
+  TypeIndex AlphaFwd = addClass(Types, TypeRecordKind::Class, "Alpha", true);
+  TypeIndex Alpha = addClass(Types, TypeRecordKind::Class, "Alpha", false);
+  TypeIndex Beta = addClass(Types, TypeRecordKind::Struct, "Beta", false);
+  TypeIndex BetaFwd = addClass(Types, TypeRecordKind::Struct, "Beta", true);
+  TypeIndex Gamma = addClass(Types, TypeRecordKind::Class, "Gamma", false);
+  TypeIndex GammaFwd = addClass(Types, TypeRecordKind::Class, "Gamma", true);
+  writePdb(Types, TypeIndex());
+
+  // The names are spread over several buckets, and nothing is in the bucket
+  // of "Delta".
+  EXPECT_NE(getBucket("Alpha"), getBucket("Beta"));
+  EXPECT_NE(getBucket("Alpha"), getBucket("Gamma"));
+  EXPECT_NE(getBucket("Beta"), getBucket("Gamma"));
+  TpiStream &Tpi = loadTpi();
+  for (uint32_t HV : Tpi.getHashValues())
+    ASSERT_NE(getBucket("Delta"), HV);
+
+  EXPECT_EQ(std::vector<TypeIndex>({Alpha}), Tpi.findRecordsByName("Alpha"));
+  EXPECT_EQ(std::vector<TypeIndex>({Beta}), Tpi.findRecordsByName("Beta"));
+  EXPECT_EQ(std::vector<TypeIndex>({Gamma}), Tpi.findRecordsByName("Gamma"));
+  EXPECT_TRUE(Tpi.findRecordsByName("Delta").empty());
+  EXPECT_TRUE(Tpi.supportsTypeLookup());
+
+  EXPECT_THAT_EXPECTED(Tpi.findFullDeclForForwardRef(AlphaFwd),
+                       HasValue(Alpha));
+  EXPECT_THAT_EXPECTED(Tpi.findFullDeclForForwardRef(BetaFwd), HasValue(Beta));
+  EXPECT_THAT_EXPECTED(Tpi.findFullDeclForForwardRef(GammaFwd),
+                       HasValue(Gamma));
+  // Full declarations are their own definition.
+  EXPECT_THAT_EXPECTED(Tpi.findFullDeclForForwardRef(Beta), HasValue(Beta));
+}
+
+TEST_F(TpiStreamTest, OutOfRangeHashValue) {
+  AppendingTypeTableBuilder Types(Allocator);
+  TypeIndex Alpha = addClass(Types, TypeRecordKind::Class, "Alpha", false);
+  TypeIndex Gamma = addClass(Types, TypeRecordKind::Class, "Gamma", false);
+  TypeIndex GammaFwd = addClass(Types, TypeRecordKind::Class, "Gamma", true);
+  writePdb(Types, Gamma);
+
+  TpiStream &Tpi = loadTpi();
+  EXPECT_EQ(MinTpiHashBuckets + 1,
+            uint32_t(Tpi.getHashValues()[Gamma.toArrayIndex()]));
+
+  // A record whose hash value is not a bucket can't be found by hash, but the
+  // other records still are.
+  EXPECT_TRUE(Tpi.findRecordsByName("Gamma").empty());
+  EXPECT_THAT_EXPECTED(Tpi.findFullDeclForForwardRef(GammaFwd),
+                       HasValue(GammaFwd));
+  EXPECT_EQ(std::vector<TypeIndex>({Alpha}), Tpi.findRecordsByName("Alpha"));
+}
+
+} // end anonymous namespace
@@ -0,0 +1,129 @@
+//===- ArchiveMemberCacheTest.cpp - Tests for ArchiveMemberCache ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/ArchiveMemberCache.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Testing/Support/Error.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+// Write a GNU archive member with the given name and contents.
+void addMember(raw_ostream &OS, StringRef Name, StringRef Data) {
+  OS << left_justify((Name + "/").str(), 16) << left_justify("0", 12)
+     << left_justify("0", 6) << left_justify("0", 6) << left_justify("644", 8)
+     << left_justify(std::to_string(Data.size()), 10) << "`\n" << Data;
+  if (Data.size() % 2)
+    OS << '\n';
+}
+
+// An archive of two (empty) archives, which createBinary accepts, and a text
+// file, which it does not.
+std::string createArchive() {
+  std::string Result;
+  raw_string_ostream OS(Result);
+  OS << "!<arch>\n";
+  addMember(OS, "first.a", "!<arch>\n");
+  addMember(OS, "notes.txt", "not an object\n");
+  addMember(OS, "second.a", "!<arch>\n");
+  return OS.str();
+}
+
+std::vector<Archive::Child> getChildren(const Archive &A) {
+  std::vector<Archive::Child> Children;
+  Error Err = Error::success();
+  for (const Archive::Child &C : A.children(Err))
+    Children.push_back(C);
+  cantFail(std::move(Err));
+  return Children;
+}
+
+TEST(ArchiveMemberCacheTest, Preload) {
+  std::string Data = createArchive();
+  std::unique_ptr<Archive> A =
+      cantFail(Archive::create(MemoryBufferRef(Data, "test.a")));
+  std::vector<Archive::Child> Children = getChildren(*A);
+  ASSERT_EQ(3u, Children.size());
+
+  ArchiveMemberCache Cache(*A);
+  Cache.preload(4);
+  EXPECT_EQ(2u, Cache.size());
+
+  Expected<std::shared_ptr<Binary>> First = Cache.getMember(Children[0]);
+  ASSERT_THAT_EXPECTED(First, Succeeded());
+  EXPECT_TRUE(isa<Archive>(**First));
+  EXPECT_EQ("first.a", (*First)->getFileName());
+
+  // The parsed member is handed out again rather than parsed twice.
+  Expected<std::shared_ptr<Binary>> Again = Cache.getMember(Children[0]);
+  ASSERT_THAT_EXPECTED(Again, Succeeded());
+  EXPECT_EQ(First->get(), Again->get());
+
+  // Members that failed to parse report their error when they are asked for.
+  EXPECT_THAT_EXPECTED(Cache.getMember(Children[1]), Failed());
+
+  Expected<std::shared_ptr<Binary>> Second = Cache.getMember(Children[2]);
+  ASSERT_THAT_EXPECTED(Second, Succeeded());
+  EXPECT_EQ("second.a", (*Second)->getFileName());
+}
+
+TEST(ArchiveMemberCacheTest, OnDemandAndRelease) {
+  std::string Data = createArchive();
+  std::unique_ptr<Archive> A =
+      cantFail(Archive::create(MemoryBufferRef(Data, "test.a")));
+  std::vector<Archive::Child> Children = getChildren(*A);
+
+  std::shared_ptr<Binary> Kept;
+  {
+    ArchiveMemberCache Cache(*A);
+    EXPECT_EQ(0u, Cache.size());
+    Expected<std::shared_ptr<Binary>> Second = Cache.getMember(Children[2]);
+    ASSERT_THAT_EXPECTED(Second, Succeeded());
+    EXPECT_EQ(1u, Cache.size());
+    Kept = *Second;
+
+    Cache.release(Children[2]);
+    EXPECT_EQ(0u, Cache.size());
+    Expected<std::shared_ptr<Binary>> Reparsed = Cache.getMember(Children[2]);
+    ASSERT_THAT_EXPECTED(Reparsed, Succeeded());
+    EXPECT_NE(Kept.get(), Reparsed->get());
+  }
+  // Outlives the cache.
+  EXPECT_EQ("second.a", Kept->getFileName());
+}
+
+TEST(ArchiveMemberCacheTest, PreloadWindow) {
+  std::string Data = createArchive();
+  std::unique_ptr<Archive> A =
+      cantFail(Archive::create(MemoryBufferRef(Data, "test.a")));
+  std::vector<Archive::Child> Children = getChildren(*A);
+
+  ArchiveMemberCache Cache(*A);
+  Cache.preload(1, /*Window=*/1);
+  EXPECT_EQ(1u, Cache.size());
+  ASSERT_THAT_EXPECTED(Cache.getMember(Children[0]), Succeeded());
+  Cache.release(Children[0]);
+  EXPECT_EQ(0u, Cache.size());
+
+  // Asking for the second member parses the next window, which only holds
+  // the member that fails to parse.
+  EXPECT_THAT_EXPECTED(Cache.getMember(Children[1]), Failed());
+  EXPECT_EQ(0u, Cache.size());
+
+  Expected<std::shared_ptr<Binary>> Second = Cache.getMember(Children[2]);
+  ASSERT_THAT_EXPECTED(Second, Succeeded());
+  EXPECT_EQ("second.a", (*Second)->getFileName());
+  EXPECT_EQ(1u, Cache.size());
+}
+
+} // end anonymous namespace
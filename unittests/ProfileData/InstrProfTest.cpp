@@ -139,6 +139,57 @@ TEST_P(MaybeSparseInstrProfTest, get_function_counts) {
   ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, std::move(E2)));
 }
 
+TEST_P(MaybeSparseInstrProfTest, get_function_counts_view) {
+  Writer.addRecord({"foo", 0x1234, {1, 2}}, Err);
+  Writer.addRecord({"foo", 0x1235, {3, 4, 5}}, Err);
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  Expected<ArrayRef<support::ulittle64_t>> View =
+      Reader->getFunctionCountsView("foo", 0x1235);
+  EXPECT_THAT_ERROR(View.takeError(), Succeeded());
+  ASSERT_EQ(3U, View->size());
+  ASSERT_EQ(3U, (*View)[0]);
+  ASSERT_EQ(5U, (*View)[2]);
+
+  Expected<ArrayRef<support::ulittle64_t>> E1 =
+      Reader->getFunctionCountsView("foo", 0x5678);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::hash_mismatch, E1.takeError()));
+}
+
+TEST_P(MaybeSparseInstrProfTest, get_function_records) {
+  static const char Callee[] = "callee";
+  NamedInstrProfRecord Record1("foo", 0x1234, {1, 2});
+  Record1.reserveSites(IPVK_IndirectCallTarget, 1);
+  InstrProfValueData VD0[] = {{(uint64_t)Callee, 1}};
+  Record1.addValueData(IPVK_IndirectCallTarget, 0, VD0, 1, nullptr);
+  Writer.addRecord(std::move(Record1), Err);
+  Writer.addRecord({"foo", 0x1235, {3, 4}}, Err);
+  auto Profile = Writer.writeBuffer();
+  readProfile(std::move(Profile));
+
+  std::vector<StringRef> Names;
+  Reader->getFunctionNames(Names);
+  ASSERT_EQ(1U, Names.size());
+  ASSERT_EQ(StringRef("foo"), Names[0]);
+
+  std::vector<NamedInstrProfRecord> Records;
+  EXPECT_THAT_ERROR(Reader->getFunctionRecords("foo", Records), Succeeded());
+  ASSERT_EQ(2U, Records.size());
+  std::sort(Records.begin(), Records.end(),
+            [](const NamedInstrProfRecord &L, const NamedInstrProfRecord &R) {
+              return L.Hash < R.Hash;
+            });
+  ASSERT_EQ(StringRef("foo"), Records[0].Name);
+  ASSERT_EQ(2U, Records[0].Counts[1]);
+  ASSERT_EQ(1U, Records[0].getNumValueSites(IPVK_IndirectCallTarget));
+  ASSERT_EQ(0x1235U, Records[1].Hash);
+  ASSERT_EQ(0U, Records[1].getNumValueSites(IPVK_IndirectCallTarget));
+
+  Error E1 = Reader->getFunctionRecords("bar", Records);
+  ASSERT_TRUE(ErrorEquals(instrprof_error::unknown_function, std::move(E1)));
+}
+
 // Profile data is copied from general.proftext
 TEST_F(InstrProfTest, get_profile_summary) {
   Writer.addRecord({"func1", 0x1234, {97531}}, Err);
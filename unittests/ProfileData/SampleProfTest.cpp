@@ -10,6 +10,8 @@
 #include "llvm/ProfileData/SampleProf.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
@@ -51,6 +53,16 @@ struct SampleProfTest : ::testing::Test {
     Writer = std::move(WriterOrErr.get());
   }
 
+  /// Add a function named \p Name to \p M, with a trivial body if \p Define
+  /// is set.
+  void addFunction(Module &M, StringRef Name, bool Define) {
+    FunctionType *fn_type =
+        FunctionType::get(Type::getVoidTy(Context), {}, false);
+    auto *F = cast<Function>(M.getOrInsertFunction(Name, fn_type));
+    if (Define)
+      ReturnInst::Create(Context, BasicBlock::Create(Context, "entry", F));
+  }
+
   void readProfile(const Module &M, StringRef Profile) {
     auto ReaderOrErr = SampleProfileReader::create(Profile, Context);
     ASSERT_TRUE(NoError(ReaderOrErr.getError()));
@@ -88,10 +100,8 @@ struct SampleProfTest : ::testing::Test {
     BarSamples.addCalledTargetSamples(1, 0, StringviewName, 437);
 
     Module M("my_module", Context);
-    FunctionType *fn_type =
-        FunctionType::get(Type::getVoidTy(Context), {}, false);
-    M.getOrInsertFunction(FooName, fn_type);
-    M.getOrInsertFunction(BarName, fn_type);
+    addFunction(M, FooName, /*Define=*/true);
+    addFunction(M, BarName, /*Define=*/true);
 
     StringMap<FunctionSamples> Profiles;
     Profiles[FooName] = std::move(FooSamples);
@@ -214,6 +224,41 @@ TEST_F(SampleProfTest, roundtrip_compact_binary_profile) {
   testRoundTrip(SampleProfileFormat::SPF_Compact_Binary, false);
 }
 
+TEST_F(SampleProfTest, compact_binary_reads_module_functions) {
+  SmallVector<char, 128> ProfilePath;
+  ASSERT_TRUE(NoError(
+      llvm::sys::fs::createTemporaryFile("profile", "", ProfilePath)));
+  StringRef Profile(ProfilePath.data(), ProfilePath.size());
+  createWriter(SampleProfileFormat::SPF_Compact_Binary, Profile);
+
+  StringMap<FunctionSamples> Profiles;
+  for (StringRef Name : {"_Z3fooi", "_Z3bari", "_Z3bazi"}) {
+    FunctionSamples &Samples = Profiles[Name];
+    Samples.setName(Name);
+    Samples.addHeadSamples(1);
+    Samples.addBodySamples(1, 0, 1);
+  }
+  ASSERT_TRUE(NoError(Writer->write(Profiles)));
+  Writer->getOutputStream().flush();
+
+  // Only the profile of the function defined in the module is read.
+  Module M("my_module", Context);
+  addFunction(M, "_Z3fooi", /*Define=*/true);
+  addFunction(M, "_Z3bari", /*Define=*/false);
+  readProfile(M, Profile);
+  ASSERT_TRUE(NoError(Reader->read()));
+  ASSERT_EQ(1u, Reader->getProfiles().size());
+  ASSERT_TRUE(Reader->getSamplesFor("_Z3fooi") != nullptr);
+  ASSERT_TRUE(Reader->getSamplesFor("_Z3bari") == nullptr);
+
+  // Without a module to compile, every profile is read.
+  auto ReaderOrErr = SampleProfileReader::create(Profile, Context);
+  ASSERT_TRUE(NoError(ReaderOrErr.getError()));
+  Reader = std::move(ReaderOrErr.get());
+  ASSERT_TRUE(NoError(Reader->read()));
+  ASSERT_EQ(3u, Reader->getProfiles().size());
+}
+
 TEST_F(SampleProfTest, remap_text_profile) {
   testRoundTrip(SampleProfileFormat::SPF_Text, true);
 }
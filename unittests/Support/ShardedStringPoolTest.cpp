@@ -0,0 +1,79 @@
+//===- llvm/unittest/Support/ShardedStringPoolTest.cpp --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ShardedStringPool.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(ShardedStringPoolTest, Uniquing) {
+  ShardedStringPool Pool(4);
+  std::string Foo = "foo";
+  StringRef A = Pool.intern(Foo);
+  StringRef B = Pool.intern("foo");
+  EXPECT_EQ(A.data(), B.data());
+  EXPECT_NE(A.data(), Foo.data());
+  Pool.intern("bar");
+  EXPECT_EQ(2u, Pool.size());
+}
+
+TEST(ShardedStringPoolTest, Layout) {
+  ShardedStringPool Pool;
+  Pool.intern("zeta");
+  Pool.intern("");
+  Pool.intern("alpha");
+  Pool.intern("zeta");
+  Pool.finalize();
+
+  ASSERT_EQ(3u, Pool.getStrings().size());
+  EXPECT_EQ(0u, Pool.getOffset(""));
+  EXPECT_EQ(1u, Pool.getOffset("alpha"));
+  EXPECT_EQ(7u, Pool.getOffset("zeta"));
+  EXPECT_EQ(12u, Pool.getSize());
+
+  std::string Table;
+  raw_string_ostream OS(Table);
+  Pool.write(OS);
+  EXPECT_EQ(std::string("\0alpha\0zeta\0", 12), OS.str());
+}
+
+TEST(ShardedStringPoolTest, Concurrent) {
+  const unsigned NumThreads = 4;
+  const unsigned NumStrings = 1000;
+  ShardedStringPool Pool(8);
+  {
+    ThreadPool Threads(NumThreads);
+    // Every thread interns every string, starting at a different point.
+    for (unsigned T = 0; T != NumThreads; ++T)
+      Threads.async([&Pool, T] {
+        for (unsigned I = 0; I != NumStrings; ++I)
+          Pool.intern(("s" + Twine((I + T * 250) % NumStrings)).str());
+      });
+    Threads.wait();
+  }
+  Pool.finalize();
+  EXPECT_EQ(NumStrings, Pool.getStrings().size());
+
+  // The layout does not depend on the order of insertion.
+  ShardedStringPool Serial(1);
+  for (unsigned I = NumStrings; I != 0; --I)
+    Serial.intern(("s" + Twine(I - 1)).str());
+  Serial.finalize();
+  EXPECT_EQ(Serial.getSize(), Pool.getSize());
+  for (StringRef S : Serial.getStrings())
+    EXPECT_EQ(Serial.getOffset(S), Pool.getOffset(S));
+}
+
+} // end anonymous namespace
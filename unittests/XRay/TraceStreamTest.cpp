@@ -0,0 +1,140 @@
+//===- llvm/unittest/XRay/TraceStreamTest.cpp -------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Test that streaming the records of an XRay trace yields the same records as
+// loading the whole trace.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Testing/Support/Error.h"
+#include "llvm/XRay/FDRLogBuilder.h"
+#include "llvm/XRay/FDRRecords.h"
+#include "llvm/XRay/FDRTraceWriter.h"
+#include "llvm/XRay/Trace.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <tuple>
+
+namespace llvm {
+namespace xray {
+namespace {
+
+using testing::ElementsAreArray;
+using testing::Eq;
+using testing::SizeIs;
+
+// Writes a version 3 log with three threads of two buffers each. The buffers
+// of the threads are interleaved, and those of thread 2 are written out of
+// wallclock order.
+std::string createLog() {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  XRayFileHeader H;
+  H.Version = 3;
+  H.Type = 1;
+  H.ConstantTSC = true;
+  H.NonstopTSC = true;
+  H.CycleFrequency = 3e9;
+  FDRTraceWriter Writer(OS, H);
+  const std::pair<int32_t, int> Buffers[] = {{1, 0}, {2, 1}, {3, 0},
+                                             {1, 1}, {2, 0}, {3, 1}};
+  for (const auto &B : Buffers) {
+    int32_t TID = B.first;
+    uint64_t BaseTSC = 1000 * (B.second + 1) + 10 * TID;
+    auto L = LogBuilder()
+                 .add<BufferExtents>(80)
+                 .add<NewBufferRecord>(TID)
+                 .add<WallclockRecord>(B.second + 1, B.second + 1)
+                 .add<PIDRecord>(1)
+                 .add<NewCPUIDRecord>(TID, BaseTSC)
+                 .add<FunctionRecord>(RecordTypes::ENTER, TID, 1)
+                 .add<FunctionRecord>(RecordTypes::EXIT, TID, 100)
+                 .consume();
+    for (auto &P : L)
+      EXPECT_FALSE(errorToBool(P->apply(Writer)));
+  }
+  OS.flush();
+  return Data;
+}
+
+using RecordKey = std::tuple<uint64_t, uint32_t, int32_t, RecordTypes>;
+
+RecordKey getKey(const XRayRecord &R) {
+  return std::make_tuple(R.TSC, R.TId, R.FuncId, R.Type);
+}
+
+std::vector<RecordKey> loadKeys(const DataExtractor &DE, bool Sort) {
+  std::vector<RecordKey> Keys;
+  auto TraceOrErr = loadTrace(DE, Sort);
+  EXPECT_THAT_EXPECTED(TraceOrErr, Succeeded());
+  if (TraceOrErr)
+    for (const XRayRecord &R : *TraceOrErr)
+      Keys.push_back(getKey(R));
+  return Keys;
+}
+
+TEST(TraceStreamTest, SameOrderAsLoadTrace) {
+  std::string Data = createLog();
+  DataExtractor DE(Data, sys::IsLittleEndianHost, 8);
+  std::vector<RecordKey> Expected = loadKeys(DE, false);
+  ASSERT_THAT(Expected, SizeIs(12u));
+
+  for (unsigned NumThreads : {1u, 4u}) {
+    std::vector<RecordKey> Keys;
+    auto HeaderOrErr = streamTrace(
+        DE,
+        [&](const XRayRecord &R) {
+          Keys.push_back(getKey(R));
+          return Error::success();
+        },
+        /*Sort=*/false, NumThreads);
+    ASSERT_THAT_EXPECTED(HeaderOrErr, Succeeded());
+    EXPECT_THAT(HeaderOrErr->Version, Eq(3));
+    EXPECT_THAT(Keys, ElementsAreArray(Expected));
+  }
+}
+
+TEST(TraceStreamTest, SortedByTSC) {
+  std::string Data = createLog();
+  DataExtractor DE(Data, sys::IsLittleEndianHost, 8);
+  std::vector<RecordKey> Keys;
+  auto HeaderOrErr = streamTrace(
+      DE,
+      [&](const XRayRecord &R) {
+        Keys.push_back(getKey(R));
+        return Error::success();
+      },
+      /*Sort=*/true);
+  ASSERT_THAT_EXPECTED(HeaderOrErr, Succeeded());
+  EXPECT_THAT(Keys, ElementsAreArray(loadKeys(DE, true)));
+}
+
+TEST(TraceStreamTest, StopsAtCallbackError) {
+  std::string Data = createLog();
+  DataExtractor DE(Data, sys::IsLittleEndianHost, 8);
+  for (unsigned NumThreads : {1u, 4u}) {
+    unsigned Seen = 0;
+    auto HeaderOrErr = streamTrace(
+        DE,
+        [&](const XRayRecord &) -> Error {
+          if (++Seen < 5)
+            return Error::success();
+          return createStringError(
+              std::make_error_code(std::errc::interrupted), "stop");
+        },
+        /*Sort=*/false, NumThreads);
+    EXPECT_THAT_EXPECTED(HeaderOrErr, Failed());
+    EXPECT_THAT(Seen, Eq(5u));
+  }
+}
+
+} // namespace
+} // namespace xray
+} // namespace llvm
@@ -28,6 +28,40 @@ TEST(ScratchSpaceTest, Works) {
   EXPECT_EQ(Space.ptr()[BenchmarkRunner::ScratchSpace::kSize - 1], 0);
 }
 
+TEST(ExecutableMemoryPoolTest, ReusesReleasedBlocks) {
+  using Purpose = llvm::SectionMemoryManager::AllocationPurpose;
+  const unsigned ReadWrite =
+      llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE;
+  ExecutableMemoryPool Pool;
+  std::error_code EC;
+  llvm::sys::MemoryBlock First =
+      Pool.allocateMappedMemory(Purpose::Code, 100, nullptr, ReadWrite, EC);
+  ASSERT_FALSE(EC);
+  ASSERT_NE(First.base(), nullptr);
+  void *const FirstBase = First.base();
+  const size_t FirstSize = First.size();
+  ASSERT_FALSE(Pool.protectMappedMemory(
+      First, llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_EXEC));
+  ASSERT_FALSE(Pool.releaseMappedMemory(First));
+
+  // The released block is handed out again, and is writable.
+  llvm::sys::MemoryBlock Second =
+      Pool.allocateMappedMemory(Purpose::Code, 50, nullptr, ReadWrite, EC);
+  ASSERT_FALSE(EC);
+  EXPECT_EQ(Second.base(), FirstBase);
+  static_cast<char *>(Second.base())[0] = 42;
+
+  // Blocks that are too small are not.
+  llvm::sys::MemoryBlock Third = Pool.allocateMappedMemory(
+      Purpose::Code, 2 * FirstSize, nullptr, ReadWrite, EC);
+  ASSERT_FALSE(EC);
+  EXPECT_NE(Third.base(), FirstBase);
+  EXPECT_GE(Third.size(), 2 * FirstSize);
+
+  EXPECT_FALSE(Pool.releaseMappedMemory(Second));
+  EXPECT_FALSE(Pool.releaseMappedMemory(Third));
+}
+
 } // namespace
 } // namespace exegesis
 } // namespace llvm
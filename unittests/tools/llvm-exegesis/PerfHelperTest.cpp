@@ -43,6 +43,21 @@ TEST(PerfHelperTest, FunctionalTest) {
 #endif
 }
 
+TEST(PerfHelperTest, CounterCache) {
+  CounterCache Cache;
+#ifdef HAVE_LIBPFM
+  ASSERT_FALSE(pfmInitialize());
+  Counter *const Cycles = Cache.getCounter("CYCLES:u");
+  ASSERT_NE(Cycles, nullptr);
+  // The counter is opened once.
+  EXPECT_EQ(Cache.getCounter("CYCLES:u"), Cycles);
+  EXPECT_EQ(Cache.getCounter("NOT_AN_EVENT"), nullptr);
+  pfmTerminate();
+#else
+  EXPECT_EQ(Cache.getCounter("CYCLES:u"), nullptr);
+#endif
+}
+
 } // namespace
 } // namespace pfm
 } // namespace exegesis
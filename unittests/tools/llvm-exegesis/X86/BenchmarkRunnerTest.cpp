@@ -0,0 +1,98 @@
+//===-- BenchmarkRunnerTest.cpp ---------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BenchmarkRunner.h"
+#include "LlvmState.h"
+#include "X86InstrInfo.h"
+#include "llvm/MC/MCInstBuilder.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace llvm {
+namespace exegesis {
+
+void InitializeX86ExegesisTarget();
+
+namespace {
+
+// Assembles and loads the snippets like the real runners, but does not read
+// any perf counter.
+class FakeBenchmarkRunner : public BenchmarkRunner {
+public:
+  FakeBenchmarkRunner(const LLVMState &State)
+      : BenchmarkRunner(State, InstructionBenchmark::Latency) {}
+
+private:
+  llvm::Expected<std::vector<BenchmarkMeasure>>
+  runMeasurements(const FunctionExecutor &) const override {
+    return std::vector<BenchmarkMeasure>{BenchmarkMeasure::Create("fake", 1)};
+  }
+};
+
+class X86BenchmarkRunnerTest : public ::testing::Test {
+protected:
+  X86BenchmarkRunnerTest() : State("x86_64-unknown-linux", "haswell") {}
+
+  static void SetUpTestCase() {
+    LLVMInitializeX86TargetInfo();
+    LLVMInitializeX86TargetMC();
+    LLVMInitializeX86Target();
+    LLVMInitializeX86AsmPrinter();
+    InitializeX86ExegesisTarget();
+  }
+
+  const LLVMState State;
+};
+
+#if defined(__linux__)
+TEST_F(X86BenchmarkRunnerTest, RunConfigurationsOnSeveralWorkers) {
+  if (llvm::Triple(llvm::sys::getProcessTriple()).getArch() !=
+      llvm::Triple::x86_64)
+    return;
+  std::vector<BenchmarkCode> Configurations(6);
+  std::vector<std::string> Expected;
+  for (size_t I = 0; I < Configurations.size(); ++I) {
+    Configurations[I].Instructions = {
+        MCInstBuilder(X86::MOV32ri).addReg(X86::EAX).addImm(I)};
+    Configurations[I].Info = "config " + std::to_string(I);
+    Expected.push_back(Configurations[I].Info);
+  }
+
+  // Two workers pinned to the cpu we are running on, which is available.
+  const int Cpu = sched_getcpu();
+  ASSERT_GE(Cpu, 0);
+  const FakeBenchmarkRunner Runner(State);
+  std::vector<std::string> Infos;
+  if (llvm::Error E = Runner.runConfigurations(
+          Configurations, /*NumRepetitions=*/100,
+          {static_cast<unsigned>(Cpu), static_cast<unsigned>(Cpu)},
+          [&Infos](InstructionBenchmark &Result) {
+            EXPECT_EQ(Result.Error, "");
+            EXPECT_EQ(Result.Measurements.size(), 1u);
+            Infos.push_back(Result.Info);
+            return llvm::Error::success();
+          }))
+    FAIL() << llvm::toString(std::move(E));
+  // The results are consumed in the order of the configurations.
+  EXPECT_EQ(Infos, Expected);
+}
+#endif
+
+} // namespace
+} // namespace exegesis
+} // namespace llvm